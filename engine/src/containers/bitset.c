@@ -0,0 +1,213 @@
+#include "bitset.h"
+
+#include "core/memory.h"
+#include "core/log.h"
+
+// Fills in the summary level sizes for bit_count bits. Returns the words all
+// levels take together, per summary.
+static u32 get_levels(
+    u32 bit_count, u32* out_word_counts, u32* out_offsets, u32* out_level_count
+) {
+    u32 entries = (bit_count + 63) / 64;
+    u32 total = 0;
+    u32 level_count = 0;
+    while (entries > 1) {
+        entries = (entries + 63) / 64;
+        out_word_counts[level_count] = entries;
+        out_offsets[level_count] = total;
+        total += entries;
+        level_count++;
+    }
+    *out_level_count = level_count;
+    return total;
+}
+
+// Bits of a word that are part of the set. Only the last can be partial.
+static u64 get_valid_mask(bitset* set, u32 word_index) {
+    u32 tail = set->bit_count & 63;
+    if (word_index == set->word_count - 1 && tail) {
+        return (1ULL << tail) - 1;
+    }
+    return ~0ULL;
+}
+
+// Entries at a level. Level -1 stands for the words themselves.
+static u32 get_level_bits(bitset* set, i32 level) {
+    if (level < 0) {
+        return set->bit_count;
+    }
+    return level == 0 ? set->word_count : set->level_word_counts[level - 1];
+}
+
+// Word of a level with a bit per entry that matches, set or clear.
+static u64 get_level_word(bitset* set, i32 level, u32 index, b8 want_set) {
+    if (level < 0) {
+        u64 word = set->words[index];
+        return want_set ? word : ~word & get_valid_mask(set, index);
+    }
+    u64* summary = want_set ? set->any_set : set->any_clear;
+    return summary[set->level_offsets[level] + index];
+}
+
+// First matching entry of a level at or after index, INVALID_ID if none.
+// Past the word holding index, the level above says which word to read next.
+static u32 find_next(bitset* set, i32 level, u32 index, b8 want_set) {
+    if (index >= get_level_bits(set, level)) {
+        return INVALID_ID;
+    }
+    u64 word = get_level_word(set, level, index / 64, want_set) &
+               (~0ULL << (index & 63));
+    if (word) {
+        return (index & ~63u) + __builtin_ctzll(word);
+    }
+    if (level == (i32)set->level_count - 1) {
+        // Top level, a single word.
+        return INVALID_ID;
+    }
+
+    u32 word_index = find_next(set, level + 1, index / 64 + 1, want_set);
+    if (word_index == INVALID_ID) {
+        return INVALID_ID;
+    }
+    word = get_level_word(set, level, word_index, want_set);
+    return word_index * 64 + __builtin_ctzll(word);
+}
+
+// Brings the summaries in line with a changed word. Stops at the first level
+// where the word above keeps the same state.
+static void update_summaries(bitset* set, u32 word_index) {
+    u64 word = set->words[word_index];
+    b8 has_set = word != 0;
+    b8 has_clear = word != get_valid_mask(set, word_index);
+    u32 index = word_index;
+    for (u32 level = 0; level < set->level_count; ++level) {
+        u32 summary_index = set->level_offsets[level] + index / 64;
+        u64 bit = 1ULL << (index & 63);
+        u64* any_set = &set->any_set[summary_index];
+        u64* any_clear = &set->any_clear[summary_index];
+        b8 had_set = *any_set != 0;
+        b8 had_clear = *any_clear != 0;
+        *any_set = has_set ? *any_set | bit : *any_set & ~bit;
+        *any_clear = has_clear ? *any_clear | bit : *any_clear & ~bit;
+
+        has_set = *any_set != 0;
+        has_clear = *any_clear != 0;
+        if (had_set == has_set && had_clear == has_clear) {
+            break;
+        }
+        index /= 64;
+    }
+}
+
+u64 bitset_get_memory_requirement(u32 bit_count) {
+    u32 word_counts[BITSET_MAX_LEVELS];
+    u32 offsets[BITSET_MAX_LEVELS];
+    u32 level_count;
+    u32 summary_words = get_levels(bit_count, word_counts, offsets, &level_count);
+    u32 word_count = (bit_count + 63) / 64;
+    return (word_count + summary_words * 2) * sizeof(u64);
+}
+
+b8 bitset_create(u32 bit_count, void* memory, bitset* out_set) {
+    if (!out_set || !bit_count || bit_count == INVALID_ID) {
+        OKO_ERROR(
+            "bitset_create requires out_set and a bit_count between 1 and %u.",
+            INVALID_ID - 1
+        );
+        return false;
+    }
+
+    memory_zero(out_set, sizeof(bitset));
+    u64 size = bitset_get_memory_requirement(bit_count);
+    out_set->owns_memory = memory == 0;
+    if (!memory) {
+        memory = memory_allocate(size, MEMORY_TAG_ARRAY);
+        if (!memory) {
+            OKO_ERROR("bitset_create - failed to allocate %llu bytes.", size);
+            return false;
+        }
+    }
+
+    out_set->bit_count = bit_count;
+    out_set->word_count = (bit_count + 63) / 64;
+    u32 summary_words = get_levels(
+        bit_count,
+        out_set->level_word_counts,
+        out_set->level_offsets,
+        &out_set->level_count
+    );
+    out_set->words = memory;
+    out_set->any_set = out_set->words + out_set->word_count;
+    out_set->any_clear = out_set->any_set + summary_words;
+    memory_zero(memory, size);
+
+    // Every entry has a clear bit below it.
+    for (u32 level = 0; level < out_set->level_count; ++level) {
+        u32 entries = get_level_bits(out_set, level);
+        u64* summary = out_set->any_clear + out_set->level_offsets[level];
+        memory_set(summary, 0xFF, (entries / 64) * sizeof(u64));
+        if (entries & 63) {
+            summary[entries / 64] = (1ULL << (entries & 63)) - 1;
+        }
+    }
+    return true;
+}
+
+void bitset_destroy(bitset* set) {
+    if (set) {
+        if (set->owns_memory && set->words) {
+            memory_free(
+                set->words,
+                bitset_get_memory_requirement(set->bit_count),
+                MEMORY_TAG_ARRAY
+            );
+        }
+        memory_zero(set, sizeof(bitset));
+    }
+}
+
+void bitset_set(bitset* set, u32 index) {
+    u64 bit = 1ULL << (index & 63);
+    u64* word = &set->words[index / 64];
+    if (!(*word & bit)) {
+        *word |= bit;
+        update_summaries(set, index / 64);
+    }
+}
+
+void bitset_clear(bitset* set, u32 index) {
+    u64 bit = 1ULL << (index & 63);
+    u64* word = &set->words[index / 64];
+    if (*word & bit) {
+        *word &= ~bit;
+        update_summaries(set, index / 64);
+    }
+}
+
+b8 bitset_test(bitset* set, u32 index) {
+    return (set->words[index / 64] >> (index & 63)) & 1;
+}
+
+u32 bitset_count(bitset* set) {
+    u32 count = 0;
+    for (u32 i = 0; i < set->word_count; ++i) {
+        count += __builtin_popcountll(set->words[i]);
+    }
+    return count;
+}
+
+u32 bitset_find_first_set(bitset* set) {
+    return find_next(set, -1, 0, true);
+}
+
+u32 bitset_find_first_clear(bitset* set) {
+    return find_next(set, -1, 0, false);
+}
+
+u32 bitset_find_next_set(bitset* set, u32 index) {
+    return find_next(set, -1, index, true);
+}
+
+u32 bitset_find_next_clear(bitset* set, u32 index) {
+    return find_next(set, -1, index, false);
+}
\ No newline at end of file
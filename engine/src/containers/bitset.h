@@ -0,0 +1,54 @@
+#pragma once
+
+#include "defines.h"
+
+// Deep enough for 2^32 bits: every level has 64 times fewer bits.
+#define BITSET_MAX_LEVELS 6
+
+// Fixed-size set of bits in u64 words, with summaries for fast searches.
+// Summary level 0 has one bit per word, each higher level one bit per word
+// of the level below, up to a single top word. Two summaries are kept: one
+// marks words with any bit set, the other words with any bit clear. A
+// search for the first set or clear bit reads one word per level instead of
+// scanning, about 3 reads for 65536 bits. Sets of up to 64 bits are a
+// single word and carry no summaries.
+typedef struct bitset {
+    u32 bit_count;
+    u32 word_count;
+    // Summary levels, 0 when word_count is 1.
+    u32 level_count;
+    // Words per summary level, and where each starts in the summary arrays.
+    u32 level_word_counts[BITSET_MAX_LEVELS];
+    u32 level_offsets[BITSET_MAX_LEVELS];
+    b8 owns_memory;
+    u64* words;
+    u64* any_set;
+    u64* any_clear;
+} bitset;
+
+OKO_API u64 bitset_get_memory_requirement(u32 bit_count);
+
+// All bits start clear. Pass 0 as memory to have the set allocate, and free,
+// its own words.
+OKO_API b8 bitset_create(u32 bit_count, void* memory, bitset* out_set);
+
+OKO_API void bitset_destroy(bitset* set);
+
+OKO_API void bitset_set(bitset* set, u32 index);
+
+OKO_API void bitset_clear(bitset* set, u32 index);
+
+OKO_API b8 bitset_test(bitset* set, u32 index);
+
+// Number of set bits.
+OKO_API u32 bitset_count(bitset* set);
+
+// The finds return INVALID_ID when there is no such bit.
+OKO_API u32 bitset_find_first_set(bitset* set);
+
+OKO_API u32 bitset_find_first_clear(bitset* set);
+
+// First set bit at or after index, to walk the set bits in order.
+OKO_API u32 bitset_find_next_set(bitset* set, u32 index);
+
+OKO_API u32 bitset_find_next_clear(bitset* set, u32 index);
\ No newline at end of file
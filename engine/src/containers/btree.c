@@ -0,0 +1,583 @@
+#include "btree.h"
+
+#include "core/memory.h"
+#include "core/log.h"
+
+// 15 keys and 16 child or value slots make a node exactly 256 bytes, so with
+// the pool's cache line aligned elements it spans four whole lines.
+#define NODE_KEYS 15
+
+// Deep enough for any tree: only the rightmost node of a level can be less
+// than half full after a split.
+#define MAX_HEIGHT 32
+
+typedef struct btree_node {
+    u32 count;
+    b8 is_leaf;
+    u64 keys[NODE_KEYS];
+    union {
+        // Inner nodes: count + 1 children. Child i + 1 holds the keys from
+        // keys[i] up.
+        struct btree_node* children[NODE_KEYS + 1];
+        // Leaves: count values and the next leaf in key order.
+        struct {
+            u64 values[NODE_KEYS];
+            struct btree_node* next;
+        };
+    };
+} btree_node;
+
+static btree_node* create_node(pool_allocator* nodes, b8 is_leaf) {
+    btree_node* node = pool_allocator_allocate(nodes);
+    if (node) {
+        node->is_leaf = is_leaf;
+    }
+    return node;
+}
+
+static b8 create_node_pool(pool_allocator* nodes, u64 nodes_per_block) {
+    return pool_allocator_create(
+        "btree nodes",
+        sizeof(btree_node),
+        nodes_per_block,
+        true,
+        MEMORY_TAG_BST,
+        nodes
+    );
+}
+
+// Number of keys below key, the insert position in a leaf. Counting rather
+// than branching lets the compiler vectorize the scan.
+static u32 lower_bound(btree_node* node, u64 key) {
+    u32 position = 0;
+    for (u32 i = 0; i < node->count; ++i) {
+        position += node->keys[i] < key;
+    }
+    return position;
+}
+
+// Child of an inner node whose range holds key.
+static u32 child_index(btree_node* node, u64 key) {
+    u32 index = 0;
+    for (u32 i = 0; i < node->count; ++i) {
+        index += node->keys[i] <= key;
+    }
+    return index;
+}
+
+static btree_node* find_leaf(btree* tree, u64 key) {
+    btree_node* node = tree->root;
+    while (!node->is_leaf) {
+        node = node->children[child_index(node, key)];
+    }
+    return node;
+}
+
+static btree_node* split_leaf(
+    btree* tree,
+    btree_node* leaf,
+    u32 position,
+    u64 key,
+    u64 value,
+    b8 rightmost,
+    u64* out_split_key
+) {
+    btree_node* right = create_node(&tree->nodes, true);
+    if (!right) {
+        return 0;
+    }
+
+    u64 keys[NODE_KEYS + 1];
+    u64 values[NODE_KEYS + 1];
+    memory_copy(keys, leaf->keys, position * sizeof(u64));
+    memory_copy(values, leaf->values, position * sizeof(u64));
+    keys[position] = key;
+    values[position] = value;
+    memory_copy(
+        keys + position + 1,
+        leaf->keys + position,
+        (NODE_KEYS - position) * sizeof(u64)
+    );
+    memory_copy(
+        values + position + 1,
+        leaf->values + position,
+        (NODE_KEYS - position) * sizeof(u64)
+    );
+
+    // Appending at the end of the tree keeps the left leaf full, so ascending
+    // inserts pack leaves instead of leaving them half empty.
+    u32 left_count =
+        rightmost && position == NODE_KEYS ? NODE_KEYS : (NODE_KEYS + 1) / 2;
+    u32 right_count = NODE_KEYS + 1 - left_count;
+    memory_copy(leaf->keys, keys, left_count * sizeof(u64));
+    memory_copy(leaf->values, values, left_count * sizeof(u64));
+    memory_copy(right->keys, keys + left_count, right_count * sizeof(u64));
+    memory_copy(right->values, values + left_count, right_count * sizeof(u64));
+    leaf->count = left_count;
+    right->count = right_count;
+
+    right->next = leaf->next;
+    leaf->next = right;
+    *out_split_key = right->keys[0];
+    return right;
+}
+
+static btree_node* split_inner(
+    btree* tree,
+    btree_node* node,
+    u32 position,
+    u64 key,
+    btree_node* child,
+    b8 rightmost,
+    u64* out_split_key
+) {
+    btree_node* right = create_node(&tree->nodes, false);
+    if (!right) {
+        return 0;
+    }
+
+    // key goes in at position, child right after it.
+    u64 keys[NODE_KEYS + 1];
+    btree_node* children[NODE_KEYS + 2];
+    memory_copy(keys, node->keys, position * sizeof(u64));
+    keys[position] = key;
+    memory_copy(
+        keys + position + 1,
+        node->keys + position,
+        (NODE_KEYS - position) * sizeof(u64)
+    );
+    memory_copy(children, node->children, (position + 1) * sizeof(void*));
+    children[position + 1] = child;
+    memory_copy(
+        children + position + 2,
+        node->children + position + 1,
+        (NODE_KEYS - position) * sizeof(void*)
+    );
+
+    // The key at left_count moves up to the parent.
+    u32 left_count =
+        rightmost && position == NODE_KEYS ? NODE_KEYS : (NODE_KEYS + 1) / 2;
+    u32 right_count = NODE_KEYS - left_count;
+    memory_copy(node->keys, keys, left_count * sizeof(u64));
+    memory_copy(node->children, children, (left_count + 1) * sizeof(void*));
+    memory_copy(right->keys, keys + left_count + 1, right_count * sizeof(u64));
+    memory_copy(
+        right->children,
+        children + left_count + 1,
+        (right_count + 1) * sizeof(void*)
+    );
+    node->count = left_count;
+    right->count = right_count;
+
+    *out_split_key = keys[left_count];
+    return right;
+}
+
+// Inserts into the subtree at node. If node had to split, returns the new
+// right sibling and its lowest key in out_split_key. out_result is 1 for a
+// new key, 0 for an update and -1 when out of memory.
+static btree_node* insert_into(
+    btree* tree,
+    btree_node* node,
+    u64 key,
+    u64 value,
+    b8 rightmost,
+    u64* out_split_key,
+    i32* out_result
+) {
+    if (node->is_leaf) {
+        u32 position = lower_bound(node, key);
+        if (position < node->count && node->keys[position] == key) {
+            node->values[position] = value;
+            *out_result = 0;
+            return 0;
+        }
+
+        *out_result = 1;
+        if (node->count == NODE_KEYS) {
+            btree_node* right = split_leaf(
+                tree, node, position, key, value, rightmost, out_split_key
+            );
+            if (!right) {
+                *out_result = -1;
+            }
+            return right;
+        }
+        u32 tail = node->count - position;
+        memory_move(
+            node->keys + position + 1, node->keys + position, tail * 8
+        );
+        memory_move(
+            node->values + position + 1, node->values + position, tail * 8
+        );
+        node->keys[position] = key;
+        node->values[position] = value;
+        node->count++;
+        return 0;
+    }
+
+    u32 index = child_index(node, key);
+    u64 child_key;
+    btree_node* child = insert_into(
+        tree,
+        node->children[index],
+        key,
+        value,
+        rightmost && index == node->count,
+        &child_key,
+        out_result
+    );
+    if (!child) {
+        return 0;
+    }
+
+    if (node->count == NODE_KEYS) {
+        btree_node* right = split_inner(
+            tree, node, index, child_key, child, rightmost, out_split_key
+        );
+        if (!right) {
+            *out_result = -1;
+        }
+        return right;
+    }
+    u32 tail = node->count - index;
+    memory_move(node->keys + index + 1, node->keys + index, tail * 8);
+    memory_move(
+        node->children + index + 2, node->children + index + 1, tail * 8
+    );
+    node->keys[index] = child_key;
+    node->children[index + 1] = child;
+    node->count++;
+    return 0;
+}
+
+b8 btree_create(u64 nodes_per_block, btree* out_tree) {
+    if (!out_tree || !nodes_per_block) {
+        OKO_ERROR("btree_create requires out_tree and a non-zero block size.");
+        return false;
+    }
+
+    memory_zero(out_tree, sizeof(btree));
+    if (!create_node_pool(&out_tree->nodes, nodes_per_block)) {
+        return false;
+    }
+
+    out_tree->root = create_node(&out_tree->nodes, true);
+    if (!out_tree->root) {
+        OKO_ERROR("btree_create - failed to allocate the root.");
+        pool_allocator_discard(&out_tree->nodes);
+        return false;
+    }
+    out_tree->first_leaf = out_tree->root;
+    out_tree->height = 1;
+    return true;
+}
+
+void btree_destroy(btree* tree) {
+    if (tree) {
+        if (tree->root) {
+            // Every node is a slot of the pool, so discarding it releases
+            // the whole tree without walking it.
+            pool_allocator_discard(&tree->nodes);
+        }
+        memory_zero(tree, sizeof(btree));
+    }
+}
+
+b8 btree_insert(btree* tree, u64 key, u64 value) {
+    if (!tree || !tree->root) {
+        OKO_ERROR("btree_insert requires a created tree.");
+        return false;
+    }
+
+    u64 split_key;
+    i32 result;
+    btree_node* right =
+        insert_into(tree, tree->root, key, value, true, &split_key, &result);
+    if (right) {
+        btree_node* root = create_node(&tree->nodes, false);
+        if (!root) {
+            result = -1;
+        } else {
+            root->count = 1;
+            root->keys[0] = split_key;
+            root->children[0] = tree->root;
+            root->children[1] = right;
+            tree->root = root;
+            tree->height++;
+        }
+    }
+
+    if (result < 0) {
+        OKO_ERROR("btree_insert - out of memory for nodes.");
+        return false;
+    }
+    tree->count += result;
+    return true;
+}
+
+b8 btree_get(btree* tree, u64 key, u64* out_value) {
+    if (!tree || !tree->root || !out_value) {
+        OKO_WARN("btree_get requires a created tree and out_value.");
+        return false;
+    }
+
+    btree_node* leaf = find_leaf(tree, key);
+    u32 position = lower_bound(leaf, key);
+    if (position == leaf->count || leaf->keys[position] != key) {
+        return false;
+    }
+    *out_value = leaf->values[position];
+    return true;
+}
+
+b8 btree_remove(btree* tree, u64 key) {
+    if (!tree || !tree->root) {
+        OKO_WARN("btree_remove requires a created tree.");
+        return false;
+    }
+
+    btree_node* path[MAX_HEIGHT];
+    u32 indices[MAX_HEIGHT];
+    u32 depth = 0;
+    btree_node* node = tree->root;
+    while (!node->is_leaf) {
+        u32 index = child_index(node, key);
+        path[depth] = node;
+        indices[depth] = index;
+        depth++;
+        node = node->children[index];
+    }
+
+    u32 position = lower_bound(node, key);
+    if (position == node->count || node->keys[position] != key) {
+        return false;
+    }
+    u32 tail = node->count - position - 1;
+    memory_move(node->keys + position, node->keys + position + 1, tail * 8);
+    memory_move(node->values + position, node->values + position + 1, tail * 8);
+    node->count--;
+    tree->count--;
+    if (node->count || node == tree->root) {
+        return true;
+    }
+
+    // The leaf is empty: unlink it from the chain. Its predecessor is the
+    // rightmost leaf under the nearest left sibling on the path.
+    btree_node* previous = 0;
+    for (u32 level = depth; level-- > 0;) {
+        if (indices[level]) {
+            previous = path[level]->children[indices[level] - 1];
+            while (!previous->is_leaf) {
+                previous = previous->children[previous->count];
+            }
+            break;
+        }
+    }
+    if (previous) {
+        previous->next = node->next;
+    } else {
+        tree->first_leaf = node->next;
+    }
+    pool_allocator_free(&tree->nodes, node);
+
+    // Drop it from its parent, and any parent that empties with it. The
+    // root never empties here since the tree still has other leaves.
+    for (u32 level = depth; level-- > 0;) {
+        btree_node* parent = path[level];
+        u32 index = indices[level];
+        if (parent->count == 0) {
+            pool_allocator_free(&tree->nodes, parent);
+            continue;
+        }
+        // Removing child 0 takes the separator after it, otherwise the one
+        // before.
+        u32 key_index = index ? index - 1 : 0;
+        u32 key_tail = parent->count - key_index - 1;
+        memory_move(
+            parent->keys + key_index, parent->keys + key_index + 1, key_tail * 8
+        );
+        u32 child_tail = parent->count - index;
+        memory_move(
+            parent->children + index,
+            parent->children + index + 1,
+            child_tail * 8
+        );
+        parent->count--;
+        break;
+    }
+
+    // A root with a single child is just a longer path to it.
+    while (!tree->root->is_leaf && tree->root->count == 0) {
+        btree_node* old_root = tree->root;
+        tree->root = old_root->children[0];
+        pool_allocator_free(&tree->nodes, old_root);
+        tree->height--;
+    }
+    return true;
+}
+
+// Builds a densely packed tree of count entries out of nodes. Returns false
+// if an allocation fails, the nodes made so far are left to the caller's pool.
+static b8 build_levels(
+    pool_allocator* nodes,
+    const u64* keys,
+    const u64* values,
+    u64 count,
+    btree_node** out_root,
+    btree_node** out_first_leaf,
+    u32* out_height
+) {
+    if (!count) {
+        *out_root = create_node(nodes, true);
+        *out_first_leaf = *out_root;
+        return *out_root != 0;
+    }
+
+    // One level at a time, each node with the lowest key under it.
+    u64 level_count = (count + NODE_KEYS - 1) / NODE_KEYS;
+    u64 allocated_count = level_count;
+    btree_node** level =
+        memory_allocate(allocated_count * sizeof(btree_node*), MEMORY_TAG_BST);
+    u64* level_keys =
+        memory_allocate(allocated_count * sizeof(u64), MEMORY_TAG_BST);
+    b8 result = level && level_keys;
+
+    btree_node* previous = 0;
+    for (u64 i = 0; result && i < level_count; ++i) {
+        btree_node* leaf = create_node(nodes, true);
+        if (!leaf) {
+            result = false;
+            break;
+        }
+        u64 first = i * NODE_KEYS;
+        u64 leaf_count = count - first < NODE_KEYS ? count - first : NODE_KEYS;
+        memory_copy(leaf->keys, keys + first, leaf_count * sizeof(u64));
+        memory_copy(leaf->values, values + first, leaf_count * sizeof(u64));
+        leaf->count = (u32)leaf_count;
+        if (previous) {
+            previous->next = leaf;
+        } else {
+            *out_first_leaf = leaf;
+        }
+        previous = leaf;
+        level[i] = leaf;
+        level_keys[i] = keys[first];
+    }
+
+    while (result && level_count > 1) {
+        u64 parent_count = (level_count + NODE_KEYS) / (NODE_KEYS + 1);
+        for (u64 i = 0; i < parent_count; ++i) {
+            btree_node* parent = create_node(nodes, false);
+            if (!parent) {
+                result = false;
+                break;
+            }
+            u64 first = i * (NODE_KEYS + 1);
+            u64 children = level_count - first < NODE_KEYS + 1
+                               ? level_count - first
+                               : NODE_KEYS + 1;
+            for (u64 c = 0; c < children; ++c) {
+                parent->children[c] = level[first + c];
+                if (c) {
+                    parent->keys[c - 1] = level_keys[first + c];
+                }
+            }
+            parent->count = (u32)children - 1;
+            // Parents fill the front of the arrays the children came from.
+            level[i] = parent;
+            level_keys[i] = level_keys[first];
+        }
+        level_count = parent_count;
+        (*out_height)++;
+    }
+
+    if (result) {
+        *out_root = level[0];
+    }
+    if (level) {
+        memory_free(level, allocated_count * sizeof(btree_node*), MEMORY_TAG_BST);
+    }
+    if (level_keys) {
+        memory_free(level_keys, allocated_count * sizeof(u64), MEMORY_TAG_BST);
+    }
+    return result;
+}
+
+b8 btree_bulk_load(
+    btree* tree, const u64* keys, const u64* values, u64 count
+) {
+    if (!tree || !tree->root || (count && (!keys || !values))) {
+        OKO_ERROR("btree_bulk_load requires a created tree, keys and values.");
+        return false;
+    }
+    for (u64 i = 1; i < count; ++i) {
+        if (keys[i] <= keys[i - 1]) {
+            OKO_ERROR(
+                "btree_bulk_load - keys must be strictly increasing, key %llu is not.",
+                i
+            );
+            return false;
+        }
+    }
+
+    // Built in a pool of its own and swapped in at the end, so a failure
+    // leaves the tree as it was.
+    pool_allocator nodes;
+    if (!create_node_pool(&nodes, tree->nodes.elements_per_block)) {
+        OKO_ERROR("btree_bulk_load - failed to create the node pool.");
+        return false;
+    }
+    btree_node* root = 0;
+    btree_node* first_leaf = 0;
+    u32 height = 1;
+    if (!build_levels(
+            &nodes, keys, values, count, &root, &first_leaf, &height
+        )) {
+        OKO_ERROR("btree_bulk_load - failed to allocate the nodes.");
+        pool_allocator_discard(&nodes);
+        return false;
+    }
+
+    pool_allocator_replace(&tree->nodes, &nodes);
+    tree->root = root;
+    tree->first_leaf = first_leaf;
+    tree->count = count;
+    tree->height = height;
+    return true;
+}
+
+btree_iterator btree_range(btree* tree, u64 min_key, u64 max_key) {
+    btree_iterator iterator = {0};
+    if (!tree || !tree->root || min_key > max_key) {
+        return iterator;
+    }
+    iterator.leaf = find_leaf(tree, min_key);
+    iterator.index = lower_bound(iterator.leaf, min_key);
+    iterator.max_key = max_key;
+    return iterator;
+}
+
+b8 btree_iterator_next(
+    btree_iterator* iterator, u64* out_key, u64* out_value
+) {
+    btree_node* leaf = iterator->leaf;
+    while (leaf && iterator->index >= leaf->count) {
+        leaf = leaf->next;
+        iterator->index = 0;
+    }
+    if (!leaf || leaf->keys[iterator->index] > iterator->max_key) {
+        iterator->leaf = 0;
+        return false;
+    }
+
+    iterator->leaf = leaf;
+    if (out_key) {
+        *out_key = leaf->keys[iterator->index];
+    }
+    if (out_value) {
+        *out_value = leaf->values[iterator->index];
+    }
+    iterator->index++;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "defines.h"
+
+#include "memory/pool_allocator.h"
+
+// Ordered map from u64 keys to u64 values (store a handle, an index or a
+// pointer). A B+ tree: every entry lives in a leaf, leaves are chained in
+// key order for range walks and inner nodes only route. A node is four cache
+// lines, its 15 keys packed together so a search scans them in two.
+// Nodes come from a pool under MEMORY_TAG_BST. Removal frees nodes once they
+// are empty instead of merging half-full neighbours, so heavy churn can
+// leave the tree sparser than a fresh one; btree_bulk_load rebuilds it
+// densely.
+// The pool registers itself with the memory system, so the tree must not
+// move between create and destroy.
+typedef struct btree {
+    pool_allocator nodes;
+    struct btree_node* root;
+    // Leftmost leaf, where in-order walks start.
+    struct btree_node* first_leaf;
+    u64 count;
+    // Levels, 1 while the root is a leaf.
+    u32 height;
+} btree;
+
+// Walks the entries of a range in key order.
+typedef struct btree_iterator {
+    struct btree_node* leaf;
+    u32 index;
+    u64 max_key;
+} btree_iterator;
+
+// nodes_per_block sets how many nodes the pool adds at a time.
+OKO_API b8 btree_create(u64 nodes_per_block, btree* out_tree);
+
+OKO_API void btree_destroy(btree* tree);
+
+// Inserts or updates.
+OKO_API b8 btree_insert(btree* tree, u64 key, u64 value);
+
+// Returns false and leaves out_value untouched when key is not present.
+OKO_API b8 btree_get(btree* tree, u64 key, u64* out_value);
+
+OKO_API b8 btree_remove(btree* tree, u64 key);
+
+// Replaces the contents with count entries, keys strictly increasing. Leaves
+// are filled completely, so lookups and walks touch as few nodes as possible.
+// On failure the tree is left as it was.
+OKO_API b8 btree_bulk_load(
+    btree* tree, const u64* keys, const u64* values, u64 count
+);
+
+// Iterator over the entries with min_key <= key <= max_key.
+OKO_API btree_iterator btree_range(btree* tree, u64 min_key, u64 max_key);
+
+// Returns false once the range is exhausted. out_value may be 0.
+OKO_API b8 btree_iterator_next(
+    btree_iterator* iterator, u64* out_key, u64* out_value
+);
\ No newline at end of file
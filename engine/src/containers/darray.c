@@ -2,25 +2,72 @@
 
 #include "core/memory.h"
 #include "core/log.h"
+#include "math/math.h"
+
+#define HEADER_SIZE (DARRAY_FIELD_LENGTH * sizeof(u64))
+
+// Bytes from the start of the block to the elements. Over-aligned arrays pad
+// in front of the header so the elements land on the alignment.
+static u64 get_data_offset(u64 alignment) {
+    return alignment > HEADER_SIZE ? alignment : HEADER_SIZE;
+}
+
+static b8 is_over_aligned(u64 alignment) {
+    return alignment > DARRAY_DEFAULT_ALIGNMENT;
+}
+
+static void* allocate_array(u64 capacity, u64 stride, u64 alignment) {
+    u64 offset = get_data_offset(alignment);
+    u64 size = offset + capacity * stride;
+    u8* block = is_over_aligned(alignment)
+                    ? memory_allocate_aligned(size, alignment, MEMORY_TAG_DARRAY)
+                    : memory_allocate(size, MEMORY_TAG_DARRAY);
+    if (!block) {
+        return 0;
+    }
+    u64* header = (u64*)(block + offset) - DARRAY_FIELD_LENGTH;
+    header[DARRAY_CAPACITY] = capacity;
+    header[DARRAY_LENGTH] = 0;
+    header[DARRAY_STRIDE] = stride;
+    header[DARRAY_ALIGNMENT] = alignment;
+    return block + offset;
+}
+
+static void free_array(void* array) {
+    u64* header = (u64*)array - DARRAY_FIELD_LENGTH;
+    u64 alignment = header[DARRAY_ALIGNMENT];
+    u64 offset = get_data_offset(alignment);
+    u64 size = offset + header[DARRAY_CAPACITY] * header[DARRAY_STRIDE];
+    u8* block = (u8*)array - offset;
+    if (is_over_aligned(alignment)) {
+        memory_free_aligned(block, size, alignment, MEMORY_TAG_DARRAY);
+    } else {
+        memory_free(block, size, MEMORY_TAG_DARRAY);
+    }
+}
 
 void* _darray_create(u64 length, u64 stride) {
-    u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
-    u64 array_size = length * stride;
-    u64* new_array =
-        memory_allocate(header_size + array_size, MEMORY_TAG_DARRAY);
-    memory_set(new_array, 0, header_size + array_size);
-    new_array[DARRAY_CAPACITY] = length;
-    new_array[DARRAY_LENGTH] = 0;
-    new_array[DARRAY_STRIDE] = stride;
-    return (void*)(new_array + DARRAY_FIELD_LENGTH);
+    return allocate_array(length, stride, DARRAY_DEFAULT_ALIGNMENT);
+}
+
+void* _darray_create_aligned(u64 length, u64 stride, u16 alignment) {
+    if (!is_power_of_2(alignment)) {
+        OKO_ERROR(
+            "_darray_create_aligned - alignment must be a power of 2, got %u.",
+            alignment
+        );
+        return 0;
+    }
+    return allocate_array(
+        length,
+        stride,
+        alignment > DARRAY_DEFAULT_ALIGNMENT ? alignment
+                                             : DARRAY_DEFAULT_ALIGNMENT
+    );
 }
 
 void _darray_destroy(void* array) {
-    u64* header = (u64*)array - DARRAY_FIELD_LENGTH;
-    u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
-    u64 total_size =
-        header_size + header[DARRAY_CAPACITY] * header[DARRAY_STRIDE];
-    memory_free(header, total_size, MEMORY_TAG_DARRAY);
+    free_array(array);
 }
 
 u64 _darray_field_get(void* array, u64 field) {
@@ -33,16 +80,65 @@ void _darray_field_set(void* array, u64 field, u64 value) {
     header[field] = value;
 }
 
+// Moves the array to a block of new_capacity elements. Grows in place when
+// the allocator can, otherwise only the header and the elements are copied.
+// Added capacity is left uninitialized. On failure the array is returned
+// untouched, callers check the capacity.
+static void* set_capacity(void* array, u64 new_capacity) {
+    u64* header = (u64*)array - DARRAY_FIELD_LENGTH;
+    u64 capacity = header[DARRAY_CAPACITY];
+    u64 stride = header[DARRAY_STRIDE];
+    u64 alignment = header[DARRAY_ALIGNMENT];
+
+    if (is_over_aligned(alignment)) {
+        // The aligned path cannot resize in place, move to a new block.
+        void* new_array = allocate_array(new_capacity, stride, alignment);
+        if (!new_array) {
+            return array;
+        }
+        u64 length = header[DARRAY_LENGTH];
+        memory_copy(new_array, array, length * stride);
+        _darray_field_set(new_array, DARRAY_LENGTH, length);
+        free_array(array);
+        return new_array;
+    }
+
+    u64* new_header = memory_reallocate(
+        header,
+        HEADER_SIZE + capacity * stride,
+        HEADER_SIZE + new_capacity * stride,
+        MEMORY_TAG_DARRAY
+    );
+    if (!new_header) {
+        return array;
+    }
+    new_header[DARRAY_CAPACITY] = new_capacity;
+    return (void*)(new_header + DARRAY_FIELD_LENGTH);
+}
+
 void* _darray_resize(void* array) {
-    u64 length = darray_length(array);
-    u64 stride = darray_stride(array);
-    void* temp =
-        _darray_create((DARRAY_RESIZE_FACTOR * darray_capacity(array)), stride);
-    memory_copy(temp, array, length * stride);
+    u64 capacity = darray_capacity(array);
+    return set_capacity(array, capacity ? DARRAY_RESIZE_FACTOR * capacity : 1);
+}
+
+void* _darray_reserve_more(void* array, u64 count) {
+    u64 needed = darray_length(array) + count;
+    u64 capacity = darray_capacity(array);
+    if (needed <= capacity) {
+        return array;
+    }
+    // Still grow geometrically so repeated calls stay amortized O(1).
+    u64 new_capacity = DARRAY_RESIZE_FACTOR * capacity;
+    return set_capacity(array, needed > new_capacity ? needed : new_capacity);
+}
 
-    _darray_field_set(temp, DARRAY_LENGTH, length);
-    _darray_destroy(array);
-    return temp;
+void* _darray_shrink_to_fit(void* array) {
+    u64 length = darray_length(array);
+    u64 new_capacity = length ? length : 1;
+    if (new_capacity >= darray_capacity(array)) {
+        return array;
+    }
+    return set_capacity(array, new_capacity);
 }
 
 void* _darray_push(void* array, const void* value_ptr) {
@@ -50,6 +146,10 @@ void* _darray_push(void* array, const void* value_ptr) {
     u64 stride = darray_stride(array);
     if (length >= darray_capacity(array)) {
         array = _darray_resize(array);
+        if (length >= darray_capacity(array)) {
+            OKO_ERROR("_darray_push - failed to grow the array.");
+            return array;
+        }
     }
 
     u64 addr = (u64)array;
@@ -59,6 +159,43 @@ void* _darray_push(void* array, const void* value_ptr) {
     return array;
 }
 
+void* _darray_push_n(void* array, const void* values, u64 count) {
+    if (!count) {
+        return array;
+    }
+
+    // values may point into the array itself, as with darray_append(a, a).
+    // Growing can move the array, so keep the offset and find them again.
+    u64 length = darray_length(array);
+    u64 stride = darray_stride(array);
+    u64 offset = (u64)((const u8*)values - (u8*)array);
+    b8 aliased = (const u8*)values >= (u8*)array && offset < length * stride;
+
+    array = _darray_reserve_more(array, count);
+    if (length + count > darray_capacity(array)) {
+        OKO_ERROR("_darray_push_n - failed to grow the array.");
+        return array;
+    }
+    if (aliased) {
+        values = (u8*)array + offset;
+    }
+    memory_copy((u8*)array + length * stride, values, count * stride);
+    _darray_field_set(array, DARRAY_LENGTH, length + count);
+    return array;
+}
+
+void* _darray_append(void* array, void* other) {
+    if (darray_stride(other) != darray_stride(array)) {
+        OKO_ERROR(
+            "_darray_append - stride mismatch, %llu vs %llu.",
+            darray_stride(array),
+            darray_stride(other)
+        );
+        return array;
+    }
+    return _darray_push_n(array, other, darray_length(other));
+}
+
 void _darray_pop(void* array, void* dest) {
     u64 length = darray_length(array);
     u64 stride = darray_stride(array);
@@ -73,23 +210,43 @@ void* _darray_pop_at(void* array, u64 index, void* dest) {
     u64 stride = darray_stride(array);
     if (index >= length) {
         OKO_ERROR(
-            "Index outside the bounds of this array! Length: %i, index: %index",
+            "Index outside the bounds of this array! Length: %llu, index: %llu",
             length,
             index
         );
         return array;
     }
 
-    u64 addr = (u64)array;
-    memory_copy(dest, (void*)(addr + (index * stride)), stride);
+    u8* element = (u8*)array + index * stride;
+    if (dest) {
+        memory_copy(dest, element, stride);
+    }
 
-    // If not on the last element, snip out the entry and copy the rest inward.
-    if (index != length - 1) {
-        memory_copy(
-            (void*)(addr + (index * stride)),
-            (void*)(addr + ((index + 1) * stride)),
-            stride * (length - index)
+    // Close the gap, the ranges overlap.
+    memory_move(element, element + stride, stride * (length - index - 1));
+
+    _darray_field_set(array, DARRAY_LENGTH, length - 1);
+    return array;
+}
+
+void* _darray_swap_remove(void* array, u64 index, void* dest) {
+    u64 length = darray_length(array);
+    u64 stride = darray_stride(array);
+    if (index >= length) {
+        OKO_ERROR(
+            "Index outside the bounds of this array! Length: %llu, index: %llu",
+            length,
+            index
         );
+        return array;
+    }
+
+    u8* element = (u8*)array + index * stride;
+    if (dest) {
+        memory_copy(dest, element, stride);
+    }
+    if (index != length - 1) {
+        memory_copy(element, (u8*)array + (length - 1) * stride, stride);
     }
 
     _darray_field_set(array, DARRAY_LENGTH, length - 1);
@@ -99,9 +256,9 @@ void* _darray_pop_at(void* array, u64 index, void* dest) {
 void* _darray_insert_at(void* array, u64 index, void* value_ptr) {
     u64 length = darray_length(array);
     u64 stride = darray_stride(array);
-    if (index >= length) {
+    if (index > length) {
         OKO_ERROR(
-            "Index outside the bounds of this array! Length: %i, index: %index",
+            "Index outside the bounds of this array! Length: %llu, index: %llu",
             length,
             index
         );
@@ -109,21 +266,18 @@ void* _darray_insert_at(void* array, u64 index, void* value_ptr) {
     }
     if (length >= darray_capacity(array)) {
         array = _darray_resize(array);
+        if (length >= darray_capacity(array)) {
+            OKO_ERROR("_darray_insert_at - failed to grow the array.");
+            return array;
+        }
     }
 
-    u64 addr = (u64)array;
-
-    // If not on the last element, copy the rest outward.
-    if (index != length - 1) {
-        memory_copy(
-            (void*)(addr + ((index + 1) * stride)),
-            (void*)(addr + (index * stride)),
-            stride * (length - index)
-        );
-    }
+    // Open a gap, the ranges overlap.
+    u8* element = (u8*)array + index * stride;
+    memory_move(element + stride, element, stride * (length - index));
 
     // Set the value at the index
-    memory_copy((void*)(addr + (index * stride)), value_ptr, stride);
+    memory_copy(element, value_ptr, stride);
 
     _darray_field_set(array, DARRAY_LENGTH, length + 1);
     return array;
@@ -7,29 +7,56 @@ Memory layout
 u64 capacity = number of elements that can be held
 u64 length = number of elements currently contained
 u64 stride = size of each element in bytes
+u64 alignment = alignment of the elements
 void* elements
+
+Capacity from darray_create/darray_reserve starts zeroed, capacity added when
+the array grows does not.
+
+Elements are DARRAY_DEFAULT_ALIGNMENT aligned. The _aligned variants take a
+larger power of 2 (32, 64...) for arrays used with wide vector loads, padding
+in front of the header. Those arrays move on every growth since aligned
+blocks cannot be resized in place.
 */
 
 enum {
     DARRAY_CAPACITY,
     DARRAY_LENGTH,
     DARRAY_STRIDE,
+    DARRAY_ALIGNMENT,
     DARRAY_FIELD_LENGTH
 };
 
+#define DARRAY_DEFAULT_ALIGNMENT 16
+
 OKO_API void* _darray_create(u64 length, u64 stride);
+OKO_API void* _darray_create_aligned(u64 length, u64 stride, u16 alignment);
 OKO_API void _darray_destroy(void* array);
 
 OKO_API u64 _darray_field_get(void* array, u64 field);
 OKO_API void _darray_field_set(void* array, u64 field, u64 value);
 
 OKO_API void* _darray_resize(void* array);
+// Makes room for count more elements with at most one reallocation.
+OKO_API void* _darray_reserve_more(void* array, u64 count);
+// Drops unused capacity, keeping room for at least one element.
+OKO_API void* _darray_shrink_to_fit(void* array);
 
 OKO_API void* _darray_push(void* array, const void* value_ptr);
+// Copies count contiguous elements to the end in one go. values may point
+// into the array's own elements.
+OKO_API void* _darray_push_n(void* array, const void* values, u64 count);
+// Pushes every element of other, which must have the same stride.
+OKO_API void* _darray_append(void* array, void* other);
 OKO_API void _darray_pop(void* array, void* dest);
 
+// Keep the order of the remaining elements. dest may be 0.
 OKO_API void* _darray_pop_at(void* array, u64 index, void* dest);
+// index may be the length, which appends.
 OKO_API void* _darray_insert_at(void* array, u64 index, void* value_ptr);
+// Removes in O(1) by moving the last element into the gap, so the order is
+// not kept. dest may be 0.
+OKO_API void* _darray_swap_remove(void* array, u64 index, void* dest);
 
 #define DARRAY_DEFAULT_CAPACITY 1
 #define DARRAY_RESIZE_FACTOR    2
@@ -39,6 +66,12 @@ OKO_API void* _darray_insert_at(void* array, u64 index, void* value_ptr);
 
 #define darray_reserve(type, capacity) _darray_create(capacity, sizeof(type))
 
+#define darray_create_aligned(type, alignment) \
+  _darray_create_aligned(DARRAY_DEFAULT_CAPACITY, sizeof(type), alignment)
+
+#define darray_reserve_aligned(type, capacity, alignment) \
+  _darray_create_aligned(capacity, sizeof(type), alignment)
+
 #define darray_destroy(array) _darray_destroy(array)
 
 #define darray_push(array, value)       \
@@ -47,6 +80,26 @@ OKO_API void* _darray_insert_at(void* array, u64 index, void* value_ptr);
     array = _darray_push(array, &temp); \
   }
 
+#define darray_push_n(array, values_ptr, count)       \
+  {                                                   \
+    array = _darray_push_n(array, values_ptr, count); \
+  }
+
+#define darray_append(array, other)       \
+  {                                       \
+    array = _darray_append(array, other); \
+  }
+
+#define darray_reserve_more(array, count)       \
+  {                                             \
+    array = _darray_reserve_more(array, count); \
+  }
+
+#define darray_shrink_to_fit(array)       \
+  {                                       \
+    array = _darray_shrink_to_fit(array); \
+  }
+
 #define darray_pop(array, value_ptr) _darray_pop(array, value_ptr)
 
 #define darray_insert_at(array, index, value)       \
@@ -58,6 +111,9 @@ OKO_API void* _darray_insert_at(void* array, u64 index, void* value_ptr);
 #define darray_pop_at(array, index, value_ptr) \
   _darray_pop_at(array, index, value_ptr)
 
+#define darray_swap_remove(array, index, value_ptr) \
+  _darray_swap_remove(array, index, value_ptr)
+
 #define darray_clear(array) _darray_field_set(array, DARRAY_LENGTH, 0)
 
 #define darray_capacity(array) _darray_field_get(array, DARRAY_CAPACITY)
@@ -66,5 +122,7 @@ OKO_API void* _darray_insert_at(void* array, u64 index, void* value_ptr);
 
 #define darray_stride(array) _darray_field_get(array, DARRAY_STRIDE)
 
+#define darray_alignment(array) _darray_field_get(array, DARRAY_ALIGNMENT)
+
 #define darray_length_set(array, value) \
   _darray_field_set(array, DARRAY_LENGTH, value)
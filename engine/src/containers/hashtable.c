@@ -2,23 +2,294 @@
 
 #include "core/memory.h"
 #include "core/log.h"
+#include "core/hash.h"
+#include "containers/string.h"
 
-u64 hash_name(const char* name, u32 element_count) {
-    // a multiplier to use when generating a hash. prime to hopefully avoid
-    // collisions.
-    static const u64 multiplier = 97;
+// Growable tables stay below 3/4 full.
+#define MAX_LOAD_NUMERATOR   3
+#define MAX_LOAD_DENOMINATOR 4
 
-    unsigned const char* us;
-    u64 hash = 0;
+// Smallest slot count a growable table starts with.
+#define MIN_GROWABLE_CAPACITY 8
 
-    for (us = (unsigned const char*)name; *us; us++) {
-        hash = hash * multiplier + *us;
+// Old slots drained per operation while growing. Growth doubles the slot
+// count, so the old table empties long before the new one fills up.
+#define REHASH_STEP 8
+
+typedef struct hashtable_entry {
+    u64 hash;
+    // Owned copy of the key, 0 for an empty slot.
+    char* key;
+} hashtable_entry;
+
+// One block of slots: the table's current one or the one it is growing out
+// of.
+typedef struct slots {
+    hashtable_entry* entries;
+    u8* values;
+    u64 element_size;
+    u32 capacity;
+} slots;
+
+// Smallest power of 2 that holds element_count.
+static u32 get_capacity(u32 element_count) {
+    u32 capacity = 1;
+    while (capacity < element_count) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+// Slot count that keeps element_count entries under the growth threshold.
+static u32 get_growable_capacity(u32 element_count) {
+    u64 needed = ((u64)element_count * MAX_LOAD_DENOMINATOR +
+                  MAX_LOAD_NUMERATOR - 1) /
+                 MAX_LOAD_NUMERATOR;
+    u32 capacity = get_capacity((u32)needed);
+    return capacity < MIN_GROWABLE_CAPACITY ? MIN_GROWABLE_CAPACITY
+                                            : capacity;
+}
+
+static u64 get_slots_size(u64 element_size, u32 capacity) {
+    return (sizeof(hashtable_entry) + element_size) * capacity;
+}
+
+static slots make_slots(hashtable* table, void* memory, u32 capacity) {
+    slots s;
+    s.entries = memory;
+    s.values = (u8*)memory + sizeof(hashtable_entry) * (u64)capacity;
+    s.element_size = table->element_size;
+    s.capacity = capacity;
+    return s;
+}
+
+static slots current_slots(hashtable* table) {
+    return make_slots(table, table->memory, table->capacity);
+}
+
+static slots old_slots(hashtable* table) {
+    return make_slots(table, table->old_memory, table->old_capacity);
+}
+
+static void* get_value(slots* s, u32 index) {
+    return s->values + s->element_size * index;
+}
+
+static u32 get_home(slots* s, u64 hash) {
+    return (u32)hash & (s->capacity - 1);
+}
+
+// Index of the slot holding name, or of the empty slot that ends its probe
+// sequence. INVALID_ID if the slots are full and name is not in them.
+static u32 find_slot(slots* s, const char* name, u64 hash) {
+    u32 mask = s->capacity - 1;
+    u32 index = get_home(s, hash);
+    for (u32 probe = 0; probe < s->capacity; ++probe) {
+        hashtable_entry* entry = &s->entries[index];
+        if (!entry->key ||
+            (entry->hash == hash && strings_equal(entry->key, name))) {
+            return index;
+        }
+        index = (index + 1) & mask;
+    }
+    return INVALID_ID;
+}
+
+// Index of the slot holding name, INVALID_ID if it is not there.
+static u32 find_key(slots* s, const char* name, u64 hash) {
+    u32 index = find_slot(s, name, hash);
+    if (index == INVALID_ID || !s->entries[index].key) {
+        return INVALID_ID;
+    }
+    return index;
+}
+
+// Empties a slot without freeing its key. Backward shift: pulls later
+// entries of the cluster into the hole unless that would move them before
+// their home slot.
+static void take_out(slots* s, u32 hole) {
+    hashtable_entry* entries = s->entries;
+    entries[hole].key = 0;
+
+    u32 mask = s->capacity - 1;
+    u32 next = (hole + 1) & mask;
+    while (entries[next].key) {
+        u32 home = get_home(s, entries[next].hash);
+        u32 distance_from_home = (next - home) & mask;
+        u32 distance_to_hole = (next - hole) & mask;
+        if (distance_from_home >= distance_to_hole) {
+            entries[hole] = entries[next];
+            memory_copy(
+                get_value(s, hole), get_value(s, next), s->element_size
+            );
+            // Cleared right away, so a full table cannot loop back into it.
+            entries[next].key = 0;
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    entries[hole].hash = 0;
+    memory_zero(get_value(s, hole), s->element_size);
+}
+
+// Moves up to slot_budget old slots into the current ones, releasing the old
+// block once it is empty. Slots before rehash_index are always empty, and
+// taking entries out keeps every remaining old entry reachable.
+static void rehash_step(hashtable* table, u32 slot_budget) {
+    if (!table->old_memory) {
+        return;
+    }
+
+    slots old = old_slots(table);
+    slots current = current_slots(table);
+    u32 mask = current.capacity - 1;
+    while (slot_budget-- && table->rehash_index < old.capacity) {
+        u32 index = table->rehash_index;
+        // Taking an entry out can shift the next one of its cluster here.
+        while (old.entries[index].key) {
+            u32 target = get_home(&current, old.entries[index].hash);
+            while (current.entries[target].key) {
+                target = (target + 1) & mask;
+            }
+            current.entries[target] = old.entries[index];
+            memory_copy(
+                get_value(&current, target),
+                get_value(&old, index),
+                current.element_size
+            );
+            take_out(&old, index);
+        }
+        table->rehash_index++;
+    }
+
+    if (table->rehash_index == old.capacity) {
+        memory_free(
+            table->old_memory,
+            get_slots_size(table->element_size, old.capacity),
+            MEMORY_TAG_DICT
+        );
+        table->old_memory = 0;
+        table->old_capacity = 0;
+        table->rehash_index = 0;
+    }
+}
+
+static void finish_rehash(hashtable* table) {
+    rehash_step(table, INVALID_ID);
+}
+
+// Swaps in a zeroed block of new_capacity slots. The previous slots are
+// drained by the following operations. Returns false and leaves the table
+// untouched if the block cannot be allocated.
+static b8 begin_rehash(hashtable* table, u32 new_capacity) {
+    u64 size = get_slots_size(table->element_size, new_capacity);
+    void* memory = memory_allocate(size, MEMORY_TAG_DICT);
+    if (!memory) {
+        OKO_ERROR(
+            "hashtable - failed to allocate %u slots to grow into.", new_capacity
+        );
+        return false;
+    }
+
+    finish_rehash(table);
+    table->old_memory = table->memory;
+    table->old_capacity = table->capacity;
+    table->rehash_index = 0;
+    table->memory = memory;
+    table->capacity = new_capacity;
+    return true;
+}
+
+static b8 needs_growth(hashtable* table) {
+    return (u64)(table->count + 1) * MAX_LOAD_DENOMINATOR >
+           (u64)table->capacity * MAX_LOAD_NUMERATOR;
+}
+
+static b8 insert(hashtable* table, const char* name, u64 hash, void* value) {
+    rehash_step(table, REHASH_STEP);
+
+    slots current = current_slots(table);
+    u32 index = find_key(&current, name, hash);
+    if (index == INVALID_ID && table->old_memory) {
+        // Not moved yet, update it where it is.
+        slots old = old_slots(table);
+        u32 old_index = find_key(&old, name, hash);
+        if (old_index != INVALID_ID) {
+            memory_copy(get_value(&old, old_index), value, old.element_size);
+            return true;
+        }
+    }
+
+    if (index == INVALID_ID) {
+        if (table->is_growable && needs_growth(table)) {
+            if (!begin_rehash(table, table->capacity * 2)) {
+                return false;
+            }
+            current = current_slots(table);
+        }
+        index = find_slot(&current, name, hash);
+        if (index == INVALID_ID) {
+            OKO_ERROR(
+                "hashtable_set - table is full (%u entries), cannot add '%s'.",
+                table->capacity,
+                name
+            );
+            return false;
+        }
+        current.entries[index].key = string_duplicate(name);
+        current.entries[index].hash = hash;
+        table->count++;
+    }
+    memory_copy(get_value(&current, index), value, current.element_size);
+    return true;
+}
+
+static b8 lookup(
+    hashtable* table, const char* name, u64 hash, void* out_value
+) {
+    slots s = current_slots(table);
+    u32 index = find_key(&s, name, hash);
+    if (index == INVALID_ID && table->old_memory) {
+        s = old_slots(table);
+        index = find_key(&s, name, hash);
+    }
+    if (index == INVALID_ID) {
+        return false;
+    }
+    memory_copy(out_value, get_value(&s, index), s.element_size);
+    return true;
+}
+
+static void free_keys(slots* s) {
+    for (u32 i = 0; i < s->capacity; ++i) {
+        if (s->entries[i].key) {
+            memory_free(
+                s->entries[i].key,
+                string_length(s->entries[i].key) + 1,
+                MEMORY_TAG_STRING
+            );
+        }
     }
+}
 
-    // Mod it against the size of the table.
-    hash %= element_count;
+static void add_stats(
+    slots* s, u64* total_probe_length, hashtable_stats* out_stats
+) {
+    for (u32 i = 0; i < s->capacity; ++i) {
+        if (!s->entries[i].key) {
+            continue;
+        }
+        u32 home = get_home(s, s->entries[i].hash);
+        u32 probe_length = (i - home) & (s->capacity - 1);
+        *total_probe_length += probe_length;
+        if (probe_length > out_stats->max_probe_length) {
+            out_stats->max_probe_length = probe_length;
+        }
+    }
+}
 
-    return hash;
+u64 hashtable_get_memory_requirement(u64 element_size, u32 element_count) {
+    return get_slots_size(element_size, get_capacity(element_count));
 }
 
 void hashtable_create(
@@ -41,22 +312,107 @@ void hashtable_create(
         return;
     }
 
-    // TODO: Might want to require an allocator and allocate this memory
-    // instead.
+    memory_zero(out_hashtable, sizeof(hashtable));
     out_hashtable->memory = memory;
     out_hashtable->element_count = element_count;
     out_hashtable->element_size = element_size;
+    out_hashtable->capacity = get_capacity(element_count);
     out_hashtable->is_pointer_type = is_pointer_type;
-    memory_zero(out_hashtable->memory, element_size * element_count);
+    memory_zero(
+        out_hashtable->memory,
+        hashtable_get_memory_requirement(element_size, element_count)
+    );
+}
+
+b8 hashtable_create_growable(
+    u64 element_size,
+    u32 element_count,
+    b8 is_pointer_type,
+    hashtable* out_hashtable
+) {
+    if (!out_hashtable || !element_size) {
+        OKO_ERROR(
+            "hashtable_create_growable requires out_hashtable and a non-zero element_size."
+        );
+        return false;
+    }
+
+    memory_zero(out_hashtable, sizeof(hashtable));
+    out_hashtable->element_count = element_count;
+    out_hashtable->element_size = element_size;
+    out_hashtable->capacity = get_growable_capacity(element_count);
+    out_hashtable->is_pointer_type = is_pointer_type;
+    out_hashtable->is_growable = true;
+    out_hashtable->memory = memory_allocate(
+        get_slots_size(element_size, out_hashtable->capacity), MEMORY_TAG_DICT
+    );
+    if (!out_hashtable->memory) {
+        OKO_ERROR(
+            "hashtable_create_growable - failed to allocate %u slots.",
+            out_hashtable->capacity
+        );
+        memory_zero(out_hashtable, sizeof(hashtable));
+        return false;
+    }
+    return true;
 }
 
 void hashtable_destroy(hashtable* table) {
     if (table) {
-        // TODO: If using allocator above, free memory here.
+        if (table->memory) {
+            slots current = current_slots(table);
+            free_keys(&current);
+            if (table->is_growable) {
+                memory_free(
+                    table->memory,
+                    get_slots_size(table->element_size, table->capacity),
+                    MEMORY_TAG_DICT
+                );
+            }
+        }
+        if (table->old_memory) {
+            slots old = old_slots(table);
+            free_keys(&old);
+            memory_free(
+                table->old_memory,
+                get_slots_size(table->element_size, table->old_capacity),
+                MEMORY_TAG_DICT
+            );
+        }
         memory_zero(table, sizeof(hashtable));
     }
 }
 
+b8 hashtable_reserve(hashtable* table, u32 element_count) {
+    if (!table || !table->memory) {
+        OKO_WARN("hashtable_reserve requires a created table.");
+        return false;
+    }
+
+    if (!table->is_growable) {
+        if (element_count > table->capacity) {
+            OKO_ERROR(
+                "hashtable_reserve - fixed table holds %u entries, cannot reserve %u.",
+                table->capacity,
+                element_count
+            );
+            return false;
+        }
+        return true;
+    }
+
+    // Sized up front, so move everything at once rather than per operation.
+    u32 capacity = get_growable_capacity(element_count);
+    if (capacity > table->capacity) {
+        if (!begin_rehash(table, capacity)) {
+            return false;
+        }
+        table->element_count = element_count;
+    }
+    finish_rehash(table);
+    return true;
+}
+
 b8 hashtable_set(hashtable* table, const char* name, void* value) {
     if (!table || !name || !value) {
         OKO_ERROR("hashtable_set requires table, name and value to exist.");
@@ -69,11 +425,7 @@ b8 hashtable_set(hashtable* table, const char* name, void* value) {
         return false;
     }
 
-    u64 hash = hash_name(name, table->element_count);
-    memory_copy(
-        table->memory + (table->element_size * hash), value, table->element_size
-    );
-    return true;
+    return insert(table, name, hashtable_hash_name(name), value);
 }
 
 b8 hashtable_set_ptr(hashtable* table, const char* name, void** value) {
@@ -88,9 +440,11 @@ b8 hashtable_set_ptr(hashtable* table, const char* name, void** value) {
         return false;
     }
 
-    u64 hash = hash_name(name, table->element_count);
-    ((void**)table->memory)[hash] = value ? *value : 0;
-    return true;
+    if (!value || !*value) {
+        hashtable_remove(table, name);
+        return true;
+    }
+    return insert(table, name, hashtable_hash_name(name), value);
 }
 
 b8 hashtable_get(hashtable* table, const char* name, void* out_value) {
@@ -104,13 +458,8 @@ b8 hashtable_get(hashtable* table, const char* name, void* out_value) {
         );
         return false;
     }
-    u64 hash = hash_name(name, table->element_count);
-    memory_copy(
-        out_value,
-        table->memory + (table->element_size * hash),
-        table->element_size
-    );
-    return true;
+
+    return lookup(table, name, hashtable_hash_name(name), out_value);
 }
 
 b8 hashtable_get_ptr(hashtable* table, const char* name, void** out_value) {
@@ -127,11 +476,80 @@ b8 hashtable_get_ptr(hashtable* table, const char* name, void** out_value) {
         return false;
     }
 
-    u64 hash = hash_name(name, table->element_count);
-    *out_value = ((void**)table->memory)[hash];
+    if (!lookup(table, name, hashtable_hash_name(name), out_value)) {
+        *out_value = 0;
+    }
     return *out_value != 0;
 }
 
+b8 hashtable_remove(hashtable* table, const char* name) {
+    if (!table || !name) {
+        OKO_WARN("hashtable_remove requires table and name to exist.");
+        return false;
+    }
+
+    rehash_step(table, REHASH_STEP);
+
+    u64 hash = hashtable_hash_name(name);
+    slots s = current_slots(table);
+    u32 index = find_key(&s, name, hash);
+    if (index == INVALID_ID && table->old_memory) {
+        s = old_slots(table);
+        index = find_key(&s, name, hash);
+    }
+    if (index == INVALID_ID) {
+        return false;
+    }
+
+    char* key = s.entries[index].key;
+    memory_free(key, string_length(key) + 1, MEMORY_TAG_STRING);
+    take_out(&s, index);
+    table->count--;
+    return true;
+}
+
+u64 hashtable_hash_name(const char* name) {
+    return hash_string(name);
+}
+
+b8 hashtable_set_hashed(
+    hashtable* table, const char* name, u64 hash, void* value
+) {
+    if (!table || !name || !value) {
+        OKO_ERROR(
+            "hashtable_set_hashed requires table, name and value to exist."
+        );
+        return false;
+    }
+    if (table->is_pointer_type) {
+        OKO_ERROR(
+            "hashtable_set_hashed should not be used with tables that have pointer types. Use hashtable_set_ptr instead."
+        );
+        return false;
+    }
+
+    return insert(table, name, hash, value);
+}
+
+b8 hashtable_get_hashed(
+    hashtable* table, const char* name, u64 hash, void* out_value
+) {
+    if (!table || !name || !out_value) {
+        OKO_WARN(
+            "hashtable_get_hashed requires table, name and out_value to exist."
+        );
+        return false;
+    }
+    if (table->is_pointer_type) {
+        OKO_ERROR(
+            "hashtable_get_hashed should not be used with tables that have pointer types. Use hashtable_get_ptr instead."
+        );
+        return false;
+    }
+
+    return lookup(table, name, hash, out_value);
+}
+
 b8 hashtable_fill(hashtable* table, void* value) {
     if (!table || !value) {
         OKO_WARN("hashtable_fill requires table and value to exist.");
@@ -144,13 +562,35 @@ b8 hashtable_fill(hashtable* table, void* value) {
         return false;
     }
 
-    for (u32 i = 0; i < table->element_count; ++i) {
-        memory_copy(
-            table->memory + (table->element_size * i),
-            value,
-            table->element_size
-        );
+    finish_rehash(table);
+
+    slots current = current_slots(table);
+    for (u32 i = 0; i < current.capacity; ++i) {
+        if (current.entries[i].key) {
+            memory_copy(get_value(&current, i), value, current.element_size);
+        }
     }
 
     return true;
+}
+
+void hashtable_get_stats(hashtable* table, hashtable_stats* out_stats) {
+    memory_zero(out_stats, sizeof(hashtable_stats));
+    if (!table || !table->memory) {
+        return;
+    }
+
+    u64 total_probe_length = 0;
+    slots current = current_slots(table);
+    add_stats(&current, &total_probe_length, out_stats);
+    if (table->old_memory) {
+        slots old = old_slots(table);
+        add_stats(&old, &total_probe_length, out_stats);
+    }
+
+    out_stats->count = table->count;
+    out_stats->capacity = table->capacity;
+    out_stats->load_factor = (f32)table->count / table->capacity;
+    out_stats->average_probe_length =
+        table->count ? (f32)total_probe_length / table->count : 0.0f;
 }
\ No newline at end of file
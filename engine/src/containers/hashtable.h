@@ -2,16 +2,50 @@
 
 #include "defines.h"
 
+// Open addressing with linear probing. Each slot keeps the key's full hash and
+// a copy of the key, so colliding keys never overwrite each other. Removal
+// shifts the following entries back instead of leaving tombstones. The slot
+// count is element_count rounded up to a power of 2, so the home slot is a
+// mask of the hash.
+// Tables come in two flavours: fixed ones live in caller memory and fail once
+// full, growable ones own their slots and double them when passing 3/4 load.
+// A growing table keeps its previous slots until the following operations
+// have moved their entries over a few at a time, so no single call pays for
+// the whole rehash.
 // for non-pointer types, the table retains a copy of the value.
 // for pointer types, make sure to use the _ptr setter and getter.
 // table does not take ownership of pointers or associated memory.
 typedef struct hashtable {
     u64 element_size;
     u32 element_count;
+    // Slots, element_count rounded up to a power of 2.
+    u32 capacity;
+    // Number of keys currently stored.
+    u32 count;
     b8 is_pointer_type;
+    // Owns memory and grows, see hashtable_create_growable.
+    b8 is_growable;
+    // Slot entries followed by capacity values.
     void* memory;
+    // Slots still being moved into memory while growing, 0 otherwise.
+    void* old_memory;
+    u32 old_capacity;
+    // Old slots before this one are already empty.
+    u32 rehash_index;
 } hashtable;
 
+typedef struct hashtable_stats {
+    u32 count;
+    u32 capacity;
+    f32 load_factor;
+    // Slots each key sits past its home slot.
+    f32 average_probe_length;
+    u32 max_probe_length;
+} hashtable_stats;
+
+// Size of the block hashtable_create needs for element_count entries.
+OKO_API u64 hashtable_get_memory_requirement(u64 element_size, u32 element_count);
+
 OKO_API void hashtable_create(
     u64 element_size,
     u32 element_count,
@@ -20,17 +54,52 @@ OKO_API void hashtable_create(
     hashtable* out_hashtable
 );
 
+// Creates a table that allocates its own slots, sized to hold element_count
+// entries before it first grows. element_count may be 0.
+OKO_API b8 hashtable_create_growable(
+    u64 element_size,
+    u32 element_count,
+    b8 is_pointer_type,
+    hashtable* out_hashtable
+);
+
 OKO_API void hashtable_destroy(hashtable* hashtable);
 
+// Grows a growable table at once so element_count entries fit without further
+// rehashing. Fixed tables only check they are large enough.
+OKO_API b8 hashtable_reserve(hashtable* hashtable, u32 element_count);
+
+// Inserts or updates. Fails when a fixed table is full or a growable one
+// cannot allocate room to grow.
 OKO_API b8 hashtable_set(hashtable* hashtable, const char* name, void* value);
 
+// Setting a 0 pointer removes the entry.
 OKO_API b8
 hashtable_set_ptr(hashtable* hashtable, const char* name, void** value);
 
+// Returns false and leaves out_value untouched when name is not present.
 OKO_API b8
 hashtable_get(hashtable* hashtable, const char* name, void* out_value);
 
 OKO_API b8
 hashtable_get_ptr(hashtable* hashtable, const char* name, void** out_value);
 
-OKO_API b8 hashtable_fill(hashtable* hashtable, void* value);
\ No newline at end of file
+OKO_API b8 hashtable_remove(hashtable* hashtable, const char* name);
+
+// Hash used for name lookups. Hot paths can compute it once and pass it to
+// the _hashed calls below, which otherwise behave like set and get.
+OKO_API u64 hashtable_hash_name(const char* name);
+
+OKO_API b8 hashtable_set_hashed(
+    hashtable* hashtable, const char* name, u64 hash, void* value
+);
+
+OKO_API b8 hashtable_get_hashed(
+    hashtable* hashtable, const char* name, u64 hash, void* out_value
+);
+
+// Sets the value of every entry currently in the table.
+OKO_API b8 hashtable_fill(hashtable* hashtable, void* value);
+
+// Walks every slot, so intended for reporting only.
+OKO_API void hashtable_get_stats(hashtable* hashtable, hashtable_stats* out_stats);
\ No newline at end of file
@@ -0,0 +1,370 @@
+#include "ring_queue.h"
+
+#include "core/memory.h"
+#include "core/log.h"
+
+// Smallest power of 2 that holds capacity.
+static u32 get_capacity(u32 capacity) {
+    u32 rounded = 1;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+static u64 get_stride(u64 element_size, ring_queue_mode mode) {
+    if (mode != RING_QUEUE_MODE_MPMC) {
+        return element_size;
+    }
+    // Sequence number first, element padded so the next one stays aligned.
+    return sizeof(u64) + ((element_size + 7) & ~7ULL);
+}
+
+static u8* get_cell(ring_queue* queue, u64 position) {
+    u64 index = position & (queue->capacity - 1);
+    return (u8*)queue->memory + index * queue->stride;
+}
+
+static atomic_u64* get_sequence(u8* cell) {
+    return (atomic_u64*)cell;
+}
+
+static void* get_cell_value(u8* cell) {
+    return cell + sizeof(u64);
+}
+
+// Copies count elements into consecutive positions of a plain ring, in at
+// most two pieces around the wrap.
+static void copy_in(
+    ring_queue* queue, u64 position, const void* values, u32 count
+) {
+    u32 index = (u32)(position & (queue->capacity - 1));
+    u32 first = queue->capacity - index;
+    if (first > count) {
+        first = count;
+    }
+    memory_copy(get_cell(queue, position), values, first * queue->stride);
+    memory_copy(
+        queue->memory,
+        (const u8*)values + first * queue->stride,
+        (count - first) * queue->stride
+    );
+}
+
+static void copy_out(
+    ring_queue* queue, u64 position, void* out_values, u32 count
+) {
+    u32 index = (u32)(position & (queue->capacity - 1));
+    u32 first = queue->capacity - index;
+    if (first > count) {
+        first = count;
+    }
+    memory_copy(out_values, get_cell(queue, position), first * queue->stride);
+    memory_copy(
+        (u8*)out_values + first * queue->stride,
+        queue->memory,
+        (count - first) * queue->stride
+    );
+}
+
+static u32 enqueue_single_threaded(
+    ring_queue* queue, const void* values, u32 count
+) {
+    u64 position =
+        atomic_u64_load(&queue->enqueue_position, ATOMIC_ORDER_RELAXED);
+    u64 dequeued =
+        atomic_u64_load(&queue->dequeue_position, ATOMIC_ORDER_RELAXED);
+    u32 free = queue->capacity - (u32)(position - dequeued);
+    u32 taken = count < free ? count : free;
+    copy_in(queue, position, values, taken);
+    atomic_u64_store(
+        &queue->enqueue_position, position + taken, ATOMIC_ORDER_RELAXED
+    );
+    return taken;
+}
+
+static u32 dequeue_single_threaded(
+    ring_queue* queue, void* out_values, u32 max_count
+) {
+    u64 position =
+        atomic_u64_load(&queue->dequeue_position, ATOMIC_ORDER_RELAXED);
+    u64 enqueued =
+        atomic_u64_load(&queue->enqueue_position, ATOMIC_ORDER_RELAXED);
+    u32 available = (u32)(enqueued - position);
+    u32 taken = max_count < available ? max_count : available;
+    copy_out(queue, position, out_values, taken);
+    atomic_u64_store(
+        &queue->dequeue_position, position + taken, ATOMIC_ORDER_RELAXED
+    );
+    return taken;
+}
+
+// Only the producer writes enqueue_position, so it reads its own position
+// relaxed. The release store publishes the copied elements.
+static u32 enqueue_spsc(ring_queue* queue, const void* values, u32 count) {
+    u64 position =
+        atomic_u64_load(&queue->enqueue_position, ATOMIC_ORDER_RELAXED);
+    u32 free =
+        queue->capacity - (u32)(position - queue->cached_dequeue_position);
+    if (free < count) {
+        queue->cached_dequeue_position =
+            atomic_u64_load(&queue->dequeue_position, ATOMIC_ORDER_ACQUIRE);
+        free =
+            queue->capacity - (u32)(position - queue->cached_dequeue_position);
+    }
+
+    u32 taken = count < free ? count : free;
+    if (taken) {
+        copy_in(queue, position, values, taken);
+        atomic_u64_store(
+            &queue->enqueue_position, position + taken, ATOMIC_ORDER_RELEASE
+        );
+    }
+    return taken;
+}
+
+static u32 dequeue_spsc(ring_queue* queue, void* out_values, u32 max_count) {
+    u64 position =
+        atomic_u64_load(&queue->dequeue_position, ATOMIC_ORDER_RELAXED);
+    u32 available = (u32)(queue->cached_enqueue_position - position);
+    if (available < max_count) {
+        queue->cached_enqueue_position =
+            atomic_u64_load(&queue->enqueue_position, ATOMIC_ORDER_ACQUIRE);
+        available = (u32)(queue->cached_enqueue_position - position);
+    }
+
+    u32 taken = max_count < available ? max_count : available;
+    if (taken) {
+        copy_out(queue, position, out_values, taken);
+        atomic_u64_store(
+            &queue->dequeue_position, position + taken, ATOMIC_ORDER_RELEASE
+        );
+    }
+    return taken;
+}
+
+// A cell at position is free for this lap when its sequence equals position
+// and holds a value once it equals position + 1. Producers claim the run of
+// free cells starting at enqueue_position with one CAS. No other producer
+// can claim them afterwards, and consumers only touch published cells, so
+// the run stays free until it is written.
+static u32 enqueue_mpmc(ring_queue* queue, const void* values, u32 count) {
+    u64 position =
+        atomic_u64_load(&queue->enqueue_position, ATOMIC_ORDER_RELAXED);
+    u32 taken;
+    for (;;) {
+        taken = 0;
+        while (taken < count) {
+            u64 sequence = atomic_u64_load(
+                get_sequence(get_cell(queue, position + taken)),
+                ATOMIC_ORDER_ACQUIRE
+            );
+            if (sequence != position + taken) {
+                break;
+            }
+            taken++;
+        }
+
+        if (taken == 0) {
+            u64 sequence = atomic_u64_load(
+                get_sequence(get_cell(queue, position)), ATOMIC_ORDER_ACQUIRE
+            );
+            if ((i64)(sequence - position) < 0) {
+                // Last lap's value is still there: full.
+                return 0;
+            }
+            // Another producer got here first.
+            position =
+                atomic_u64_load(&queue->enqueue_position, ATOMIC_ORDER_RELAXED);
+            continue;
+        }
+
+        if (atomic_u64_compare_exchange(
+                &queue->enqueue_position,
+                &position,
+                position + taken,
+                ATOMIC_ORDER_RELAXED
+            )) {
+            break;
+        }
+    }
+
+    for (u32 i = 0; i < taken; ++i) {
+        u8* cell = get_cell(queue, position + i);
+        memory_copy(
+            get_cell_value(cell),
+            (const u8*)values + i * queue->element_size,
+            queue->element_size
+        );
+        atomic_u64_store(
+            get_sequence(cell), position + i + 1, ATOMIC_ORDER_RELEASE
+        );
+    }
+    return taken;
+}
+
+static u32 dequeue_mpmc(ring_queue* queue, void* out_values, u32 max_count) {
+    u64 position =
+        atomic_u64_load(&queue->dequeue_position, ATOMIC_ORDER_RELAXED);
+    u32 taken;
+    for (;;) {
+        taken = 0;
+        while (taken < max_count) {
+            u64 sequence = atomic_u64_load(
+                get_sequence(get_cell(queue, position + taken)),
+                ATOMIC_ORDER_ACQUIRE
+            );
+            if (sequence != position + taken + 1) {
+                break;
+            }
+            taken++;
+        }
+
+        if (taken == 0) {
+            u64 sequence = atomic_u64_load(
+                get_sequence(get_cell(queue, position)), ATOMIC_ORDER_ACQUIRE
+            );
+            if ((i64)(sequence - (position + 1)) < 0) {
+                // Not written yet on this lap: empty.
+                return 0;
+            }
+            position =
+                atomic_u64_load(&queue->dequeue_position, ATOMIC_ORDER_RELAXED);
+            continue;
+        }
+
+        if (atomic_u64_compare_exchange(
+                &queue->dequeue_position,
+                &position,
+                position + taken,
+                ATOMIC_ORDER_RELAXED
+            )) {
+            break;
+        }
+    }
+
+    for (u32 i = 0; i < taken; ++i) {
+        u8* cell = get_cell(queue, position + i);
+        memory_copy(
+            (u8*)out_values + i * queue->element_size,
+            get_cell_value(cell),
+            queue->element_size
+        );
+        // Free for the producer one lap ahead.
+        atomic_u64_store(
+            get_sequence(cell),
+            position + i + queue->capacity,
+            ATOMIC_ORDER_RELEASE
+        );
+    }
+    return taken;
+}
+
+u64 ring_queue_get_memory_requirement(
+    u64 element_size, u32 capacity, ring_queue_mode mode
+) {
+    return get_stride(element_size, mode) * get_capacity(capacity);
+}
+
+b8 ring_queue_create(
+    u64 element_size,
+    u32 capacity,
+    ring_queue_mode mode,
+    void* memory,
+    ring_queue* out_queue
+) {
+    if (!out_queue || !element_size || !capacity) {
+        OKO_ERROR(
+            "ring_queue_create requires out_queue and a non-zero element_size and capacity."
+        );
+        return false;
+    }
+
+    memory_zero(out_queue, sizeof(ring_queue));
+    out_queue->element_size = element_size;
+    out_queue->stride = get_stride(element_size, mode);
+    out_queue->capacity = get_capacity(capacity);
+    out_queue->mode = mode;
+    out_queue->owns_memory = memory == 0;
+
+    u64 size = ring_queue_get_memory_requirement(element_size, capacity, mode);
+    out_queue->memory =
+        memory ? memory : memory_allocate(size, MEMORY_TAG_RING_QUEUE);
+    if (!out_queue->memory) {
+        OKO_ERROR("ring_queue_create - failed to allocate %llu bytes.", size);
+        return false;
+    }
+
+    if (mode == RING_QUEUE_MODE_MPMC) {
+        for (u32 i = 0; i < out_queue->capacity; ++i) {
+            atomic_u64_store(
+                get_sequence(get_cell(out_queue, i)), i, ATOMIC_ORDER_RELAXED
+            );
+        }
+    }
+    return true;
+}
+
+void ring_queue_destroy(ring_queue* queue) {
+    if (queue) {
+        if (queue->owns_memory && queue->memory) {
+            memory_free(
+                queue->memory,
+                queue->stride * queue->capacity,
+                MEMORY_TAG_RING_QUEUE
+            );
+        }
+        memory_zero(queue, sizeof(ring_queue));
+    }
+}
+
+b8 ring_queue_enqueue(ring_queue* queue, const void* value) {
+    return ring_queue_enqueue_batch(queue, value, 1) == 1;
+}
+
+b8 ring_queue_dequeue(ring_queue* queue, void* out_value) {
+    return ring_queue_dequeue_batch(queue, out_value, 1) == 1;
+}
+
+u32 ring_queue_enqueue_batch(
+    ring_queue* queue, const void* values, u32 count
+) {
+    switch (queue->mode) {
+        case RING_QUEUE_MODE_SINGLE_THREADED:
+            return enqueue_single_threaded(queue, values, count);
+        case RING_QUEUE_MODE_SPSC:
+            return enqueue_spsc(queue, values, count);
+        case RING_QUEUE_MODE_MPMC:
+            return enqueue_mpmc(queue, values, count);
+    }
+    return 0;
+}
+
+u32 ring_queue_dequeue_batch(
+    ring_queue* queue, void* out_values, u32 max_count
+) {
+    switch (queue->mode) {
+        case RING_QUEUE_MODE_SINGLE_THREADED:
+            return dequeue_single_threaded(queue, out_values, max_count);
+        case RING_QUEUE_MODE_SPSC:
+            return dequeue_spsc(queue, out_values, max_count);
+        case RING_QUEUE_MODE_MPMC:
+            return dequeue_mpmc(queue, out_values, max_count);
+    }
+    return 0;
+}
+
+u32 ring_queue_count(ring_queue* queue) {
+    u64 dequeued =
+        atomic_u64_load(&queue->dequeue_position, ATOMIC_ORDER_RELAXED);
+    u64 enqueued =
+        atomic_u64_load(&queue->enqueue_position, ATOMIC_ORDER_RELAXED);
+    // Read in this order the difference cannot go negative, but it can
+    // overshoot while producers race ahead.
+    u64 count = enqueued - dequeued;
+    return count > queue->capacity ? queue->capacity : (u32)count;
+}
+
+u64 ring_queue_get_enqueued(ring_queue* queue) {
+    return atomic_u64_load(&queue->enqueue_position, ATOMIC_ORDER_ACQUIRE);
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "defines.h"
+
+#include "platform/atomic.h"
+
+// Fixed-capacity FIFO of equally sized elements. The capacity is rounded up
+// to a power of 2 and positions only ever grow, so wrapping is a mask.
+//   SINGLE_THREADED: no synchronization at all.
+//   SPSC: one producer thread and one consumer thread, lock-free. Each side
+//         keeps a cached copy of the other side's position and only reloads
+//         it when the queue looks full or empty.
+//   MPMC: any number of producers and consumers, lock-free after Dmitry
+//         Vyukov's bounded queue. Every cell carries a sequence number that
+//         says whether it is ready to be written or read on the current lap.
+// Batch calls move as many elements as fit, in one claim, and return how
+// many that was.
+typedef enum ring_queue_mode {
+    RING_QUEUE_MODE_SINGLE_THREADED,
+    RING_QUEUE_MODE_SPSC,
+    RING_QUEUE_MODE_MPMC
+} ring_queue_mode;
+
+typedef struct ring_queue {
+    u64 element_size;
+    // Bytes per cell, including the MPMC sequence number.
+    u64 stride;
+    u32 capacity;
+    ring_queue_mode mode;
+    b8 owns_memory;
+    void* memory;
+
+    // Producer side, kept off the consumer's cache line.
+    OKO_CACHE_ALIGNED atomic_u64 enqueue_position;
+    // SPSC producer's last seen dequeue_position.
+    u64 cached_dequeue_position;
+
+    // Consumer side.
+    OKO_CACHE_ALIGNED atomic_u64 dequeue_position;
+    // SPSC consumer's last seen enqueue_position.
+    u64 cached_enqueue_position;
+} ring_queue;
+
+OKO_API u64 ring_queue_get_memory_requirement(
+    u64 element_size, u32 capacity, ring_queue_mode mode
+);
+
+// Pass 0 as memory to have the queue allocate, and free, its own cells.
+// The queue must not move while threads use it.
+OKO_API b8 ring_queue_create(
+    u64 element_size,
+    u32 capacity,
+    ring_queue_mode mode,
+    void* memory,
+    ring_queue* out_queue
+);
+
+OKO_API void ring_queue_destroy(ring_queue* queue);
+
+// Returns false when the queue is full.
+OKO_API b8 ring_queue_enqueue(ring_queue* queue, const void* value);
+
+// Returns false when the queue is empty.
+OKO_API b8 ring_queue_dequeue(ring_queue* queue, void* out_value);
+
+// Enqueues up to count contiguous elements, returns how many were taken.
+OKO_API u32
+ring_queue_enqueue_batch(ring_queue* queue, const void* values, u32 count);
+
+// Dequeues up to max_count elements, returns how many were written.
+OKO_API u32
+ring_queue_dequeue_batch(ring_queue* queue, void* out_values, u32 max_count);
+
+// Exact when single threaded, a snapshot otherwise.
+OKO_API u32 ring_queue_count(ring_queue* queue);
+
+// Total elements enqueued since create, for waiting on a consumer to catch
+// up.
+OKO_API u64 ring_queue_get_enqueued(ring_queue* queue);
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "slot_map.h"
+
+#include "core/memory.h"
+#include "core/log.h"
+
+typedef struct slot_map_slot {
+    // Dense index while live, next free slot while free.
+    u32 index;
+    u32 generation;
+} slot_map_slot;
+
+// Slot and dense arrays, padded so elements start 16 byte aligned.
+static u64 get_index_size(u32 capacity) {
+    u64 size = capacity * (sizeof(slot_map_slot) + sizeof(u32));
+    return (size + 15) & ~15ULL;
+}
+
+static slot_handle make_handle(u32 index, u32 generation) {
+    return (generation << SLOT_MAP_INDEX_BITS) | index;
+}
+
+// Slot of a live handle, 0 otherwise. A free slot is never the target of a
+// dense entry, which keeps forged handles out too.
+static slot_map_slot* get_live_slot(slot_map* map, slot_handle handle) {
+    u32 index = slot_handle_index(handle);
+    if (index >= map->capacity) {
+        return 0;
+    }
+    slot_map_slot* slot = &map->slots[index];
+    if (slot->generation != handle >> SLOT_MAP_INDEX_BITS ||
+        slot->index >= map->count || map->dense_slots[slot->index] != index) {
+        return 0;
+    }
+    return slot;
+}
+
+u64 slot_map_get_memory_requirement(u64 element_size, u32 capacity) {
+    return get_index_size(capacity) + element_size * capacity;
+}
+
+b8 slot_map_create(
+    u64 element_size, u32 capacity, void* memory, slot_map* out_map
+) {
+    if (!out_map || !capacity || capacity > SLOT_MAP_MAX_CAPACITY) {
+        OKO_ERROR(
+            "slot_map_create requires out_map and a capacity between 1 and %u.",
+            SLOT_MAP_MAX_CAPACITY
+        );
+        return false;
+    }
+
+    memory_zero(out_map, sizeof(slot_map));
+    u64 size = slot_map_get_memory_requirement(element_size, capacity);
+    out_map->owns_memory = memory == 0;
+    if (!memory) {
+        memory = memory_allocate(size, MEMORY_TAG_ARRAY);
+        if (!memory) {
+            OKO_ERROR("slot_map_create - failed to allocate %llu bytes.", size);
+            return false;
+        }
+    }
+
+    out_map->element_size = element_size;
+    out_map->capacity = capacity;
+    out_map->slots = memory;
+    out_map->dense_slots = (u32*)(out_map->slots + capacity);
+    out_map->elements = (u8*)memory + get_index_size(capacity);
+
+    // Every slot free, chained in order.
+    for (u32 i = 0; i < capacity; ++i) {
+        out_map->slots[i].index = i + 1;
+        out_map->slots[i].generation = 0;
+    }
+    out_map->slots[capacity - 1].index = INVALID_ID;
+    out_map->free_head = 0;
+    out_map->free_tail = capacity - 1;
+    return true;
+}
+
+void slot_map_destroy(slot_map* map) {
+    if (map) {
+        if (map->owns_memory && map->slots) {
+            memory_free(
+                map->slots,
+                slot_map_get_memory_requirement(
+                    map->element_size, map->capacity
+                ),
+                MEMORY_TAG_ARRAY
+            );
+        }
+        memory_zero(map, sizeof(slot_map));
+    }
+}
+
+slot_handle slot_map_insert(slot_map* map, const void* value) {
+    if (map->free_head == INVALID_ID) {
+        OKO_WARN(
+            "slot_map_insert - map is full (%u elements).", map->capacity
+        );
+        return INVALID_ID;
+    }
+
+    u32 index = map->free_head;
+    slot_map_slot* slot = &map->slots[index];
+    map->free_head = slot->index;
+    if (map->free_head == INVALID_ID) {
+        map->free_tail = INVALID_ID;
+    }
+
+    u32 dense_index = map->count++;
+    slot->index = dense_index;
+    map->dense_slots[dense_index] = index;
+    void* element = (u8*)map->elements + dense_index * map->element_size;
+    if (value) {
+        memory_copy(element, value, map->element_size);
+    } else {
+        memory_zero(element, map->element_size);
+    }
+    return make_handle(index, slot->generation);
+}
+
+b8 slot_map_remove(slot_map* map, slot_handle handle) {
+    slot_map_slot* slot = get_live_slot(map, handle);
+    if (!slot) {
+        return false;
+    }
+
+    // Keep the elements packed: the last one fills the gap.
+    u32 dense_index = slot->index;
+    u32 last = --map->count;
+    if (dense_index != last) {
+        memory_copy(
+            (u8*)map->elements + dense_index * map->element_size,
+            (u8*)map->elements + last * map->element_size,
+            map->element_size
+        );
+        u32 moved = map->dense_slots[last];
+        map->dense_slots[dense_index] = moved;
+        map->slots[moved].index = dense_index;
+    }
+
+    // Stale from here on, and queued behind every other free slot.
+    u32 index = slot_handle_index(handle);
+    slot->generation = (slot->generation + 1) & SLOT_MAP_GENERATION_MAX;
+    slot->index = INVALID_ID;
+    if (map->free_tail == INVALID_ID) {
+        map->free_head = index;
+    } else {
+        map->slots[map->free_tail].index = index;
+    }
+    map->free_tail = index;
+    return true;
+}
+
+b8 slot_map_is_valid(slot_map* map, slot_handle handle) {
+    return get_live_slot(map, handle) != 0;
+}
+
+void* slot_map_get(slot_map* map, slot_handle handle) {
+    slot_map_slot* slot = get_live_slot(map, handle);
+    if (!slot) {
+        return 0;
+    }
+    return (u8*)map->elements + slot->index * map->element_size;
+}
+
+void* slot_map_elements(slot_map* map) {
+    return map->elements;
+}
+
+slot_handle slot_map_handle_at(slot_map* map, u32 dense_index) {
+    if (dense_index >= map->count) {
+        return INVALID_ID;
+    }
+    u32 index = map->dense_slots[dense_index];
+    return make_handle(index, map->slots[index].generation);
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "defines.h"
+
+// Handle to an element of a slot_map: the slot index in the low
+// SLOT_MAP_INDEX_BITS bits and the slot's generation above them. Removing an
+// element bumps its slot's generation, so handles to it go stale instead of
+// silently naming whatever reuses the slot. The first handle a map hands
+// out is 0, INVALID_ID is never a valid handle.
+typedef u32 slot_handle;
+
+#define SLOT_MAP_INDEX_BITS     20
+#define SLOT_MAP_INDEX_MASK     ((1u << SLOT_MAP_INDEX_BITS) - 1)
+#define SLOT_MAP_GENERATION_MAX (0xFFFFFFFFu >> SLOT_MAP_INDEX_BITS)
+// The all-ones index is left out so no handle equals INVALID_ID.
+#define SLOT_MAP_MAX_CAPACITY   SLOT_MAP_INDEX_MASK
+
+// Slot index of a handle, stable for the element's lifetime. Usable to index
+// parallel arrays sized to the map's capacity.
+#define slot_handle_index(handle) ((handle) & SLOT_MAP_INDEX_MASK)
+
+// Fixed-capacity container addressed by generational handles. Handles go
+// through one level of indirection, the slot, to the element's place in a
+// dense array. Elements stay packed at the front of that array for tight
+// iteration; removal moves the last element into the gap. Freed slots are
+// reused oldest first, which spreads generations over all slots and makes
+// a stale handle matching again as unlikely as possible.
+// element_size may be 0 to only hand out handles.
+typedef struct slot_map {
+    u64 element_size;
+    u32 capacity;
+    u32 count;
+    // Oldest and newest free slot, INVALID_ID when there are none.
+    u32 free_head;
+    u32 free_tail;
+    b8 owns_memory;
+    // capacity slots: dense index or next free slot, and generation.
+    struct slot_map_slot* slots;
+    // Slot of each dense element.
+    u32* dense_slots;
+    // count packed elements.
+    void* elements;
+} slot_map;
+
+OKO_API u64 slot_map_get_memory_requirement(u64 element_size, u32 capacity);
+
+// Pass 0 as memory to have the map allocate, and free, its own block.
+OKO_API b8 slot_map_create(
+    u64 element_size, u32 capacity, void* memory, slot_map* out_map
+);
+
+OKO_API void slot_map_destroy(slot_map* map);
+
+// Copies value into a free slot, or zeroes it if value is 0. Returns
+// INVALID_ID when the map is full.
+OKO_API slot_handle slot_map_insert(slot_map* map, const void* value);
+
+// Returns false for stale or invalid handles.
+OKO_API b8 slot_map_remove(slot_map* map, slot_handle handle);
+
+OKO_API b8 slot_map_is_valid(slot_map* map, slot_handle handle);
+
+// Element of a live handle, 0 otherwise. Removals move elements, so the
+// pointer is only good until the next one.
+OKO_API void* slot_map_get(slot_map* map, slot_handle handle);
+
+// The count live elements, packed. For iteration, together with
+// slot_map_handle_at.
+OKO_API void* slot_map_elements(slot_map* map);
+
+// Handle of the element at dense_index.
+OKO_API slot_handle slot_map_handle_at(slot_map* map, u32 dense_index);
\ No newline at end of file
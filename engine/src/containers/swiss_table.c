@@ -0,0 +1,493 @@
+#include "swiss_table.h"
+
+#include "core/memory.h"
+#include "core/log.h"
+#include "core/hash.h"
+#include "containers/string.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+  #include <emmintrin.h>
+  #define SWISS_TABLE_SSE2 1
+#else
+  #define SWISS_TABLE_SSE2 0
+#endif
+
+// Control bytes. Full slots hold the low 7 bits of the key's hash, so only
+// the special values have the top bit set.
+#define CTRL_EMPTY   0x80
+#define CTRL_DELETED 0xFE
+
+#define GROUP_WIDTH 16
+
+// Slots keep the value right after the entry, so a hit touches the control
+// bytes, one slot and the key.
+typedef struct swiss_table_entry {
+    u64 hash;
+    // Owned copy of the key, only valid while the control byte is full.
+    char* key;
+} swiss_table_entry;
+
+// Bitmasks below have bit i set when group byte i matches.
+#if SWISS_TABLE_SSE2
+static u32 match_tag(const u8* group, u8 tag) {
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+    __m128i matches = _mm_cmpeq_epi8(ctrl, _mm_set1_epi8((i8)tag));
+    return (u32)_mm_movemask_epi8(matches);
+}
+
+static u32 match_empty_or_deleted(const u8* group) {
+    return (u32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+}
+#else
+static u32 match_tag(const u8* group, u8 tag) {
+    u32 mask = 0;
+    for (u32 i = 0; i < GROUP_WIDTH; ++i) {
+        mask |= (u32)(group[i] == tag) << i;
+    }
+    return mask;
+}
+
+static u32 match_empty_or_deleted(const u8* group) {
+    u32 mask = 0;
+    for (u32 i = 0; i < GROUP_WIDTH; ++i) {
+        mask |= (u32)(group[i] >> 7) << i;
+    }
+    return mask;
+}
+#endif
+
+static u32 match_empty(const u8* group) {
+    return match_tag(group, CTRL_EMPTY);
+}
+
+// Control bytes are followed by a copy of the first group, so a group can
+// start at any slot without wrapping.
+static u64 get_ctrl_size(u32 capacity) {
+    return (u64)capacity + GROUP_WIDTH;
+}
+
+static u64 get_slot_size(u64 element_size) {
+    return sizeof(swiss_table_entry) + ((element_size + 7) & ~7ULL);
+}
+
+static u64 get_memory_size(u64 element_size, u32 capacity) {
+    return get_ctrl_size(capacity) + get_slot_size(element_size) * capacity;
+}
+
+// Slots usable before the table has to grow.
+static u32 get_max_load(u32 capacity) {
+    return capacity - capacity / 8;
+}
+
+// Smallest power of 2 of at least one group whose max load holds
+// element_count.
+static u32 get_capacity(u32 element_count) {
+    u32 capacity = GROUP_WIDTH;
+    while (get_max_load(capacity) < element_count) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+static u8* get_ctrl(swiss_table* table) {
+    return table->memory;
+}
+
+static swiss_table_entry* get_entry(swiss_table* table, u32 index) {
+    u8* slots = (u8*)table->memory + get_ctrl_size(table->capacity);
+    return (swiss_table_entry*)(slots +
+                                get_slot_size(table->element_size) * index);
+}
+
+static void* get_value(swiss_table* table, u32 index) {
+    return get_entry(table, index) + 1;
+}
+
+static u8 get_tag(u64 hash) {
+    return (u8)(hash & 0x7F);
+}
+
+static u32 get_home(swiss_table* table, u64 hash) {
+    return (u32)(hash >> 7) & (table->capacity - 1);
+}
+
+static void set_ctrl(swiss_table* table, u32 index, u8 value) {
+    u8* ctrl = get_ctrl(table);
+    ctrl[index] = value;
+    if (index < GROUP_WIDTH) {
+        ctrl[table->capacity + index] = value;
+    }
+}
+
+// Groups start at the home slot and move on by 1, 2, 3... groups. With a
+// power of 2 capacity this visits every group once.
+static u32 next_group(swiss_table* table, u32 position, u32 probe) {
+    return (position + (probe + 1) * GROUP_WIDTH) & (table->capacity - 1);
+}
+
+// Index of the slot holding name, INVALID_ID if it is not there.
+static u32 find(swiss_table* table, const char* name, u64 hash) {
+    u8* ctrl = get_ctrl(table);
+    u32 mask = table->capacity - 1;
+    u32 group_count = table->capacity / GROUP_WIDTH;
+    u8 tag = get_tag(hash);
+    u32 position = get_home(table, hash);
+    for (u32 probe = 0; probe < group_count; ++probe) {
+        const u8* group = ctrl + position;
+        u32 matches = match_tag(group, tag);
+        while (matches) {
+            u32 index = (position + __builtin_ctz(matches)) & mask;
+            swiss_table_entry* entry = get_entry(table, index);
+            if (entry->hash == hash && strings_equal(entry->key, name)) {
+                return index;
+            }
+            matches &= matches - 1;
+        }
+        // An empty slot ends every probe sequence that could reach name.
+        if (match_empty(group)) {
+            return INVALID_ID;
+        }
+        position = next_group(table, position, probe);
+    }
+    return INVALID_ID;
+}
+
+// First empty or deleted slot on hash's probe sequence. The max load keeps at
+// least one empty slot around, so there always is one.
+static u32 find_free_slot(swiss_table* table, u64 hash) {
+    u8* ctrl = get_ctrl(table);
+    u32 position = get_home(table, hash);
+    for (u32 probe = 0;; ++probe) {
+        u32 free_slots = match_empty_or_deleted(ctrl + position);
+        if (free_slots) {
+            return (position + __builtin_ctz(free_slots)) &
+                   (table->capacity - 1);
+        }
+        position = next_group(table, position, probe);
+    }
+}
+
+static b8 allocate_slots(swiss_table* table, u32 capacity) {
+    void* memory = memory_allocate_uninitialized(
+        get_memory_size(table->element_size, capacity), MEMORY_TAG_DICT
+    );
+    if (!memory) {
+        OKO_ERROR(
+            "swiss_table - failed to allocate %u slots of %llu bytes.",
+            capacity,
+            table->element_size
+        );
+        return false;
+    }
+    // Entries and values are only read behind a full control byte.
+    memory_set(memory, CTRL_EMPTY, get_ctrl_size(capacity));
+    table->memory = memory;
+    table->capacity = capacity;
+    table->growth_left = get_max_load(capacity) - table->count;
+    return true;
+}
+
+// Moves every entry into a new block of capacity slots, which also drops
+// deleted markers.
+static b8 rehash(swiss_table* table, u32 capacity) {
+    swiss_table old = *table;
+    if (!allocate_slots(table, capacity)) {
+        *table = old;
+        return false;
+    }
+
+    u8* old_ctrl = get_ctrl(&old);
+    u64 slot_size = get_slot_size(table->element_size);
+    for (u32 i = 0; i < old.capacity; ++i) {
+        if (old_ctrl[i] & 0x80) {
+            continue;
+        }
+        swiss_table_entry* entry = get_entry(&old, i);
+        u32 index = find_free_slot(table, entry->hash);
+        set_ctrl(table, index, get_tag(entry->hash));
+        memory_copy(get_entry(table, index), entry, slot_size);
+    }
+
+    memory_free(
+        old.memory,
+        get_memory_size(old.element_size, old.capacity),
+        MEMORY_TAG_DICT
+    );
+    return true;
+}
+
+static b8 insert(swiss_table* table, const char* name, u64 hash, void* value) {
+    u32 index = find(table, name, hash);
+    if (index != INVALID_ID) {
+        memory_copy(get_value(table, index), value, table->element_size);
+        return true;
+    }
+
+    index = find_free_slot(table, hash);
+    if (table->growth_left == 0 && get_ctrl(table)[index] == CTRL_EMPTY) {
+        // Up to 25/32 full, dropping the deleted markers frees enough slots.
+        u32 capacity = (u64)table->count * 32 <= (u64)table->capacity * 25
+                           ? table->capacity
+                           : table->capacity * 2;
+        if (!rehash(table, capacity)) {
+            return false;
+        }
+        index = find_free_slot(table, hash);
+    }
+
+    if (get_ctrl(table)[index] == CTRL_EMPTY) {
+        table->growth_left--;
+    }
+    set_ctrl(table, index, get_tag(hash));
+    swiss_table_entry* entry = get_entry(table, index);
+    entry->hash = hash;
+    entry->key = string_duplicate(name);
+    memory_copy(get_value(table, index), value, table->element_size);
+    table->count++;
+    return true;
+}
+
+b8 swiss_table_create(
+    u64 element_size,
+    u32 element_count,
+    b8 is_pointer_type,
+    swiss_table* out_table
+) {
+    if (!out_table || !element_size) {
+        OKO_ERROR(
+            "swiss_table_create requires out_table and a non-zero element_size."
+        );
+        return false;
+    }
+
+    memory_zero(out_table, sizeof(swiss_table));
+    out_table->element_size = element_size;
+    out_table->is_pointer_type = is_pointer_type;
+    return allocate_slots(out_table, get_capacity(element_count));
+}
+
+void swiss_table_destroy(swiss_table* table) {
+    if (table) {
+        if (table->memory) {
+            u8* ctrl = get_ctrl(table);
+            for (u32 i = 0; i < table->capacity; ++i) {
+                if (!(ctrl[i] & 0x80)) {
+                    char* key = get_entry(table, i)->key;
+                    memory_free(
+                        key, string_length(key) + 1, MEMORY_TAG_STRING
+                    );
+                }
+            }
+            memory_free(
+                table->memory,
+                get_memory_size(table->element_size, table->capacity),
+                MEMORY_TAG_DICT
+            );
+        }
+        memory_zero(table, sizeof(swiss_table));
+    }
+}
+
+b8 swiss_table_reserve(swiss_table* table, u32 element_count) {
+    if (!table || !table->memory) {
+        OKO_WARN("swiss_table_reserve requires a created table.");
+        return false;
+    }
+
+    u32 capacity = get_capacity(element_count);
+    if (capacity <= table->capacity) {
+        return true;
+    }
+    return rehash(table, capacity);
+}
+
+b8 swiss_table_set(swiss_table* table, const char* name, void* value) {
+    if (!table || !name || !value) {
+        OKO_ERROR("swiss_table_set requires table, name and value to exist.");
+        return false;
+    }
+    if (table->is_pointer_type) {
+        OKO_ERROR(
+            "swiss_table_set should not be used with tables that have pointer types. Use swiss_table_set_ptr instead."
+        );
+        return false;
+    }
+
+    return insert(table, name, hash_string(name), value);
+}
+
+b8 swiss_table_set_ptr(swiss_table* table, const char* name, void** value) {
+    if (!table || !name) {
+        OKO_WARN("swiss_table_set_ptr requires table and name to exist.");
+        return false;
+    }
+    if (!table->is_pointer_type) {
+        OKO_ERROR(
+            "swiss_table_set_ptr should not be used with tables that do not have pointer types. Use swiss_table_set instead."
+        );
+        return false;
+    }
+
+    if (!value || !*value) {
+        swiss_table_remove(table, name);
+        return true;
+    }
+    return insert(table, name, hash_string(name), value);
+}
+
+b8 swiss_table_get(swiss_table* table, const char* name, void* out_value) {
+    if (!table || !name || !out_value) {
+        OKO_WARN(
+            "swiss_table_get requires table, name and out_value to exist."
+        );
+        return false;
+    }
+    if (table->is_pointer_type) {
+        OKO_ERROR(
+            "swiss_table_get should not be used with tables that have pointer types. Use swiss_table_get_ptr instead."
+        );
+        return false;
+    }
+
+    u32 index = find(table, name, hash_string(name));
+    if (index == INVALID_ID) {
+        return false;
+    }
+    memory_copy(out_value, get_value(table, index), table->element_size);
+    return true;
+}
+
+b8 swiss_table_get_ptr(
+    swiss_table* table, const char* name, void** out_value
+) {
+    if (!table || !name || !out_value) {
+        OKO_WARN(
+            "swiss_table_get_ptr requires table, name and out_value to exist."
+        );
+        return false;
+    }
+    if (!table->is_pointer_type) {
+        OKO_ERROR(
+            "swiss_table_get_ptr should not be used with tables that do not have pointer types. Use swiss_table_get instead."
+        );
+        return false;
+    }
+
+    u32 index = find(table, name, hash_string(name));
+    *out_value = index == INVALID_ID ? 0 : *(void**)get_value(table, index);
+    return *out_value != 0;
+}
+
+b8 swiss_table_remove(swiss_table* table, const char* name) {
+    if (!table || !name) {
+        OKO_WARN("swiss_table_remove requires table and name to exist.");
+        return false;
+    }
+
+    u32 index = find(table, name, hash_string(name));
+    if (index == INVALID_ID) {
+        return false;
+    }
+
+    swiss_table_entry* entry = get_entry(table, index);
+    memory_free(entry->key, string_length(entry->key) + 1, MEMORY_TAG_STRING);
+    entry->key = 0;
+
+    // If the empty slots around this one are less than a group apart, no
+    // probe ever saw a full group here and it can go back to empty. Otherwise
+    // probes may have passed through it, so it has to stay marked.
+    u8* ctrl = get_ctrl(table);
+    u32 before = (index - GROUP_WIDTH) & (table->capacity - 1);
+    u32 empty_before = match_empty(ctrl + before);
+    u32 empty_after = match_empty(ctrl + index);
+    b8 never_full = empty_before && empty_after &&
+                    (u32)__builtin_clz(empty_before) - (32 - GROUP_WIDTH) +
+                            (u32)__builtin_ctz(empty_after) <
+                        GROUP_WIDTH;
+    if (never_full) {
+        set_ctrl(table, index, CTRL_EMPTY);
+        table->growth_left++;
+    } else {
+        set_ctrl(table, index, CTRL_DELETED);
+    }
+    table->count--;
+    return true;
+}
+
+b8 swiss_table_set_hashed(
+    swiss_table* table, const char* name, u64 hash, void* value
+) {
+    if (!table || !name || !value) {
+        OKO_ERROR(
+            "swiss_table_set_hashed requires table, name and value to exist."
+        );
+        return false;
+    }
+    if (table->is_pointer_type) {
+        OKO_ERROR(
+            "swiss_table_set_hashed should not be used with tables that have pointer types. Use swiss_table_set_ptr instead."
+        );
+        return false;
+    }
+
+    return insert(table, name, hash, value);
+}
+
+b8 swiss_table_get_hashed(
+    swiss_table* table, const char* name, u64 hash, void* out_value
+) {
+    if (!table || !name || !out_value) {
+        OKO_WARN(
+            "swiss_table_get_hashed requires table, name and out_value to exist."
+        );
+        return false;
+    }
+    if (table->is_pointer_type) {
+        OKO_ERROR(
+            "swiss_table_get_hashed should not be used with tables that have pointer types. Use swiss_table_get_ptr instead."
+        );
+        return false;
+    }
+
+    u32 index = find(table, name, hash);
+    if (index == INVALID_ID) {
+        return false;
+    }
+    memory_copy(out_value, get_value(table, index), table->element_size);
+    return true;
+}
+
+void swiss_table_get_stats(swiss_table* table, swiss_table_stats* out_stats) {
+    memory_zero(out_stats, sizeof(swiss_table_stats));
+    if (!table || !table->memory) {
+        return;
+    }
+
+    u8* ctrl = get_ctrl(table);
+    u32 mask = table->capacity - 1;
+    u64 total_probe_length = 0;
+    for (u32 i = 0; i < table->capacity; ++i) {
+        if (ctrl[i] == CTRL_DELETED) {
+            out_stats->deleted_count++;
+        }
+        if (ctrl[i] & 0x80) {
+            continue;
+        }
+        // Count the groups probed before the one holding this slot.
+        u32 position = get_home(table, get_entry(table, i)->hash);
+        u32 probe = 0;
+        while (((i - position) & mask) >= GROUP_WIDTH) {
+            position = next_group(table, position, probe++);
+        }
+        total_probe_length += probe;
+        if (probe > out_stats->max_probe_length) {
+            out_stats->max_probe_length = probe;
+        }
+    }
+
+    out_stats->count = table->count;
+    out_stats->capacity = table->capacity;
+    out_stats->load_factor = (f32)table->count / table->capacity;
+    out_stats->average_probe_length =
+        table->count ? (f32)total_probe_length / table->count : 0.0f;
+}
\ No newline at end of file
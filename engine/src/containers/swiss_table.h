@@ -0,0 +1,81 @@
+#pragma once
+
+#include "defines.h"
+
+// Open addressing table for large, lookup heavy name maps. A control byte per
+// slot holds 7 bits of the key's hash, or marks the slot empty or deleted.
+// Lookups compare a whole group of 16 control bytes at once (SSE2 where
+// available, a scalar loop elsewhere) and only touch the keys whose tag
+// matches, so misses rarely read a key at all.
+// The table owns its slots and keys. It grows by doubling once 7/8 of the
+// slots are used, moving every entry at once, so size it with
+// swiss_table_reserve where the entry count is known.
+// for non-pointer types, the table retains a copy of the value.
+// for pointer types, make sure to use the _ptr setter and getter.
+// table does not take ownership of pointers or associated memory.
+typedef struct swiss_table {
+    u64 element_size;
+    // Slots, a power of 2 of at least 16.
+    u32 capacity;
+    // Number of keys currently stored.
+    u32 count;
+    // Empty slots that can still be used before the table has to grow.
+    u32 growth_left;
+    b8 is_pointer_type;
+    // Control bytes, then capacity slots of an entry followed by its value.
+    void* memory;
+} swiss_table;
+
+typedef struct swiss_table_stats {
+    u32 count;
+    u32 capacity;
+    u32 deleted_count;
+    f32 load_factor;
+    // Groups each key's probe visits past its first one.
+    f32 average_probe_length;
+    u32 max_probe_length;
+} swiss_table_stats;
+
+// Creates a table sized to hold element_count entries before it first grows.
+// element_count may be 0.
+OKO_API b8 swiss_table_create(
+    u64 element_size,
+    u32 element_count,
+    b8 is_pointer_type,
+    swiss_table* out_table
+);
+
+OKO_API void swiss_table_destroy(swiss_table* table);
+
+// Grows the table so element_count entries fit without further rehashing.
+OKO_API b8 swiss_table_reserve(swiss_table* table, u32 element_count);
+
+// Inserts or updates.
+OKO_API b8 swiss_table_set(swiss_table* table, const char* name, void* value);
+
+// Setting a 0 pointer removes the entry.
+OKO_API b8
+swiss_table_set_ptr(swiss_table* table, const char* name, void** value);
+
+// Returns false and leaves out_value untouched when name is not present.
+OKO_API b8
+swiss_table_get(swiss_table* table, const char* name, void* out_value);
+
+OKO_API b8
+swiss_table_get_ptr(swiss_table* table, const char* name, void** out_value);
+
+OKO_API b8 swiss_table_remove(swiss_table* table, const char* name);
+
+// Same as set and get with a hash from hashtable_hash_name, so one hash can
+// serve several lookups or both table kinds.
+OKO_API b8 swiss_table_set_hashed(
+    swiss_table* table, const char* name, u64 hash, void* value
+);
+
+OKO_API b8 swiss_table_get_hashed(
+    swiss_table* table, const char* name, u64 hash, void* out_value
+);
+
+// Walks every slot, so intended for reporting only.
+OKO_API void
+swiss_table_get_stats(swiss_table* table, swiss_table_stats* out_stats);
\ No newline at end of file
@@ -9,10 +9,12 @@
 #include "core/clock.h"
 
 #include "memory/linear_allocator.h"
+#include "memory/frame_allocator.h"
 #include "platform/platform.h"
 #include "renderer/renderer.h"
 
 // systems
+#include "systems/job_system.h"
 #include "systems/texture_system.h"
 
 typedef struct application_state {
@@ -37,6 +39,9 @@ typedef struct application_state {
     u64 input_system_memory_requirement;
     void* input_system_state;
 
+    u64 frame_allocator_memory_requirement;
+    void* frame_allocator_state;
+
     u64 platform_system_memory_requirement;
     void* platform_system_state;
 
@@ -45,6 +50,9 @@ typedef struct application_state {
 
     u64 texture_system_memory_requirement;
     void* texture_system_state;
+
+    u64 job_system_memory_requirement;
+    void* job_system_state;
 } application_state;
 
 static application_state* app_state;
@@ -143,10 +151,27 @@ b8 application_create(game* game_inst) {
     app_state->is_running = false;
     app_state->is_suspended = false;
 
-    u64 systems_allocator_size = 64 * 1024 * 1024;  // 64 MB
-    linear_allocator_create(
-        systems_allocator_size, 0, &app_state->systems_allocator
-    );
+    memory_system_config memory_sys_config;
+    memory_sys_config.total_alloc_size = 128 * 1024 * 1024;  // 128 MB
+    memory_sys_config.use_huge_pages = true;
+
+    // Reserved up front, pages are committed as systems claim them. Holds the
+    // large system tables, so back it with huge pages when asked to.
+    u64 systems_allocator_size = 1024 * 1024 * 1024;  // 1 GB
+    b8 reserved = memory_sys_config.use_huge_pages
+                      ? linear_allocator_create_reserved_huge(
+                            systems_allocator_size,
+                            "systems allocator",
+                            &app_state->systems_allocator
+                        )
+                      : linear_allocator_create_reserved(
+                            systems_allocator_size,
+                            &app_state->systems_allocator
+                        );
+    if (!reserved) {
+        OKO_FATAL("Failed to reserve memory for the systems allocator.");
+        return false;
+    }
 
     // Initialize subsystems
 
@@ -165,14 +190,17 @@ b8 application_create(game* game_inst) {
     }
 
     // memory system
-    memory_system_initialize(&app_state->memory_system_memory_requirement, 0);
+    memory_system_initialize(
+        &app_state->memory_system_memory_requirement, 0, memory_sys_config
+    );
     app_state->memory_system_state = linear_allocator_allocate(
         &app_state->systems_allocator,
         app_state->memory_system_memory_requirement
     );
     if (!memory_system_initialize(
             &app_state->memory_system_memory_requirement,
-            app_state->memory_system_state
+            app_state->memory_system_state,
+            memory_sys_config
         )) {
         OKO_ERROR("Memory system failed to initialize!");
         return false;
@@ -180,8 +208,11 @@ b8 application_create(game* game_inst) {
 
     // log system
     log_system_initialize(&app_state->log_system_memory_requirement, 0);
-    app_state->log_system_state = linear_allocator_allocate(
-        &app_state->systems_allocator, app_state->log_system_memory_requirement
+    // The state holds a cache-aligned queue.
+    app_state->log_system_state = linear_allocator_allocate_aligned(
+        &app_state->systems_allocator,
+        app_state->log_system_memory_requirement,
+        OKO_CACHE_LINE_SIZE
     );
     if (!log_system_initialize(
             &app_state->log_system_memory_requirement,
@@ -205,6 +236,49 @@ b8 application_create(game* game_inst) {
         return false;
     }
 
+    // frame allocator
+    frame_allocator_config frame_alloc_config;
+    frame_alloc_config.arena_size = 64 * 1024 * 1024;  // 64 MB
+    frame_allocator_system_initialize(
+        &app_state->frame_allocator_memory_requirement, 0, frame_alloc_config
+    );
+    app_state->frame_allocator_state = linear_allocator_allocate(
+        &app_state->systems_allocator,
+        app_state->frame_allocator_memory_requirement
+    );
+    if (!frame_allocator_system_initialize(
+            &app_state->frame_allocator_memory_requirement,
+            app_state->frame_allocator_state,
+            frame_alloc_config
+        )) {
+        OKO_ERROR("Frame allocator failed to initialize!");
+        return false;
+    }
+
+    // job system
+    job_system_config job_sys_config;
+    job_sys_config.worker_count = 0;  // one per remaining core
+    job_sys_config.max_jobs = 4096;
+    job_sys_config.fiber_count = 64;
+    job_sys_config.fiber_stack_size = 0;  // default
+    job_system_initialize(
+        &app_state->job_system_memory_requirement, 0, job_sys_config
+    );
+    // The state holds cache-aligned queues.
+    app_state->job_system_state = linear_allocator_allocate_aligned(
+        &app_state->systems_allocator,
+        app_state->job_system_memory_requirement,
+        OKO_CACHE_LINE_SIZE
+    );
+    if (!job_system_initialize(
+            &app_state->job_system_memory_requirement,
+            app_state->job_system_state,
+            job_sys_config
+        )) {
+        OKO_ERROR("Job system failed to initialize!");
+        return false;
+    }
+
     event_register(EVENT_APPLICATION_QUIT, 0, application_on_event);
     event_register(EVENT_KEY_PRESSED, 0, application_on_key);
     event_register(EVENT_KEY_RELEASED, 0, application_on_key);
@@ -307,6 +381,10 @@ b8 application_run() {
             f64 delta = (current_time - app_state->last_time);
             f64 frame_start_time = platform_get_absolute_time();
 
+            // Everything allocated two frames ago is released here.
+            frame_allocator_begin_frame();
+            memory_system_begin_frame();
+
             // Update game
             if (!app_state->game_inst->update(
                     app_state->game_inst, (f32)delta
@@ -364,13 +442,17 @@ b8 application_run() {
     event_unregister(EVENT_KEY_PRESSED, 0, application_on_key);
     event_unregister(EVENT_KEY_RELEASED, 0, application_on_key);
 
+    job_system_shutdown(app_state->job_system_state);
     input_system_shutdown(app_state->input_system_state);
+    frame_allocator_system_shutdown(app_state->frame_allocator_state);
     texture_system_shutdown(app_state->texture_system_state);
     renderer_system_shutdown(app_state->renderer_system_state);
     platform_system_shutdown(app_state->platform_system_state);
     log_system_shutdown(app_state->log_system_state);
-    memory_system_shutdown(app_state->memory_system_state);
     event_system_shutdown(app_state->event_system_state);
+    // NOTE: Last, blocks served by the memory system must be freed before it
+    // releases its allocator.
+    memory_system_shutdown(app_state->memory_system_state);
 
     return true;
 }
@@ -91,9 +91,9 @@ b8 event_unregister(u16 code, void* listener, PFN_on_event on_event) {
     for (u64 i = 0; i < registered_count; ++i) {
         registered_event e = state_ptr->registered[code].events[i];
         if (e.listener == listener && e.callback == on_event) {
-            // Found one, remove it
-            registered_event popped_event;
-            darray_pop_at(state_ptr->registered[code].events, i, &popped_event);
+            // Found one, remove it. Listeners fire in registration order, so
+            // keep the order instead of swapping the last one in.
+            darray_pop_at(state_ptr->registered[code].events, i, 0);
             return true;
         }
     }
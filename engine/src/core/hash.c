@@ -0,0 +1,105 @@
+#include "core/hash.h"
+
+#include "containers/string.h"
+
+#include <string.h>
+
+static const u64 secret[4] = {
+    0x2d358dccaa6c78a5ULL,
+    0x8bb84b93962eacc9ULL,
+    0x4b33a62ed433d4a3ULL,
+    0x4d5a2da51de1aa47ULL};
+
+// 128 bit product of a and b, low half in a, high half in b.
+static void multiply(u64* a, u64* b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t product = (__uint128_t)*a * *b;
+    *a = (u64)product;
+    *b = (u64)(product >> 64);
+#else
+    u64 ha = *a >> 32, hb = *b >> 32, la = (u32)*a, lb = (u32)*b;
+    u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    u64 t = rl + (rm0 << 32);
+    u64 carry = t < rl;
+    u64 low = t + (rm1 << 32);
+    carry += low < t;
+    u64 high = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+    *a = low;
+    *b = high;
+#endif
+}
+
+static u64 mix(u64 a, u64 b) {
+    multiply(&a, &b);
+    return a ^ b;
+}
+
+// Unaligned little-endian reads.
+static u64 read8(const u8* p) {
+    u64 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static u64 read4(const u8* p) {
+    u32 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static u64 read3(const u8* p, u64 length) {
+    return ((u64)p[0] << 16) | ((u64)p[length >> 1] << 8) | p[length - 1];
+}
+
+u64 hash_bytes(const void* data, u64 length, u64 seed) {
+    const u8* p = data;
+    seed ^= mix(seed ^ secret[0], secret[1]);
+    u64 a;
+    u64 b;
+
+    if (length <= 16) {
+        if (length >= 4) {
+            // Two overlapping 4 byte reads from each end cover 4..16 bytes.
+            u64 offset = (length >> 3) << 2;
+            a = (read4(p) << 32) | read4(p + offset);
+            b = (read4(p + length - 4) << 32) | read4(p + length - 4 - offset);
+        } else if (length > 0) {
+            a = read3(p, length);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        u64 remaining = length;
+        if (remaining > 48) {
+            // Three independent lanes keep the multipliers busy.
+            u64 seed1 = seed;
+            u64 seed2 = seed;
+            do {
+                seed = mix(read8(p) ^ secret[1], read8(p + 8) ^ seed);
+                seed1 = mix(read8(p + 16) ^ secret[2], read8(p + 24) ^ seed1);
+                seed2 = mix(read8(p + 32) ^ secret[3], read8(p + 40) ^ seed2);
+                p += 48;
+                remaining -= 48;
+            } while (remaining > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (remaining > 16) {
+            seed = mix(read8(p) ^ secret[1], read8(p + 8) ^ seed);
+            p += 16;
+            remaining -= 16;
+        }
+        // The last 16 bytes, overlapping what was already mixed if needed.
+        a = read8(p + remaining - 16);
+        b = read8(p + remaining - 8);
+    }
+
+    a ^= secret[1];
+    b ^= seed;
+    multiply(&a, &b);
+    return mix(a ^ secret[0] ^ length, b ^ secret[1]);
+}
+
+u64 hash_string(const char* str) {
+    return hash_bytes(str, string_length(str), 0);
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "defines.h"
+
+// 64-bit hash after wyhash (public domain, Wang Yi): reads 8 bytes at a time
+// and mixes with 64x64->128 bit multiplies. Not suited for cryptography.
+OKO_API u64 hash_bytes(const void* data, u64 length, u64 seed);
+
+// Hash of the string's bytes, without the terminator.
+OKO_API u64 hash_string(const char* str);
\ No newline at end of file
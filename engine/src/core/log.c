@@ -3,46 +3,226 @@
 #include "core/assert.h"
 #include "core/memory.h"
 
+#include "containers/ring_queue.h"
 #include "containers/string.h"
+#include "platform/atomic.h"
 #include "platform/platform.h"
 #include "platform/filesystem.h"
+#include "platform/thread.h"
 
 // TODO: temporary
 #include <stdarg.h>
+#include <stdio.h>  // vsnprintf
 
 #define LOG_ENTRY_MAX_LENGTH 32000
+// Entries this long or longer, level and newline included, skip the queue.
+#define LOG_QUEUED_ENTRY_LENGTH 1016
+#define LOG_QUEUE_CAPACITY      1024
+// Entries the writer takes off the queue at once.
+#define LOG_WRITER_BATCH        16
+// File output is gathered up to this many bytes per write.
+#define LOG_FILE_BATCH_SIZE     (64 * 1024)
+
+typedef struct log_entry {
+    u32 level;
+    u32 length;
+    char text[LOG_QUEUED_ENTRY_LENGTH];
+} log_entry;
 
 typedef struct logger_system_state {
     file_handle log_file_handle;
+    // Formatted entries waiting for the writer thread.
+    ring_queue queue;
+    thread writer;
+    semaphore wake;
+    // Set by the writer before it sleeps, cleared by whoever wakes it.
+    atomic_i32 sleeping;
+    atomic_b8 running;
+    // Entries written out, compared against the queue's enqueue position
+    // when flushing.
+    atomic_u64 written;
+    char* file_batch;
+    u64 file_batch_length;
 } logger_system_state;
 
 static logger_system_state* state_ptr;
 
-void append_to_log_file(const char* message) {
+static OKO_THREAD_LOCAL b8 is_writer_thread;
+
+static const char* level_strings[6] = {
+    "[FATAL]", "[ERROR]", "[WARN]", "[INFO]", "[DEBUG]", "[TRACE]"};
+
+void append_to_log_file(const char* message, u64 length) {
     if (state_ptr == 0 || !state_ptr->log_file_handle.is_valid) {
         return;
     }
 
-    // since the message already contains a '\n', just write the bytes directly
-    u64 length = string_length(message);
+    // since the message already contains a '\n', just write the bytes directly.
+    // Flushed right away, as the writer thread already gathers entries.
     u64 written = 0;
     if (!filesystem_write(
             &state_ptr->log_file_handle, length, message, &written
-        )) {
+        ) ||
+        !filesystem_flush(&state_ptr->log_file_handle)) {
         platform_console_write_error(
             "ERROR: Unable to write to console.log.", LOG_LEVEL_ERROR
         );
     }
 }
 
+static void write_to_console(log_level level, const char* message) {
+    if (level < LOG_LEVEL_WARN) {
+        platform_console_write_error(message, level);
+    } else {
+        platform_console_write(message, level);
+    }
+}
+
+// Writes the gathered file output and counts its entries as written.
+static void flush_file_batch(u32 entry_count) {
+    if (state_ptr->file_batch_length) {
+        append_to_log_file(state_ptr->file_batch, state_ptr->file_batch_length);
+        state_ptr->file_batch_length = 0;
+    }
+    atomic_u64_fetch_add(
+        &state_ptr->written, entry_count, ATOMIC_ORDER_RELEASE
+    );
+}
+
+static u32 writer_run(void* params) {
+    is_writer_thread = true;
+    log_entry entries[LOG_WRITER_BATCH];
+    u32 unflushed = 0;
+    for (;;) {
+        u32 count = ring_queue_dequeue_batch(
+            &state_ptr->queue, entries, LOG_WRITER_BATCH
+        );
+        for (u32 i = 0; i < count; ++i) {
+            write_to_console(entries[i].level, entries[i].text);
+            if (state_ptr->file_batch_length + entries[i].length >
+                LOG_FILE_BATCH_SIZE) {
+                flush_file_batch(unflushed);
+                unflushed = 0;
+            }
+            memory_copy(
+                state_ptr->file_batch + state_ptr->file_batch_length,
+                entries[i].text,
+                entries[i].length
+            );
+            state_ptr->file_batch_length += entries[i].length;
+            unflushed++;
+        }
+        if (count == LOG_WRITER_BATCH) {
+            continue;
+        }
+
+        // Caught up, so write out what was gathered.
+        if (unflushed) {
+            flush_file_batch(unflushed);
+            unflushed = 0;
+        }
+        if (count) {
+            continue;
+        }
+        // Only stop once nothing is left.
+        if (!atomic_b8_load(&state_ptr->running, ATOMIC_ORDER_ACQUIRE)) {
+            break;
+        }
+
+        // Announce the sleep, then look once more: a logger either sees the
+        // announcement or its entry is visible here.
+        atomic_i32_store(&state_ptr->sleeping, 1, ATOMIC_ORDER_SEQ_CST);
+        atomic_fence(ATOMIC_ORDER_SEQ_CST);
+        if (!ring_queue_count(&state_ptr->queue) &&
+            atomic_b8_load(&state_ptr->running, ATOMIC_ORDER_ACQUIRE)) {
+            semaphore_wait(&state_ptr->wake);
+        }
+        atomic_i32_store(&state_ptr->sleeping, 0, ATOMIC_ORDER_RELAXED);
+    }
+    return 0;
+}
+
+static void wake_writer() {
+    atomic_fence(ATOMIC_ORDER_SEQ_CST);
+    if (atomic_i32_load(&state_ptr->sleeping, ATOMIC_ORDER_RELAXED) &&
+        atomic_i32_exchange(&state_ptr->sleeping, 0, ATOMIC_ORDER_SEQ_CST)) {
+        semaphore_signal(&state_ptr->wake, 1);
+    }
+}
+
+// Whether entries from the calling thread go through the queue.
+static b8 is_queue_open() {
+    return state_ptr && !is_writer_thread &&
+           atomic_b8_load(&state_ptr->running, ATOMIC_ORDER_ACQUIRE);
+}
+
+// Formats "[LEVEL]message\n" into buffer. Returns the length the entry
+// needs, which is only complete when it is below size.
+static u64 format_entry(
+    char* buffer,
+    u64 size,
+    log_level level,
+    const char* message,
+    __builtin_va_list args
+) {
+    u64 prefix_length = string_length(level_strings[level]);
+    memory_copy(buffer, level_strings[level], prefix_length);
+    // Leave room for the newline.
+    u64 available = size - prefix_length - 1;
+    i32 length = vsnprintf(buffer + prefix_length, available, message, args);
+    if (length < 0) {
+        length = 0;
+    }
+    u64 total = prefix_length + length + 1;
+    if (total < size) {
+        buffer[total - 1] = '\n';
+        buffer[total] = 0;
+    }
+    return total;
+}
+
+// For entries too long for the queue, kept apart so log_output itself needs
+// little stack.
+static OKO_NOINLINE void output_long_entry(
+    log_level level, const char* message, __builtin_va_list args
+) {
+    // technically imposes a 32k character limit on a single log entry
+    // DON'T DO THAT!
+    char out_message[LOG_ENTRY_MAX_LENGTH];
+    u64 length =
+        format_entry(out_message, LOG_ENTRY_MAX_LENGTH, level, message, args);
+    if (length >= LOG_ENTRY_MAX_LENGTH) {
+        length = LOG_ENTRY_MAX_LENGTH - 2;
+        out_message[length++] = '\n';
+        out_message[length] = 0;
+    }
+    // Keep it behind what was queued before it.
+    log_flush();
+    write_to_console(level, out_message);
+    append_to_log_file(out_message, length);
+}
+
 b8 log_system_initialize(u64* memory_requirement, void* state) {
-    *memory_requirement = sizeof(logger_system_state);
+    u64 queue_requirement = ring_queue_get_memory_requirement(
+        sizeof(log_entry), LOG_QUEUE_CAPACITY, RING_QUEUE_MODE_MPMC
+    );
+    *memory_requirement =
+        sizeof(logger_system_state) + queue_requirement + LOG_FILE_BATCH_SIZE;
 
     if (state == 0) {
         return true;
     }
 
+    if ((u64)state % OKO_CACHE_LINE_SIZE) {
+        platform_console_write_error(
+            "ERROR: The log system state must be aligned to OKO_CACHE_LINE_SIZE.",
+            LOG_LEVEL_ERROR
+        );
+        return false;
+    }
+
     state_ptr = (logger_system_state*)state;
+    memory_zero(state_ptr, sizeof(logger_system_state));
 
     // open log file. create if not exists
     if (!filesystem_open(
@@ -54,46 +234,105 @@ b8 log_system_initialize(u64* memory_requirement, void* state) {
         return false;
     }
 
-    // TODO: create log file
+    void* queue_memory = (u8*)state + sizeof(logger_system_state);
+    state_ptr->file_batch = (char*)queue_memory + queue_requirement;
+    ring_queue_create(
+        sizeof(log_entry),
+        LOG_QUEUE_CAPACITY,
+        RING_QUEUE_MODE_MPMC,
+        queue_memory,
+        &state_ptr->queue
+    );
+    if (!semaphore_create(0, &state_ptr->wake)) {
+        platform_console_write_error(
+            "ERROR: Unable to create the log writer semaphore.", LOG_LEVEL_ERROR
+        );
+        return false;
+    }
+
+    // Until the writer runs, entries are written on the calling thread.
+    atomic_b8_store(&state_ptr->running, true, ATOMIC_ORDER_RELAXED);
+    if (!thread_create(writer_run, 0, &state_ptr->writer)) {
+        atomic_b8_store(&state_ptr->running, false, ATOMIC_ORDER_RELAXED);
+        platform_console_write_error(
+            "ERROR: Unable to start the log writer thread.", LOG_LEVEL_ERROR
+        );
+        return false;
+    }
+    thread_set_name(&state_ptr->writer, "log writer");
     return true;
 }
 
 void log_system_shutdown(void* state) {
-    // TODO: cleanup logging/write queued entries
+    if (!state_ptr) {
+        return;
+    }
+
+    // The writer drains the queue before it stops.
+    atomic_b8_store(&state_ptr->running, false, ATOMIC_ORDER_RELEASE);
+    semaphore_signal(&state_ptr->wake, 1);
+    thread_wait(&state_ptr->writer);
+
+    // Entries queued by threads that raced with the stop.
+    log_entry entry;
+    while (ring_queue_dequeue(&state_ptr->queue, &entry)) {
+        write_to_console(entry.level, entry.text);
+        append_to_log_file(entry.text, entry.length);
+    }
+
+    semaphore_destroy(&state_ptr->wake);
+    ring_queue_destroy(&state_ptr->queue);
+    filesystem_close(&state_ptr->log_file_handle);
     state_ptr = 0;
 }
 
-void log_output(log_level level, const char* message, ...) {
-    // TODO: these string operations are all pretty slow. this needs to be moved
-    // to another thread eventually, along with the file writes, to avoid
-    // slowing things down while the engine is running
-    const char* level_strings[6] = {
-        "[FATAL]", "[ERROR]", "[WARN]", "[INFO]", "[DEBUG]", "[TRACE]"};
-    b8 is_error = level < 2;
-
-    // technically imposes a 32k character limit on a single log entry
-    // DON'T DO THAT!
-    char out_message[32000];
-    memory_zero(out_message, sizeof(out_message));
+void log_flush() {
+    if (!is_queue_open()) {
+        return;
+    }
+    u64 target = ring_queue_get_enqueued(&state_ptr->queue);
+    while (atomic_u64_load(&state_ptr->written, ATOMIC_ORDER_ACQUIRE) <
+           target) {
+        wake_writer();
+        thread_yield();
+    }
+}
 
-    // format original message
+void log_output(log_level level, const char* message, ...) {
+    log_entry entry;
     __builtin_va_list arg_ptr;
     va_start(arg_ptr, message);
-    string_format_v(out_message, message, arg_ptr);
+    u64 length = format_entry(
+        entry.text, LOG_QUEUED_ENTRY_LENGTH, level, message, arg_ptr
+    );
     va_end(arg_ptr);
 
-    // prepend log level to message
-    string_format(out_message, "%s%s\n", level_strings[level], out_message);
+    if (length >= LOG_QUEUED_ENTRY_LENGTH) {
+        va_start(arg_ptr, message);
+        output_long_entry(level, message, arg_ptr);
+        va_end(arg_ptr);
+        return;
+    }
 
-    // print
-    if (is_error) {
-        platform_console_write_error(out_message, level);
-    } else {
-        platform_console_write(out_message, level);
+    if (!is_queue_open()) {
+        write_to_console(level, entry.text);
+        append_to_log_file(entry.text, length);
+        return;
+    }
+
+    entry.level = level;
+    entry.length = (u32)length;
+    while (!ring_queue_enqueue(&state_ptr->queue, &entry)) {
+        // Full, give the writer a moment.
+        wake_writer();
+        thread_yield();
     }
+    wake_writer();
 
-    // queue a copy to be written to the log file
-    append_to_log_file(out_message);
+    if (level == LOG_LEVEL_FATAL) {
+        // What follows a fatal entry may well be a crash.
+        log_flush();
+    }
 }
 
 void report_assertion_failure(
@@ -24,11 +24,20 @@ typedef enum log_level {
     LOG_LEVEL_TRACE = 5
 } log_level;
 
-b8 log_system_initialize(u64* memory_requirement, void* state);
-void log_system_shutdown(void* state);
+// Entries are formatted on the calling thread and written to the console and
+// console.log by a writer thread, which gathers the file writes. Before
+// initialization and after shutdown they are written on the calling thread.
+// state must be aligned to OKO_CACHE_LINE_SIZE.
+OKO_API b8 log_system_initialize(u64* memory_requirement, void* state);
+// Writes out everything still queued.
+OKO_API void log_system_shutdown(void* state);
 
 OKO_API void log_output(log_level level, const char* message, ...);
 
+// Blocks until every entry logged before the call has been written. Fatal
+// entries flush on their own.
+OKO_API void log_flush();
+
 #if LOG_FATAL_ENABLED == 1
   #define OKO_FATAL(message, ...) \
     log_output(LOG_LEVEL_FATAL, message, ##__VA_ARGS__);
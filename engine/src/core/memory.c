@@ -3,22 +3,143 @@
 #include "core/log.h"
 
 #include "containers/string.h"
+#include "math/math.h"
+#include "memory/dynamic_allocator.h"
+#include "memory/pool_allocator.h"
 
+#include "platform/atomic.h"
 #include "platform/platform.h"
+#include "platform/thread.h"
 
 // TODO: custom string lib
 #include <string.h>
 #include <stdio.h>
+#include <stdarg.h>
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+  #include <immintrin.h>
+  #define cpu_pause() _mm_pause()
+#else
+  #define cpu_pause()
+#endif
+
+// Pauses before a thread waiting on a lock yields instead, in case the
+// holder was preempted.
+#define SPIN_LOCK_PAUSE_COUNT 128
+
+#define MAX_REGISTERED_POOLS 64
+#define MAX_HUGE_RESERVATIONS 16
+
+// Threads that get their own cache, later ones share a locked path.
+#define MAX_MEMORY_THREADS 64
+
+// Blocks up to SMALL_BLOCK_MAX_SIZE come from per-thread free lists, one per
+// size class, carved out of a dedicated address range.
+#define SMALL_BLOCK_MAX_SIZE    1024
+#define SMALL_BLOCK_CLASS_COUNT 20
+#define SMALL_BLOCK_SPAN_SIZE   (64 * 1024)
+#define SMALL_BLOCK_HEAP_SIZE   (1024ULL * 1024 * 1024)
+#define SMALL_BLOCK_SPAN_COUNT  (SMALL_BLOCK_HEAP_SIZE / SMALL_BLOCK_SPAN_SIZE)
+// Blocks moved between a thread cache and the shared lists at a time.
+#define SMALL_BLOCK_BATCH_COUNT 32
+
+// Merged view of the per-thread counters and the live byte totals,
+// refreshed by memory_system_begin_frame and by reports.
 struct memory_stats {
     u64 total_allocated;
     u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
+    // High-water marks in bytes.
+    u64 peak_total_allocated;
+    u64 peak_tagged_allocations[MEMORY_TAG_MAX_TAGS];
+    // Blocks currently allocated.
+    u64 live_count;
+    u64 alloc_count;
+    u64 tagged_alloc_counts[MEMORY_TAG_MAX_TAGS];
+    // Allocation counts for the frame in progress and the one before it.
+    u64 frame_alloc_count;
+    u64 last_frame_alloc_count;
+    u64 tagged_frame_alloc_counts[MEMORY_TAG_MAX_TAGS];
+    u64 tagged_last_frame_alloc_counts[MEMORY_TAG_MAX_TAGS];
 };
 
+// Counters written by a single thread (or under the lock for the shared set)
+// and summed on report.
+typedef struct thread_stats {
+    // Signed, a block may be freed by another thread than the one that
+    // allocated it.
+    atomic_i64 live_count;
+    // Monotonic, frame counts are differences between merges.
+    atomic_u64 tagged_alloc_counts[MEMORY_TAG_MAX_TAGS];
+} thread_stats;
+
+// Bytes currently allocated, shared by every thread so the high-water marks
+// are exact. Updated with relaxed atomics on each allocation and free.
+typedef struct live_bytes {
+    atomic_i64 total;
+    atomic_i64 tagged[MEMORY_TAG_MAX_TAGS];
+    atomic_u64 peak_total;
+    atomic_u64 peak_tagged[MEMORY_TAG_MAX_TAGS];
+} live_bytes;
+
+typedef struct OKO_CACHE_ALIGNED thread_cache {
+    thread_stats stats;
+    void* free_lists[SMALL_BLOCK_CLASS_COUNT];
+    u32 free_counts[SMALL_BLOCK_CLASS_COUNT];
+    b8 in_use;
+} thread_cache;
+
+static const u16 small_block_sizes[SMALL_BLOCK_CLASS_COUNT] = {
+    16,  32,  48,  64,  80,  96,  112, 128, 160, 192,
+    224, 256, 320, 384, 448, 512, 640, 768, 896, 1024};
+
+#if OKO_MEMORY_PROFILING
+  #define INITIAL_RECORD_CAPACITY 4096
+  #define MAX_CALL_SITES          1024
+  #define MAX_REPORTED_CALL_SITES 8
+  #define MAX_REPORTED_LEAKS      32
+
+// One per live block, keyed by address.
+typedef struct allocation_record {
+    void* block;
+    u64 size;
+    const char* file;
+    u32 line;
+    u16 tag;
+} allocation_record;
+
+// Allocation counts per file:line, to find where per-frame churn comes from.
+typedef struct call_site {
+    const char* file;
+    u32 line;
+    u32 frame_count;
+    u32 last_frame_count;
+    u64 total_count;
+} call_site;
+
+typedef struct memory_profiler {
+    // Guards the tables below. Separate from the state lock so tracking does
+    // not serialize the per-thread allocation paths. Never held while taking
+    // the state lock.
+    atomic_i32 lock;
+
+    // Open addressing with linear probing, capacity is a power of 2.
+    allocation_record* records;
+    u64 record_capacity;
+    u64 record_count;
+
+    call_site* call_sites;
+    u32 call_site_count;
+
+    // Frees of blocks allocated before the profiler started.
+    u64 untracked_free_count;
+} memory_profiler;
+#endif
+
 static const char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
     "UNKNOWN         ",
     "ARRAY           ",
     "LINEAR_ALLOCATOR",
+    "DYNAMIC_ALLOC   ",
     "DARRAY          ",
     "DICT            ",
     "RING_QUEUE      ",
@@ -36,52 +157,989 @@ static const char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
     "SCENE           "};
 
 typedef struct memory_system_state {
+    memory_system_config config;
     struct memory_stats stats;
 
-    u64 alloc_count;
-    u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
+    // Guards everything shared between threads: the dynamic allocator, the
+    // shared small block lists, the shared stats and the pool registry.
+    atomic_i32 lock;
+
+    thread_cache* thread_caches;
+    // Stats of threads without a cache and of caches that were released.
+    thread_stats shared_stats;
+    live_bytes bytes;
+    u64 frame_start_alloc_counts[MEMORY_TAG_MAX_TAGS];
+
+    u8* small_heap;
+    // Bytes carved into spans so far, all of them committed.
+    u64 small_heap_used;
+    void* small_free_lists[SMALL_BLOCK_CLASS_COUNT];
+    // Size class of every carved span. Frees take the class from here, a
+    // wrong size passed to memory_free must not put a block on another
+    // class's list.
+    u8 small_span_classes[SMALL_BLOCK_SPAN_COUNT];
+
+    // Serves tagged allocations when config.total_alloc_size is set.
+    dynamic_allocator allocator;
+    void* allocator_block;
+    // Allocations that did not fit in the allocator and went to the platform.
+    u64 fallback_count;
+
+    pool_allocator* pools[MAX_REGISTERED_POOLS];
+    u32 pool_count;
+
+#if OKO_MEMORY_PROFILING
+    memory_profiler profiler;
+#endif
 } memory_system_state;
 
 static memory_system_state* state_ptr;
 
-b8 memory_system_initialize(u64* memory_requirement, void* state) {
+// Bumped on every initialize, so caches claimed from an earlier memory system
+// are never reused.
+static u32 memory_generation;
+static OKO_THREAD_LOCAL thread_cache* local_cache;
+static OKO_THREAD_LOCAL u32 local_generation;
+
+// The owning thread writes its counters while reports read them, so both go
+// through relaxed atomics. A load and a store rather than a fetch_add, there
+// is only one writer, so these compile to plain loads and stores.
+static void counter_add_i64(atomic_i64* counter, i64 value) {
+    atomic_i64_store(
+        counter,
+        atomic_i64_load(counter, ATOMIC_ORDER_RELAXED) + value,
+        ATOMIC_ORDER_RELAXED
+    );
+}
+
+static void counter_add_u64(atomic_u64* counter, u64 value) {
+    atomic_u64_store(
+        counter,
+        atomic_u64_load(counter, ATOMIC_ORDER_RELAXED) + value,
+        ATOMIC_ORDER_RELAXED
+    );
+}
+
+static void spin_lock(atomic_i32* lock) {
+    u32 pauses = 0;
+    while (atomic_i32_exchange(lock, 1, ATOMIC_ORDER_ACQUIRE)) {
+        while (atomic_i32_load(lock, ATOMIC_ORDER_RELAXED)) {
+            if (pauses < SPIN_LOCK_PAUSE_COUNT) {
+                pauses++;
+                cpu_pause();
+            } else {
+                thread_yield();
+            }
+        }
+    }
+}
+
+static void spin_unlock(atomic_i32* lock) {
+    atomic_i32_store(lock, 0, ATOMIC_ORDER_RELEASE);
+}
+
+static void lock_acquire() {
+    spin_lock(&state_ptr->lock);
+}
+
+static void lock_release() {
+    spin_unlock(&state_ptr->lock);
+}
+
+// NOTE: Kept outside the state so reservations made before the memory system
+// starts, like the systems arena, are counted too. Updated atomically, arenas
+// on any thread commit pages.
+static atomic_u64 reserved_bytes;
+static atomic_u64 committed_bytes;
+
+typedef struct huge_reservation {
+    const char* name;
+    void* address;
+    u64 size;
+    b8 huge_pages;
+} huge_reservation;
+
+static huge_reservation huge_reservations[MAX_HUGE_RESERVATIONS];
+static u32 huge_reservation_count;
+
+#if OKO_MEMORY_PROFILING
+// NOTE: The profiler's own tables come straight from the platform so that
+// tracking never recurses into the memory system.
+
+static u64 hash_pointer(const void* block) {
+    // Fibonacci hashing, the low bits of block addresses are always zero.
+    return ((u64)block >> 4) * 11400714819323198485ULL;
+}
+
+static u64 record_find_slot(
+    allocation_record* records, u64 capacity, const void* block
+) {
+    u64 mask = capacity - 1;
+    u64 index = (hash_pointer(block) >> 32) & mask;
+    while (records[index].block && records[index].block != block) {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+static b8 profiler_grow_records(memory_profiler* profiler) {
+    u64 new_capacity = profiler->record_capacity
+                           ? profiler->record_capacity * 2
+                           : INITIAL_RECORD_CAPACITY;
+    u64 new_size = sizeof(allocation_record) * new_capacity;
+    allocation_record* new_records = platform_allocate(new_size, false);
+    if (!new_records) {
+        return false;
+    }
+    platform_zero_memory(new_records, new_size);
+
+    for (u64 i = 0; i < profiler->record_capacity; ++i) {
+        allocation_record* record = &profiler->records[i];
+        if (record->block) {
+            u64 slot =
+                record_find_slot(new_records, new_capacity, record->block);
+            new_records[slot] = *record;
+        }
+    }
+
+    if (profiler->records) {
+        platform_free(profiler->records, false);
+    }
+    profiler->records = new_records;
+    profiler->record_capacity = new_capacity;
+    return true;
+}
+
+static call_site* profiler_get_call_site(
+    memory_profiler* profiler, const char* file, u32 line
+) {
+    if (!profiler->call_sites) {
+        return 0;
+    }
+    // __FILE__ literals are unique per translation unit, so the pointer is
+    // enough of a key.
+    u32 mask = MAX_CALL_SITES - 1;
+    u32 index = (u32)((hash_pointer(file) + line * 2654435761U) >> 16) & mask;
+    for (u32 probe = 0; probe < MAX_CALL_SITES; ++probe) {
+        call_site* site = &profiler->call_sites[index];
+        if (!site->file) {
+            site->file = file;
+            site->line = line;
+            profiler->call_site_count++;
+            return site;
+        }
+        if (site->file == file && site->line == line) {
+            return site;
+        }
+        index = (index + 1) & mask;
+    }
+    return 0;
+}
+
+static void profiler_record_allocation(
+    memory_profiler* profiler,
+    void* block,
+    u64 size,
+    memory_tag tag,
+    const char* file,
+    u32 line
+) {
+    if ((profiler->record_count + 1) * 4 > profiler->record_capacity * 3 &&
+        !profiler_grow_records(profiler)) {
+        return;
+    }
+
+    u64 slot =
+        record_find_slot(profiler->records, profiler->record_capacity, block);
+    allocation_record* record = &profiler->records[slot];
+    record->block = block;
+    record->size = size;
+    record->file = file;
+    record->line = line;
+    record->tag = tag;
+    profiler->record_count++;
+
+    if (file) {
+        call_site* site = profiler_get_call_site(profiler, file, line);
+        if (site) {
+            site->frame_count++;
+            site->total_count++;
+        }
+    }
+}
+
+// Returns false and copies the record to out_mismatch if the block was
+// allocated with a different size or tag. Logging is left to the caller, once
+// the lock is released.
+static b8 profiler_record_free(
+    memory_profiler* profiler,
+    void* block,
+    u64 size,
+    memory_tag tag,
+    allocation_record* out_mismatch
+) {
+    if (!profiler->records) {
+        return true;
+    }
+
+    u64 mask = profiler->record_capacity - 1;
+    u64 index =
+        record_find_slot(profiler->records, profiler->record_capacity, block);
+    allocation_record* record = &profiler->records[index];
+    if (!record->block) {
+        profiler->untracked_free_count++;
+        return true;
+    }
+
+    b8 matches = record->size == size && record->tag == tag;
+    if (!matches) {
+        *out_mismatch = *record;
+    }
+
+    // Backward shift deletion keeps probe chains intact without tombstones.
+    u64 hole = index;
+    u64 next = (hole + 1) & mask;
+    while (profiler->records[next].block) {
+        u64 home = (hash_pointer(profiler->records[next].block) >> 32) & mask;
+        // Move the entry back if its home slot is not in (hole, next].
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            profiler->records[hole] = profiler->records[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    profiler->records[hole].block = 0;
+    profiler->record_count--;
+    return matches;
+}
+
+static void profiler_report_leaks(memory_profiler* profiler) {
+    if (!profiler->record_count) {
+        return;
+    }
+
+    u64 leaked_bytes = 0;
+    for (u64 i = 0; i < profiler->record_capacity; ++i) {
+        leaked_bytes += profiler->records[i].block ? profiler->records[i].size
+                                                   : 0;
+    }
+    OKO_WARN(
+        "Memory system shutting down with %llu blocks (%llu bytes) still "
+        "allocated:",
+        profiler->record_count,
+        leaked_bytes
+    );
+
+    u32 reported = 0;
+    for (u64 i = 0; i < profiler->record_capacity; ++i) {
+        allocation_record* record = &profiler->records[i];
+        if (!record->block) {
+            continue;
+        }
+        if (reported++ == MAX_REPORTED_LEAKS) {
+            OKO_WARN(" ...");
+            break;
+        }
+        OKO_WARN(
+            " %lluB %s at %s:%u",
+            record->size,
+            memory_tag_strings[record->tag],
+            record->file ? record->file : "?",
+            record->line
+        );
+    }
+}
+#endif
+
+// Claims a cache for the calling thread on its first allocation. Returns 0
+// once every cache is taken.
+static thread_cache* get_thread_cache() {
+    if (local_generation == memory_generation) {
+        return local_cache;
+    }
+
+    local_generation = memory_generation;
+    local_cache = 0;
+    lock_acquire();
+    for (u32 i = 0; i < MAX_MEMORY_THREADS; ++i) {
+        if (!state_ptr->thread_caches[i].in_use) {
+            state_ptr->thread_caches[i].in_use = true;
+            local_cache = &state_ptr->thread_caches[i];
+            break;
+        }
+    }
+    lock_release();
+
+    if (!local_cache) {
+        OKO_WARN(
+            "More than %u threads allocate memory, the rest share a locked "
+            "path.",
+            MAX_MEMORY_THREADS
+        );
+    }
+    return local_cache;
+}
+
+static void stats_add(
+    thread_stats* stats, memory_tag tag, i64 count, u64 allocations
+) {
+    counter_add_i64(&stats->live_count, count);
+    counter_add_u64(&stats->tagged_alloc_counts[tag], allocations);
+}
+
+static void peak_update(atomic_u64* peak, i64 value) {
+    // A failed exchange reloads current, retry while value is still larger.
+    u64 current = atomic_u64_load(peak, ATOMIC_ORDER_RELAXED);
+    while (value > 0 && (u64)value > current) {
+        if (atomic_u64_compare_exchange(
+                peak, &current, value, ATOMIC_ORDER_RELAXED
+            )) {
+            break;
+        }
+    }
+}
+
+static void live_bytes_add(memory_tag tag, i64 size) {
+    live_bytes* bytes = &state_ptr->bytes;
+    i64 tagged =
+        atomic_i64_fetch_add(&bytes->tagged[tag], size, ATOMIC_ORDER_RELAXED) +
+        size;
+    i64 total =
+        atomic_i64_fetch_add(&bytes->total, size, ATOMIC_ORDER_RELAXED) + size;
+    if (size > 0) {
+        peak_update(&bytes->peak_tagged[tag], tagged);
+        peak_update(&bytes->peak_total, total);
+    }
+}
+
+static void stats_accumulate(thread_stats* total, thread_stats* stats) {
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
+        u64 count = atomic_u64_load(
+            &stats->tagged_alloc_counts[i], ATOMIC_ORDER_RELAXED
+        );
+        counter_add_u64(&total->tagged_alloc_counts[i], count);
+    }
+    counter_add_i64(
+        &total->live_count,
+        atomic_i64_load(&stats->live_count, ATOMIC_ORDER_RELAXED)
+    );
+}
+
+// Sums every thread's counters into state_ptr->stats. Must hold the lock.
+static void merge_stats() {
+    thread_stats total = {0};
+    stats_accumulate(&total, &state_ptr->shared_stats);
+    for (u32 i = 0; i < MAX_MEMORY_THREADS; ++i) {
+        stats_accumulate(&total, &state_ptr->thread_caches[i].stats);
+    }
+
+    // Counters are read while other threads update them, so a free may be
+    // seen before the matching allocation. Clamp the transient negatives.
+    struct memory_stats* stats = &state_ptr->stats;
+    live_bytes* bytes = &state_ptr->bytes;
+    i64 total_allocated = atomic_i64_load(&bytes->total, ATOMIC_ORDER_RELAXED);
+    stats->total_allocated = total_allocated > 0 ? total_allocated : 0;
+    stats->peak_total_allocated =
+        atomic_u64_load(&bytes->peak_total, ATOMIC_ORDER_RELAXED);
+    stats->alloc_count = 0;
+    stats->frame_alloc_count = 0;
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
+        i64 allocated =
+            atomic_i64_load(&bytes->tagged[i], ATOMIC_ORDER_RELAXED);
+        stats->tagged_allocations[i] = allocated > 0 ? allocated : 0;
+        stats->peak_tagged_allocations[i] =
+            atomic_u64_load(&bytes->peak_tagged[i], ATOMIC_ORDER_RELAXED);
+
+        u64 count = atomic_u64_load(
+            &total.tagged_alloc_counts[i], ATOMIC_ORDER_RELAXED
+        );
+        stats->tagged_alloc_counts[i] = count;
+        stats->alloc_count += count;
+        stats->tagged_frame_alloc_counts[i] =
+            count - state_ptr->frame_start_alloc_counts[i];
+        stats->frame_alloc_count += stats->tagged_frame_alloc_counts[i];
+    }
+    i64 live_count = atomic_i64_load(&total.live_count, ATOMIC_ORDER_RELAXED);
+    stats->live_count = live_count > 0 ? live_count : 0;
+}
+
+static void track_allocation(
+    void* block, u64 size, memory_tag tag, const char* file, u32 line
+) {
+    if (!state_ptr) {
+        return;
+    }
+
+    thread_cache* cache = get_thread_cache();
+    if (cache) {
+        stats_add(&cache->stats, tag, 1, 1);
+    } else {
+        lock_acquire();
+        stats_add(&state_ptr->shared_stats, tag, 1, 1);
+        lock_release();
+    }
+    live_bytes_add(tag, size);
+
+#if OKO_MEMORY_PROFILING
+    memory_profiler* profiler = &state_ptr->profiler;
+    spin_lock(&profiler->lock);
+    profiler_record_allocation(profiler, block, size, tag, file, line);
+    spin_unlock(&profiler->lock);
+#endif
+}
+
+static void track_free(
+    void* block, u64 size, memory_tag tag, const char* file, u32 line
+) {
+    if (!state_ptr) {
+        return;
+    }
+
+    thread_cache* cache = get_thread_cache();
+    if (cache) {
+        stats_add(&cache->stats, tag, -1, 0);
+    } else {
+        lock_acquire();
+        stats_add(&state_ptr->shared_stats, tag, -1, 0);
+        lock_release();
+    }
+    live_bytes_add(tag, -(i64)size);
+
+#if OKO_MEMORY_PROFILING
+    memory_profiler* profiler = &state_ptr->profiler;
+    allocation_record allocated;
+    spin_lock(&profiler->lock);
+    b8 matches = profiler_record_free(profiler, block, size, tag, &allocated);
+    spin_unlock(&profiler->lock);
+
+    if (!matches) {
+        OKO_WARN(
+            "memory_free at %s:%u - block from %s:%u was allocated as %lluB "
+            "%s, freed as %lluB %s.",
+            file ? file : "?",
+            line,
+            allocated.file ? allocated.file : "?",
+            allocated.line,
+            allocated.size,
+            memory_tag_strings[allocated.tag],
+            size,
+            memory_tag_strings[tag]
+        );
+    }
+#endif
+}
+
+static u32 small_block_class(u64 size) {
+    if (size <= 128) {
+        return (u32)((size + 15) / 16) - 1;
+    }
+    // Four classes per power of 2 above 128.
+    u32 shift = 63 - __builtin_clzll(size - 1);
+    u32 quarter = (u32)((size - 1) >> (shift - 2)) & 3;
+    return 8 + (shift - 7) * 4 + quarter;
+}
+
+static b8 small_heap_owns(void* block) {
+    u8* heap = state_ptr->small_heap;
+    return heap && (u8*)block >= heap &&
+           (u8*)block < heap + SMALL_BLOCK_HEAP_SIZE;
+}
+
+// The class block was carved for. The span was carved before the block was
+// handed out, so reading it without the lock is safe.
+static u32 small_block_span_class(void* block) {
+    u64 offset = (u8*)block - state_ptr->small_heap;
+    return state_ptr->small_span_classes[offset / SMALL_BLOCK_SPAN_SIZE];
+}
+
+// Commits the next span and threads it into the shared list of size_class.
+// Must hold the lock.
+static b8 small_heap_carve_span(u32 size_class) {
+    if (state_ptr->small_heap_used + SMALL_BLOCK_SPAN_SIZE >
+        SMALL_BLOCK_HEAP_SIZE) {
+        return false;
+    }
+    u8* span = state_ptr->small_heap + state_ptr->small_heap_used;
+    if (!memory_commit(span, SMALL_BLOCK_SPAN_SIZE)) {
+        return false;
+    }
+    state_ptr->small_span_classes
+        [state_ptr->small_heap_used / SMALL_BLOCK_SPAN_SIZE] = (u8)size_class;
+    state_ptr->small_heap_used += SMALL_BLOCK_SPAN_SIZE;
+
+    u64 size = small_block_sizes[size_class];
+    void* list = state_ptr->small_free_lists[size_class];
+    // Pushed back to front so blocks are handed out in address order.
+    for (u64 i = SMALL_BLOCK_SPAN_SIZE / size; i > 0; --i) {
+        void** block = (void**)(span + (i - 1) * size);
+        *block = list;
+        list = block;
+    }
+    state_ptr->small_free_lists[size_class] = list;
+    return true;
+}
+
+static void* small_block_allocate(u64 size) {
+    u32 size_class = small_block_class(size);
+    thread_cache* cache = get_thread_cache();
+    if (!cache) {
+        lock_acquire();
+        void** block = state_ptr->small_free_lists[size_class];
+        if (block || small_heap_carve_span(size_class)) {
+            block = state_ptr->small_free_lists[size_class];
+            state_ptr->small_free_lists[size_class] = *block;
+        }
+        lock_release();
+        return block;
+    }
+
+    if (!cache->free_lists[size_class]) {
+        // Refill a batch from the shared list.
+        lock_acquire();
+        void** list = state_ptr->small_free_lists[size_class];
+        if (list || small_heap_carve_span(size_class)) {
+            list = state_ptr->small_free_lists[size_class];
+            void** tail = list;
+            u32 count = 1;
+            while (count < SMALL_BLOCK_BATCH_COUNT && *tail) {
+                tail = *tail;
+                count++;
+            }
+            state_ptr->small_free_lists[size_class] = *tail;
+            *tail = 0;
+            cache->free_lists[size_class] = list;
+            cache->free_counts[size_class] = count;
+        }
+        lock_release();
+
+        if (!cache->free_lists[size_class]) {
+            // Small heap exhausted.
+            return 0;
+        }
+    }
+
+    void** block = cache->free_lists[size_class];
+    cache->free_lists[size_class] = *block;
+    cache->free_counts[size_class]--;
+    return block;
+}
+
+static void small_block_free(void* block) {
+    u32 size_class = small_block_span_class(block);
+    thread_cache* cache = get_thread_cache();
+    if (!cache) {
+        lock_acquire();
+        *(void**)block = state_ptr->small_free_lists[size_class];
+        state_ptr->small_free_lists[size_class] = block;
+        lock_release();
+        return;
+    }
+
+    *(void**)block = cache->free_lists[size_class];
+    cache->free_lists[size_class] = block;
+    cache->free_counts[size_class]++;
+
+    if (cache->free_counts[size_class] >= SMALL_BLOCK_BATCH_COUNT * 2) {
+        // Hand a batch back so blocks freed here can serve other threads.
+        void** list = cache->free_lists[size_class];
+        void** tail = list;
+        for (u32 i = 1; i < SMALL_BLOCK_BATCH_COUNT; ++i) {
+            tail = *tail;
+        }
+        cache->free_lists[size_class] = *tail;
+        cache->free_counts[size_class] -= SMALL_BLOCK_BATCH_COUNT;
+
+        lock_acquire();
+        *tail = state_ptr->small_free_lists[size_class];
+        state_ptr->small_free_lists[size_class] = list;
+        lock_release();
+    }
+}
+
+// Returns every block in the cache to the shared lists. Must hold the lock.
+static void thread_cache_flush(thread_cache* cache) {
+    for (u32 i = 0; i < SMALL_BLOCK_CLASS_COUNT; ++i) {
+        void** list = cache->free_lists[i];
+        if (!list) {
+            continue;
+        }
+        void** tail = list;
+        while (*tail) {
+            tail = *tail;
+        }
+        *tail = state_ptr->small_free_lists[i];
+        state_ptr->small_free_lists[i] = list;
+        cache->free_lists[i] = 0;
+        cache->free_counts[i] = 0;
+    }
+}
+
+void memory_release_thread_cache() {
+    if (!state_ptr || local_generation != memory_generation || !local_cache) {
+        return;
+    }
+
+    lock_acquire();
+    thread_cache_flush(local_cache);
+    // Keep the thread's contribution to the totals.
+    thread_stats* shared = &state_ptr->shared_stats;
+    stats_accumulate(shared, &local_cache->stats);
+    platform_zero_memory(&local_cache->stats, sizeof(thread_stats));
+    local_cache->in_use = false;
+    lock_release();
+
+    local_cache = 0;
+    local_generation = 0;
+}
+
+// Frees whatever initialize created so far and leaves the system
+// uninitialized, so allocations fall through to the platform.
+static b8 fail_initialize() {
+#if OKO_MEMORY_PROFILING
+    memory_profiler* profiler = &state_ptr->profiler;
+    if (profiler->records) {
+        platform_free(profiler->records, false);
+    }
+    if (profiler->call_sites) {
+        platform_free(profiler->call_sites, false);
+    }
+#endif
+
+    if (state_ptr->allocator_block) {
+        u64 size = state_ptr->config.total_alloc_size;
+        if (state_ptr->config.use_huge_pages) {
+            memory_decommit(state_ptr->allocator_block, size);
+            memory_release(state_ptr->allocator_block, size);
+        } else {
+            platform_free_aligned(state_ptr->allocator_block);
+        }
+    }
+    if (state_ptr->small_heap) {
+        memory_release(state_ptr->small_heap, SMALL_BLOCK_HEAP_SIZE);
+    }
+    if (state_ptr->thread_caches) {
+        platform_free_aligned(state_ptr->thread_caches);
+    }
+    state_ptr = 0;
+    return false;
+}
+
+b8 memory_system_initialize(
+    u64* memory_requirement, void* state, memory_system_config config
+) {
     *memory_requirement = sizeof(memory_system_state);
     if (state == 0) {
         return true;
     }
 
     state_ptr = (memory_system_state*)state;
-    state_ptr->alloc_count = 0;
+    platform_zero_memory(state_ptr, sizeof(memory_system_state));
+    state_ptr->config = config;
+    memory_generation++;
+
+    // Straight from the platform, like the profiler tables below.
+    u64 caches_size = sizeof(thread_cache) * MAX_MEMORY_THREADS;
+    state_ptr->thread_caches =
+        platform_allocate_aligned(caches_size, OKO_CACHE_LINE_SIZE);
+    state_ptr->small_heap = memory_reserve(SMALL_BLOCK_HEAP_SIZE);
+    if (!state_ptr->thread_caches || !state_ptr->small_heap) {
+        OKO_FATAL("Memory system failed to set up the thread caches.");
+        return fail_initialize();
+    }
+    platform_zero_memory(state_ptr->thread_caches, caches_size);
+
+#if OKO_MEMORY_PROFILING
+    memory_profiler* profiler = &state_ptr->profiler;
+    u64 call_sites_size = sizeof(call_site) * MAX_CALL_SITES;
+    profiler->call_sites = platform_allocate(call_sites_size, false);
+    if (!profiler->call_sites || !profiler_grow_records(profiler)) {
+        OKO_FATAL("Memory system failed to allocate the profiler tables.");
+        return fail_initialize();
+    }
+    platform_zero_memory(profiler->call_sites, call_sites_size);
+#endif
+
+    if (config.total_alloc_size > 0) {
+        // Not zeroed, the pages are only touched once they are handed out.
+        if (config.use_huge_pages) {
+            config.total_alloc_size = get_aligned(
+                config.total_alloc_size, platform_get_huge_page_size()
+            );
+            state_ptr->config.total_alloc_size = config.total_alloc_size;
+            state_ptr->allocator_block =
+                memory_reserve_huge(config.total_alloc_size, "dynamic allocator");
+            if (state_ptr->allocator_block &&
+                !memory_commit(
+                    state_ptr->allocator_block, config.total_alloc_size
+                )) {
+                memory_release(
+                    state_ptr->allocator_block, config.total_alloc_size
+                );
+                state_ptr->allocator_block = 0;
+            }
+        } else {
+            state_ptr->allocator_block = platform_allocate_aligned(
+                config.total_alloc_size, OKO_CACHE_LINE_SIZE
+            );
+        }
+        if (!state_ptr->allocator_block ||
+            !dynamic_allocator_create(
+                config.total_alloc_size,
+                state_ptr->allocator_block,
+                &state_ptr->allocator
+            )) {
+            OKO_FATAL(
+                "Memory system failed to reserve %llu bytes for the dynamic "
+                "allocator.",
+                config.total_alloc_size
+            );
+            return fail_initialize();
+        }
+    }
 
-    platform_zero_memory(&state_ptr->stats, sizeof(state_ptr->stats));
     return true;
 }
 
 void memory_system_shutdown(void* state) {
+#if OKO_MEMORY_PROFILING
+    if (state_ptr) {
+        memory_profiler* profiler = &state_ptr->profiler;
+        profiler_report_leaks(profiler);
+        platform_free(profiler->records, false);
+        platform_free(profiler->call_sites, false);
+        profiler->records = 0;
+        profiler->call_sites = 0;
+    }
+#endif
+
+    if (state_ptr && state_ptr->allocator_block) {
+        dynamic_allocator_destroy(&state_ptr->allocator);
+        u64 size = state_ptr->config.total_alloc_size;
+        if (state_ptr->config.use_huge_pages) {
+            memory_decommit(state_ptr->allocator_block, size);
+            memory_release(state_ptr->allocator_block, size);
+        } else {
+            platform_free_aligned(state_ptr->allocator_block);
+        }
+        state_ptr->allocator_block = 0;
+    }
+
+    if (state_ptr) {
+        if (state_ptr->small_heap_used) {
+            memory_decommit(state_ptr->small_heap, state_ptr->small_heap_used);
+        }
+        memory_release(state_ptr->small_heap, SMALL_BLOCK_HEAP_SIZE);
+        platform_free_aligned(state_ptr->thread_caches);
+    }
     state_ptr = 0;
 }
 
-void* memory_allocate(u64 size, memory_tag tag) {
+static void* allocate_block(u64 size, u16 alignment) {
+    void* block = 0;
+    if (state_ptr && state_ptr->allocator_block) {
+        lock_acquire();
+        block = dynamic_allocator_allocate_aligned(
+            &state_ptr->allocator, size, alignment
+        );
+        if (!block) {
+            state_ptr->fallback_count++;
+        }
+        lock_release();
+    }
+
+    if (!block) {
+        block = alignment > 0 ? platform_allocate_aligned(size, alignment)
+                              : platform_allocate(size, false);
+    }
+    return block;
+}
+
+// Allocation without tracking, small blocks come from the thread cache.
+static void* allocate_unaligned(u64 size) {
+    void* block = 0;
+    if (state_ptr && size > 0 && size <= SMALL_BLOCK_MAX_SIZE) {
+        block = small_block_allocate(size);
+    }
+    return block ? block : allocate_block(size, 0);
+}
+
+static void free_block(void* block, b8 aligned) {
+    if (state_ptr && small_heap_owns(block)) {
+        small_block_free(block);
+    } else if (state_ptr &&
+               dynamic_allocator_owns(&state_ptr->allocator, block)) {
+        lock_acquire();
+        dynamic_allocator_free(&state_ptr->allocator, block);
+        lock_release();
+    } else if (aligned) {
+        platform_free_aligned(block);
+    } else {
+        platform_free(block, false);
+    }
+}
+
+void memory_system_begin_frame() {
+    if (!state_ptr) {
+        return;
+    }
+
+    lock_acquire();
+    merge_stats();
+
+    struct memory_stats* stats = &state_ptr->stats;
+    stats->last_frame_alloc_count = stats->frame_alloc_count;
+    stats->frame_alloc_count = 0;
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
+        stats->tagged_last_frame_alloc_counts[i] =
+            stats->tagged_frame_alloc_counts[i];
+        stats->tagged_frame_alloc_counts[i] = 0;
+        state_ptr->frame_start_alloc_counts[i] = stats->tagged_alloc_counts[i];
+    }
+
+#if OKO_MEMORY_PROFILING
+    memory_profiler* profiler = &state_ptr->profiler;
+    spin_lock(&profiler->lock);
+    for (u32 i = 0; i < MAX_CALL_SITES && profiler->call_site_count; ++i) {
+        call_site* site = &profiler->call_sites[i];
+        site->last_frame_count = site->frame_count;
+        site->frame_count = 0;
+    }
+    spin_unlock(&profiler->lock);
+#endif
+    lock_release();
+}
+
+void* _memory_allocate(
+    u64 size, memory_tag tag, const char* file, u32 line
+) {
+    void* block = _memory_allocate_uninitialized(size, tag, file, line);
+    if (block) {
+        platform_zero_memory(block, size);
+    }
+    return block;
+}
+
+void* _memory_allocate_uninitialized(
+    u64 size, memory_tag tag, const char* file, u32 line
+) {
     if (tag == MEMORY_TAG_UNKNOWN) {
         OKO_WARN(
-            "oko_allocate called using MEMORY_TAG_UNKNOWN. Re-class this "
+            "memory_allocate called using MEMORY_TAG_UNKNOWN. Re-class this "
             "allocation."
         );
     }
 
-    if (state_ptr) {
-        state_ptr->stats.total_allocated += size;
-        state_ptr->stats.tagged_allocations[tag] += size;
-        state_ptr->alloc_count++;
+    void* block = allocate_unaligned(size);
+    if (!block) {
+        OKO_ERROR("memory_allocate - failed to allocate %llu bytes.", size);
+        return 0;
+    }
+    track_allocation(block, size, tag, file, line);
+    return block;
+}
+
+void* _memory_reallocate(
+    void* block,
+    u64 old_size,
+    u64 new_size,
+    memory_tag tag,
+    const char* file,
+    u32 line
+) {
+    if (!block) {
+        return _memory_allocate_uninitialized(new_size, tag, file, line);
+    }
+    if (new_size == 0) {
+        _memory_free(block, old_size, tag, file, line);
+        return 0;
+    }
+
+    // Counted as a free of the old block and an allocation of the new one, so
+    // the profiler follows the block if it moved. The free is tracked before
+    // the old block can be released, once released another thread may be
+    // handed the same address and track it.
+    track_free(block, old_size, tag, file, line);
+
+    void* new_block = 0;
+    u64 copy_size = old_size < new_size ? old_size : new_size;
+    if (state_ptr && small_heap_owns(block)) {
+        if (new_size <= SMALL_BLOCK_MAX_SIZE &&
+            small_block_class(new_size) == small_block_span_class(block)) {
+            new_block = block;
+        }
+    } else if (state_ptr &&
+               dynamic_allocator_owns(&state_ptr->allocator, block)) {
+        lock_acquire();
+        if (dynamic_allocator_resize(&state_ptr->allocator, block, new_size)) {
+            new_block = block;
+        }
+        lock_release();
+    } else {
+        new_block = platform_reallocate(block, new_size);
+    }
+
+    if (!new_block) {
+        // Could not resize in place, move it.
+        new_block = allocate_unaligned(new_size);
+        if (new_block) {
+            platform_copy_memory(new_block, block, copy_size);
+            free_block(block, false);
+        }
+    }
+
+    if (!new_block) {
+        OKO_ERROR(
+            "memory_reallocate - failed to grow block %p from %llu to %llu "
+            "bytes.",
+            block,
+            old_size,
+            new_size
+        );
+        // The old block is still allocated.
+        track_allocation(block, old_size, tag, file, line);
+        return 0;
     }
 
-    // TODO: Memory alignment
-    void* block = platform_allocate(size, false);
-    platform_zero_memory(block, size);
+    track_allocation(new_block, new_size, tag, file, line);
+    return new_block;
+}
+
+void* _memory_allocate_aligned(
+    u64 size, u16 alignment, memory_tag tag, const char* file, u32 line
+) {
+    if (!is_power_of_2(alignment)) {
+        OKO_ERROR(
+            "memory_allocate_aligned - alignment must be a power of 2, got %u.",
+            alignment
+        );
+        return 0;
+    }
+
+    if (tag == MEMORY_TAG_UNKNOWN) {
+        OKO_WARN(
+            "memory_allocate_aligned called using MEMORY_TAG_UNKNOWN. Re-class "
+            "this allocation."
+        );
+    }
+
+    // Pad to whole alignment units so the tail is never shared with the next
+    // block.
+    u64 padded_size = get_aligned(size, alignment);
+    void* block = allocate_block(padded_size, alignment);
+    if (!block) {
+        OKO_ERROR(
+            "memory_allocate_aligned - failed to allocate %llu bytes.", size
+        );
+        return 0;
+    }
+    track_allocation(block, size, tag, file, line);
+    platform_zero_memory(block, padded_size);
     return block;
 }
 
-void memory_free(void* block, u64 size, memory_tag tag) {
+void _memory_free(
+    void* block, u64 size, memory_tag tag, const char* file, u32 line
+) {
     if (tag == MEMORY_TAG_UNKNOWN) {
         OKO_WARN(
             "oko_free called using MEMORY_TAG_UNKNOWN. Re-class this "
@@ -89,13 +1147,115 @@ void memory_free(void* block, u64 size, memory_tag tag) {
         );
     }
 
-    if (state_ptr) {
-        state_ptr->stats.total_allocated -= size;
-        state_ptr->stats.tagged_allocations[tag] -= size;
+    track_free(block, size, tag, file, line);
+    free_block(block, false);
+}
+
+void _memory_free_aligned(
+    void* block,
+    u64 size,
+    u16 alignment,
+    memory_tag tag,
+    const char* file,
+    u32 line
+) {
+    if (tag == MEMORY_TAG_UNKNOWN) {
+        OKO_WARN(
+            "memory_free_aligned called using MEMORY_TAG_UNKNOWN. Re-class "
+            "this allocation."
+        );
+    }
+
+    track_free(block, size, tag, file, line);
+    free_block(block, true);
+}
+
+u64 memory_get_page_size() {
+    static u64 page_size = 0;
+    if (!page_size) {
+        page_size = platform_get_page_size();
+    }
+    return page_size;
+}
+
+void* memory_reserve(u64 size) {
+    size = get_aligned(size, memory_get_page_size());
+    void* address = platform_reserve_memory(size);
+    if (!address) {
+        OKO_ERROR("memory_reserve - failed to reserve %llu bytes.", size);
+        return 0;
+    }
+    atomic_u64_fetch_add(&reserved_bytes, size, ATOMIC_ORDER_RELAXED);
+    return address;
+}
+
+u64 memory_get_huge_page_size() {
+    return platform_get_huge_page_size();
+}
+
+void* memory_reserve_huge(u64 size, const char* name) {
+    size = get_aligned(size, platform_get_huge_page_size());
+    b8 huge_pages = false;
+    void* address = platform_reserve_huge_memory(size, &huge_pages);
+    if (!address) {
+        OKO_ERROR(
+            "memory_reserve_huge - failed to reserve %llu bytes for '%s'.",
+            size,
+            name
+        );
+        return 0;
+    }
+    atomic_u64_fetch_add(&reserved_bytes, size, ATOMIC_ORDER_RELAXED);
+
+    if (huge_pages) {
+        OKO_INFO("'%s' (%llu bytes) backed by huge pages.", name, size);
+    } else {
+        OKO_INFO(
+            "Huge pages unavailable, '%s' (%llu bytes) uses regular pages.",
+            name,
+            size
+        );
+    }
+
+    if (huge_reservation_count < MAX_HUGE_RESERVATIONS) {
+        huge_reservation* entry = &huge_reservations[huge_reservation_count++];
+        entry->name = name;
+        entry->address = address;
+        entry->size = size;
+        entry->huge_pages = huge_pages;
+    }
+    return address;
+}
+
+b8 memory_commit(void* address, u64 size) {
+    size = get_aligned(size, memory_get_page_size());
+    if (!platform_commit_memory(address, size)) {
+        OKO_ERROR(
+            "memory_commit - failed to commit %llu bytes at %p.", size, address
+        );
+        return false;
+    }
+    atomic_u64_fetch_add(&committed_bytes, size, ATOMIC_ORDER_RELAXED);
+    return true;
+}
+
+void memory_decommit(void* address, u64 size) {
+    size = get_aligned(size, memory_get_page_size());
+    platform_decommit_memory(address, size);
+    atomic_u64_fetch_sub(&committed_bytes, size, ATOMIC_ORDER_RELAXED);
+}
+
+void memory_release(void* address, u64 size) {
+    for (u32 i = 0; i < huge_reservation_count; ++i) {
+        if (huge_reservations[i].address == address) {
+            huge_reservations[i] = huge_reservations[--huge_reservation_count];
+            break;
+        }
     }
 
-    // TODO: Memory alignment
-    platform_free(block, false);
+    size = get_aligned(size, memory_get_page_size());
+    platform_release_memory(address, size);
+    atomic_u64_fetch_sub(&reserved_bytes, size, ATOMIC_ORDER_RELAXED);
 }
 
 void* memory_zero(void* block, u64 size) {
@@ -106,54 +1266,316 @@ void* memory_copy(void* dest, const void* source, u64 size) {
     return platform_copy_memory(dest, source, size);
 }
 
+void* memory_move(void* dest, const void* source, u64 size) {
+    return platform_move_memory(dest, source, size);
+}
+
 void* memory_set(void* dest, i32 value, u64 size) {
     return platform_set_memory(dest, value, size);
 }
 
-char* memory_get_usage_string() {
+void memory_register_pool(pool_allocator* pool) {
+    if (!state_ptr) {
+        return;
+    }
+    lock_acquire();
+    b8 registered = state_ptr->pool_count < MAX_REGISTERED_POOLS;
+    if (registered) {
+        state_ptr->pools[state_ptr->pool_count++] = pool;
+    }
+    lock_release();
+
+    if (!registered) {
+        OKO_WARN(
+            "memory_register_pool - more than %u pools, '%s' will not be "
+            "reported.",
+            MAX_REGISTERED_POOLS,
+            pool->name ? pool->name : ""
+        );
+    }
+}
+
+void memory_unregister_pool(pool_allocator* pool) {
+    if (!state_ptr) {
+        return;
+    }
+    lock_acquire();
+    for (u32 i = 0; i < state_ptr->pool_count; ++i) {
+        if (state_ptr->pools[i] == pool) {
+            state_ptr->pool_count--;
+            state_ptr->pools[i] = state_ptr->pools[state_ptr->pool_count];
+            break;
+        }
+    }
+    lock_release();
+}
+
+// snprintf that never moves offset past the end of the buffer.
+static void append_format(
+    char* buffer, u64 capacity, u64* offset, const char* format, ...
+) {
+    if (*offset >= capacity - 1) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    i32 length = vsnprintf(buffer + *offset, capacity - *offset, format, args);
+    va_end(args);
+    if (length > 0) {
+        *offset += length;
+        if (*offset > capacity - 1) {
+            *offset = capacity - 1;
+        }
+    }
+}
+
+// Converts a byte count to the largest fitting unit. out_unit needs 4 chars.
+static f32 get_size_in_units(u64 size, char* out_unit) {
     const u64 gib = 1024 * 1024 * 1024;
     const u64 mib = 1024 * 1024;
     const u64 kib = 1024;
 
-    char buffer[8000] = "System memory use (tagged):\n";
+    out_unit[1] = 'i';
+    out_unit[2] = 'B';
+    out_unit[3] = 0;
+    if (size >= gib) {
+        out_unit[0] = 'G';
+        return size / (f32)gib;
+    } else if (size >= mib) {
+        out_unit[0] = 'M';
+        return size / (f32)mib;
+    } else if (size >= kib) {
+        out_unit[0] = 'K';
+        return size / (f32)kib;
+    }
+    out_unit[0] = 'B';
+    out_unit[1] = 0;
+    return (f32)size;
+}
+
+char* memory_get_usage_string() {
+    lock_acquire();
+    merge_stats();
+
+    struct memory_stats* stats = &state_ptr->stats;
+    char buffer[8000] =
+        "System memory use (tagged, peak, allocations last frame):\n";
     u64 offset = strlen(buffer);
     for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; i++) {
-        char unit[4] = "XiB";
-        float amount = 1.0f;
-        if (state_ptr->stats.tagged_allocations[i] >= gib) {
-            unit[0] = 'G';
-            amount = state_ptr->stats.tagged_allocations[i] / (float)gib;
-        } else if (state_ptr->stats.tagged_allocations[i] >= mib) {
-            unit[0] = 'M';
-            amount = state_ptr->stats.tagged_allocations[i] / (float)mib;
-        } else if (state_ptr->stats.tagged_allocations[i] >= kib) {
-            unit[0] = 'K';
-            amount = state_ptr->stats.tagged_allocations[i] / (float)kib;
-        } else {
-            unit[0] = 'B';
-            unit[1] = 0;
-            amount = state_ptr->stats.tagged_allocations[i];
-        }
+        char unit[4];
+        char peak_unit[4];
+        f32 amount = get_size_in_units(stats->tagged_allocations[i], unit);
+        f32 peak =
+            get_size_in_units(stats->peak_tagged_allocations[i], peak_unit);
 
-        i32 length = snprintf(
-            buffer + offset,
-            8000,
-            " %s: %.2f%s\n",
+        append_format(
+            buffer,
+            sizeof(buffer),
+            &offset,
+            " %s: %.2f%s, %.2f%s, %llu\n",
             memory_tag_strings[i],
             amount,
-            unit
+            unit,
+            peak,
+            peak_unit,
+            stats->tagged_last_frame_alloc_counts[i]
+        );
+    }
+
+    char total_unit[4];
+    char peak_unit[4];
+    f32 total = get_size_in_units(stats->total_allocated, total_unit);
+    f32 peak = get_size_in_units(stats->peak_total_allocated, peak_unit);
+    append_format(
+        buffer,
+        sizeof(buffer),
+        &offset,
+        "Total: %.2f%s (peak %.2f%s) in %llu blocks, %llu allocations last "
+        "frame\n",
+        total,
+        total_unit,
+        peak,
+        peak_unit,
+        stats->live_count,
+        stats->last_frame_alloc_count
+    );
+
+#if OKO_MEMORY_PROFILING
+    // Busiest call sites of the last frame, a simple selection over the table.
+    memory_profiler* profiler = &state_ptr->profiler;
+    spin_lock(&profiler->lock);
+    call_site* top[MAX_REPORTED_CALL_SITES] = {0};
+    for (u32 i = 0; i < MAX_CALL_SITES && profiler->call_site_count; ++i) {
+        call_site* site = &profiler->call_sites[i];
+        if (!site->file || !site->last_frame_count) {
+            continue;
+        }
+        for (u32 j = 0; j < MAX_REPORTED_CALL_SITES; ++j) {
+            if (!top[j] || site->last_frame_count > top[j]->last_frame_count) {
+                for (u32 k = MAX_REPORTED_CALL_SITES - 1; k > j; --k) {
+                    top[k] = top[k - 1];
+                }
+                top[j] = site;
+                break;
+            }
+        }
+    }
+    if (top[0]) {
+        append_format(
+            buffer, sizeof(buffer), &offset, "Allocation sites last frame:\n"
+        );
+    }
+    for (u32 i = 0; i < MAX_REPORTED_CALL_SITES && top[i]; ++i) {
+        append_format(
+            buffer,
+            sizeof(buffer),
+            &offset,
+            " %s:%u: %u (%llu total)\n",
+            top[i]->file,
+            top[i]->line,
+            top[i]->last_frame_count,
+            top[i]->total_count
         );
-        offset += length;
     }
+    spin_unlock(&profiler->lock);
+#endif
+
+    u64 reserved_size = atomic_u64_load(&reserved_bytes, ATOMIC_ORDER_RELAXED);
+    if (reserved_size) {
+        char committed_unit[4];
+        char reserved_unit[4];
+        f32 committed = get_size_in_units(
+            atomic_u64_load(&committed_bytes, ATOMIC_ORDER_RELAXED),
+            committed_unit
+        );
+        f32 reserved = get_size_in_units(reserved_size, reserved_unit);
+        append_format(
+            buffer,
+            sizeof(buffer),
+            &offset,
+            "Virtual memory: %.2f%s committed / %.2f%s reserved\n",
+            committed,
+            committed_unit,
+            reserved,
+            reserved_unit
+        );
+    }
+    for (u32 i = 0; i < huge_reservation_count; ++i) {
+        huge_reservation* entry = &huge_reservations[i];
+        char unit[4];
+        f32 amount = get_size_in_units(entry->size, unit);
+        append_format(
+            buffer,
+            sizeof(buffer),
+            &offset,
+            " %s: %.2f%s, %s\n",
+            entry->name,
+            amount,
+            unit,
+            entry->huge_pages ? "huge pages" : "regular pages"
+        );
+    }
+
+    if (state_ptr->allocator_block) {
+        dynamic_allocator* allocator = &state_ptr->allocator;
+        u64 free_space = dynamic_allocator_free_space(allocator);
+        u64 largest_free = dynamic_allocator_largest_free_block(allocator);
+        // Share of the free space that cannot be handed out as one block.
+        f32 fragmentation =
+            free_space ? (1.0f - (f32)largest_free / (f32)free_space) * 100.0f
+                       : 0.0f;
+
+        char used_unit[4];
+        char size_unit[4];
+        char largest_unit[4];
+        f32 used = get_size_in_units(allocator->allocated, used_unit);
+        f32 size = get_size_in_units(allocator->total_size, size_unit);
+        f32 largest = get_size_in_units(largest_free, largest_unit);
+
+        append_format(
+            buffer,
+            sizeof(buffer),
+            &offset,
+            "Dynamic allocator: %.2f%s / %.2f%s used, %llu blocks\n"
+            " free blocks: %llu, largest free: %.2f%s, fragmentation: "
+            "%.2f%%, platform fallbacks: %llu\n",
+            used,
+            used_unit,
+            size,
+            size_unit,
+            allocator->allocation_count,
+            allocator->free_block_count,
+            largest,
+            largest_unit,
+            fragmentation,
+            state_ptr->fallback_count
+        );
+    }
+
+    if (state_ptr->small_heap_used) {
+        u32 cache_count = 0;
+        for (u32 i = 0; i < MAX_MEMORY_THREADS; ++i) {
+            cache_count += state_ptr->thread_caches[i].in_use;
+        }
+        char unit[4];
+        f32 amount = get_size_in_units(state_ptr->small_heap_used, unit);
+        append_format(
+            buffer,
+            sizeof(buffer),
+            &offset,
+            "Small blocks: %.2f%s carved, %u thread caches\n",
+            amount,
+            unit,
+            cache_count
+        );
+    }
+
+    if (state_ptr->pool_count) {
+        append_format(
+            buffer, sizeof(buffer), &offset, "Pools (used/capacity):\n"
+        );
+    }
+    for (u32 i = 0; i < state_ptr->pool_count; ++i) {
+        pool_allocator* pool = state_ptr->pools[i];
+        u64 capacity = pool_allocator_capacity(pool);
+        append_format(
+            buffer,
+            sizeof(buffer),
+            &offset,
+            " %-16s %s: %llu/%llu (%.1f%%), peak %llu, %llu blocks\n",
+            pool->name ? pool->name : "",
+            memory_tag_strings[pool->tag],
+            pool->allocated_count,
+            capacity,
+            capacity ? pool->allocated_count * 100.0f / capacity : 0.0f,
+            pool->peak_count,
+            pool->block_count
+        );
+    }
+
+    lock_release();
 
     // NOTE: return a dynamically allocated buffer
     char* out_string = string_duplicate(buffer);
     return out_string;
 }
 
+u64 memory_get_allocated(memory_tag tag) {
+    if (!state_ptr) {
+        return 0;
+    }
+    i64 allocated =
+        atomic_i64_load(&state_ptr->bytes.tagged[tag], ATOMIC_ORDER_RELAXED);
+    return allocated > 0 ? allocated : 0;
+}
+
 u64 memory_get_alloc_count() {
     if (!state_ptr) {
         return 0;
     }
-    return state_ptr->alloc_count;
+    lock_acquire();
+    merge_stats();
+    u64 alloc_count = state_ptr->stats.alloc_count;
+    lock_release();
+    return alloc_count;
 }
\ No newline at end of file
@@ -6,6 +6,7 @@ typedef enum memory_tag {
     MEMORY_TAG_UNKNOWN,
     MEMORY_TAG_ARRAY,
     MEMORY_TAG_LINEAR_ALLOCATOR,
+    MEMORY_TAG_DYNAMIC_ALLOCATOR,
     MEMORY_TAG_DARRAY,
     MEMORY_TAG_DICT,
     MEMORY_TAG_RING_QUEUE,
@@ -25,17 +26,140 @@ typedef enum memory_tag {
     MEMORY_TAG_MAX_TAGS
 } memory_tag;
 
-OKO_API b8 memory_system_initialize(u64* memory_requirement, void* state);
+typedef struct memory_system_config {
+    // Size of the block reserved for the dynamic allocator that serves tagged
+    // allocations. 0 sends every allocation straight to the platform.
+    u64 total_alloc_size;
+    // Back the allocator's block with huge pages where available.
+    b8 use_huge_pages;
+} memory_system_config;
+
+OKO_API b8 memory_system_initialize(
+    u64* memory_requirement, void* state, memory_system_config config
+);
 OKO_API void memory_system_shutdown(void* state);
 
-OKO_API void* memory_allocate(u64 size, memory_tag tag);
-OKO_API void memory_free(void* block, u64 size, memory_tag tag);
+// Allocation profiling: records the call site of every live block, warns
+// about frees that do not match their allocation and lists unfreed blocks at
+// shutdown. On in debug builds, define OKO_MEMORY_PROFILING=1 to keep it in
+// others.
+#ifndef OKO_MEMORY_PROFILING
+  #ifdef _DEBUG
+    #define OKO_MEMORY_PROFILING 1
+  #else
+    #define OKO_MEMORY_PROFILING 0
+  #endif
+#endif
+
+#if OKO_MEMORY_PROFILING
+  #define OKO_CALL_SITE __FILE__, __LINE__
+#else
+  #define OKO_CALL_SITE 0, 0
+#endif
+
+// Called by the application at the start of every frame to roll the per-frame
+// allocation counters.
+void memory_system_begin_frame();
+
+// Allocation and free are thread-safe. Every thread keeps its own counters,
+// merged when a report is built, and its own free lists for blocks up to 1KB,
+// which it refills from and returns to shared lists in batches. Only larger
+// blocks and batch transfers take the lock. With profiling on, the profiler's
+// tables sit behind a separate lock. Live byte totals and their peaks are
+// shared atomics, so the peaks are exact.
+
+// Hands the calling thread's cached blocks and counters back. Threads started
+// through thread_create do this on exit, others should call it before they
+// end.
+OKO_API void memory_release_thread_cache();
+
+OKO_API void* _memory_allocate(
+    u64 size, memory_tag tag, const char* file, u32 line
+);
+OKO_API void* _memory_allocate_uninitialized(
+    u64 size, memory_tag tag, const char* file, u32 line
+);
+OKO_API void* _memory_reallocate(
+    void* block,
+    u64 old_size,
+    u64 new_size,
+    memory_tag tag,
+    const char* file,
+    u32 line
+);
+OKO_API void _memory_free(
+    void* block, u64 size, memory_tag tag, const char* file, u32 line
+);
+
+OKO_API void* _memory_allocate_aligned(
+    u64 size, u16 alignment, memory_tag tag, const char* file, u32 line
+);
+OKO_API void _memory_free_aligned(
+    void* block,
+    u64 size,
+    u16 alignment,
+    memory_tag tag,
+    const char* file,
+    u32 line
+);
+
+#define memory_allocate(size, tag) _memory_allocate(size, tag, OKO_CALL_SITE)
+
+// Skips zeroing, for blocks that are fully written before being read.
+#define memory_allocate_uninitialized(size, tag) \
+  _memory_allocate_uninitialized(size, tag, OKO_CALL_SITE)
+
+// Resizes a block from memory_allocate(_uninitialized), in place when the
+// allocator can. Returns the block's new address, 0 on failure in which case
+// the old block is untouched. Bytes past old_size are not initialized.
+// old_size and tag must match the allocation.
+#define memory_reallocate(block, old_size, new_size, tag) \
+  _memory_reallocate(block, old_size, new_size, tag, OKO_CALL_SITE)
+
+#define memory_free(block, size, tag) \
+  _memory_free(block, size, tag, OKO_CALL_SITE)
+
+// Alignment must be a power of 2. The block is padded to a whole number of
+// alignment units, so with alignment >= OKO_CACHE_LINE_SIZE it never shares a
+// cache line with another allocation. size and alignment must match on free.
+#define memory_allocate_aligned(size, alignment, tag) \
+  _memory_allocate_aligned(size, alignment, tag, OKO_CALL_SITE)
+
+#define memory_free_aligned(block, size, alignment, tag) \
+  _memory_free_aligned(block, size, alignment, tag, OKO_CALL_SITE)
+
+// Virtual memory: reserve address space up front and commit pages as they are
+// needed, so arenas can grow in place. Sizes are rounded up to whole pages and
+// reserved/committed bytes show up in the usage report.
+OKO_API u64 memory_get_page_size();
+OKO_API void* memory_reserve(u64 size);
+// Like memory_reserve, but rounded up to the huge page size and backed by huge
+// pages where the platform allows, falling back to regular pages otherwise.
+// name identifies the range in the usage report.
+OKO_API void* memory_reserve_huge(u64 size, const char* name);
+OKO_API u64 memory_get_huge_page_size();
+// Committed pages read as zero until written.
+OKO_API b8 memory_commit(void* address, u64 size);
+OKO_API void memory_decommit(void* address, u64 size);
+OKO_API void memory_release(void* address, u64 size);
+
 OKO_API void* memory_zero(void* block, u64 size);
 OKO_API void* memory_copy(void* dest, const void* source, u64 size);
+// Copies between ranges that may overlap.
+OKO_API void* memory_move(void* dest, const void* source, u64 size);
 OKO_API void* memory_set(void* dest, i32 value, u64 size);
 
+struct pool_allocator;
+
+// Pools register themselves so their occupancy shows up in the usage report.
+OKO_API void memory_register_pool(struct pool_allocator* pool);
+OKO_API void memory_unregister_pool(struct pool_allocator* pool);
+
 OKO_API char* memory_get_usage_string();
 
+// Bytes currently allocated with tag.
+OKO_API u64 memory_get_allocated(memory_tag tag);
+
 OKO_API u64 memory_get_alloc_count();
 
 // NOTE:
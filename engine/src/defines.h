@@ -105,8 +105,32 @@ STATIC_ASSERT(sizeof(f64) == 8, "Expected f64 to be 8 bytes!");
   #define OKO_NOINLINE __declspec(noinline)
 #else
   #define OKO_INLINE static inline
-  #define OKO_NOINLINE
+  #define OKO_NOINLINE __attribute__((noinline))
 #endif
 
 #define OKO_CLAMP(value, min, max) \
-  (value <= min) ? min : (value >= max) ? max : value;
\ No newline at end of file
+  (value <= min) ? min : (value >= max) ? max : value;
+
+// Assumed cache line size. Used for alignment and to pad data written by
+// different threads so that it never shares a line.
+#define OKO_CACHE_LINE_SIZE 64
+
+#ifdef _MSC_VER
+  #define OKO_ALIGN(n) __declspec(align(n))
+#else
+  #define OKO_ALIGN(n) __attribute__((aligned(n)))
+#endif
+
+#define OKO_CACHE_ALIGNED OKO_ALIGN(OKO_CACHE_LINE_SIZE)
+
+#ifdef _MSC_VER
+  #define OKO_THREAD_LOCAL __declspec(thread)
+#else
+  #define OKO_THREAD_LOCAL _Thread_local
+#endif
+
+// Rounds operand up to the next multiple of granularity, which must be a power
+// of 2.
+OKO_INLINE u64 get_aligned(u64 operand, u64 granularity) {
+    return (operand + (granularity - 1)) & ~(granularity - 1);
+}
\ No newline at end of file
@@ -0,0 +1,443 @@
+#include "dynamic_allocator.h"
+
+#include "core/memory.h"
+#include "core/log.h"
+
+/*
+Region layout
+[pad][u64 prologue footer][block][block]...[block][epilogue header]
+
+Block layout
+u64 size = total block size in bytes, lowest bit set while allocated
+u64 requested = size asked for by the caller while allocated
+... payload (free blocks store the free list links here)
+u64 footer = copy of size, read by the next block when coalescing
+*/
+
+#define BLOCK_ALIGNMENT      16
+#define BLOCK_HEADER_SIZE    16
+#define BLOCK_FOOTER_SIZE    8
+#define BLOCK_ALLOCATED_FLAG 1ULL
+// Header, free list links and footer, rounded up.
+#define BLOCK_MIN_SIZE 48
+
+typedef struct block_header {
+    u64 size;
+    u64 requested;
+} block_header;
+
+typedef struct free_block {
+    block_header header;
+    struct free_block* prev;
+    struct free_block* next;
+} free_block;
+
+STATIC_ASSERT(
+    sizeof(block_header) == BLOCK_HEADER_SIZE,
+    "Expected block_header to be 16 bytes!"
+);
+STATIC_ASSERT(
+    BLOCK_HEADER_SIZE + BLOCK_FOOTER_SIZE == DYNAMIC_ALLOCATOR_BLOCK_OVERHEAD,
+    "Block overhead out of sync with the header!"
+);
+
+static u64 block_size(void* block) {
+    return ((block_header*)block)->size & ~BLOCK_ALLOCATED_FLAG;
+}
+
+static b8 block_is_allocated(void* block) {
+    return (((block_header*)block)->size & BLOCK_ALLOCATED_FLAG) != 0;
+}
+
+static void block_write_tags(void* block, u64 size, b8 allocated) {
+    u64 tag = size | (allocated ? BLOCK_ALLOCATED_FLAG : 0);
+    ((block_header*)block)->size = tag;
+    *(u64*)((u8*)block + size - BLOCK_FOOTER_SIZE) = tag;
+}
+
+// Block size needed to hold size bytes.
+static u64 get_block_size(u64 size) {
+    u64 needed = get_aligned(
+        size + DYNAMIC_ALLOCATOR_BLOCK_OVERHEAD, BLOCK_ALIGNMENT
+    );
+    return needed < BLOCK_MIN_SIZE ? BLOCK_MIN_SIZE : needed;
+}
+
+static void get_region(dynamic_allocator* allocator, u8** out_first, u8** out_end) {
+    u64 start = get_aligned((u64)allocator->memory, BLOCK_ALIGNMENT);
+    u64 end = ((u64)allocator->memory + allocator->total_size) &
+              ~(u64)(BLOCK_ALIGNMENT - 1);
+    // The first block starts after the prologue, the epilogue header takes the
+    // last BLOCK_HEADER_SIZE bytes.
+    *out_first = (u8*)(start + BLOCK_HEADER_SIZE);
+    *out_end = (u8*)(end - BLOCK_HEADER_SIZE);
+}
+
+static void free_list_insert_after(
+    dynamic_allocator* allocator, free_block* prev, free_block* node
+) {
+    node->prev = prev;
+    if (prev) {
+        node->next = prev->next;
+        prev->next = node;
+    } else {
+        node->next = allocator->free_list_head;
+        allocator->free_list_head = node;
+    }
+    if (node->next) {
+        node->next->prev = node;
+    }
+    allocator->free_block_count++;
+}
+
+static void free_list_remove(dynamic_allocator* allocator, free_block* node) {
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        allocator->free_list_head = node->next;
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    }
+    allocator->free_block_count--;
+}
+
+// Puts replacement at node's position in the list.
+static void free_list_replace(
+    dynamic_allocator* allocator, free_block* node, free_block* replacement
+) {
+    replacement->prev = node->prev;
+    replacement->next = node->next;
+    if (node->prev) {
+        node->prev->next = replacement;
+    } else {
+        allocator->free_list_head = replacement;
+    }
+    if (node->next) {
+        node->next->prev = replacement;
+    }
+}
+
+b8 dynamic_allocator_create(
+    u64 total_size, void* memory, dynamic_allocator* out_allocator
+) {
+    if (!out_allocator) {
+        OKO_ERROR("out_allocator is not a valid pointer.");
+        return false;
+    }
+
+    // Room for alignment padding, prologue, epilogue and one block.
+    u64 min_size = BLOCK_ALIGNMENT + BLOCK_HEADER_SIZE * 2 + BLOCK_MIN_SIZE;
+    if (total_size < min_size) {
+        OKO_ERROR(
+            "dynamic_allocator_create - total_size must be at least %lluB.",
+            min_size
+        );
+        return false;
+    }
+
+    if (memory) {
+        out_allocator->memory = memory;
+    } else {
+        out_allocator->memory =
+            memory_allocate(total_size, MEMORY_TAG_DYNAMIC_ALLOCATOR);
+        if (!out_allocator->memory) {
+            OKO_ERROR(
+                "dynamic_allocator_create - failed to allocate %llu bytes.",
+                total_size
+            );
+            return false;
+        }
+    }
+
+    out_allocator->total_size = total_size;
+    out_allocator->owns_memory = memory == 0;
+    out_allocator->allocated = 0;
+    out_allocator->allocation_count = 0;
+    out_allocator->free_block_count = 0;
+    out_allocator->free_list_head = 0;
+
+    u8* first;
+    u8* end;
+    get_region(out_allocator, &first, &end);
+
+    // The prologue footer and epilogue header look like allocated blocks so
+    // coalescing never walks off either end.
+    *(u64*)(first - BLOCK_FOOTER_SIZE) = BLOCK_ALLOCATED_FLAG;
+    ((block_header*)end)->size = BLOCK_ALLOCATED_FLAG;
+
+    free_block* block = (free_block*)first;
+    block_write_tags(block, end - first, false);
+    free_list_insert_after(out_allocator, 0, block);
+
+    return true;
+}
+
+void dynamic_allocator_destroy(dynamic_allocator* allocator) {
+    if (!allocator) {
+        OKO_ERROR("Dynamic allocator is not initialized.");
+        return;
+    }
+
+    if (allocator->owns_memory && allocator->memory) {
+        memory_free(
+            allocator->memory,
+            allocator->total_size,
+            MEMORY_TAG_DYNAMIC_ALLOCATOR
+        );
+    }
+
+    memory_zero(allocator, sizeof(dynamic_allocator));
+}
+
+void* dynamic_allocator_allocate(dynamic_allocator* allocator, u64 size) {
+    return dynamic_allocator_allocate_aligned(
+        allocator, size, BLOCK_ALIGNMENT
+    );
+}
+
+void* dynamic_allocator_allocate_aligned(
+    dynamic_allocator* allocator, u64 size, u16 alignment
+) {
+    if (!allocator || !allocator->memory) {
+        OKO_ERROR(
+            "dynamic_allocator_allocate - provided allocator not initialized."
+        );
+        return 0;
+    }
+    if (size == 0 || (alignment & (alignment - 1)) != 0) {
+        OKO_ERROR(
+            "dynamic_allocator_allocate - size must be non-zero and alignment "
+            "a power of 2."
+        );
+        return 0;
+    }
+    if (alignment < BLOCK_ALIGNMENT) {
+        alignment = BLOCK_ALIGNMENT;
+    }
+
+    u64 needed = get_block_size(size);
+
+    // First fit. The payload may have to be pushed forward to honour the
+    // alignment, in which case the skipped bytes must form a valid free block.
+    free_block* node = allocator->free_list_head;
+    u64 gap = 0;
+    while (node) {
+        u64 address = (u64)node;
+        u64 payload = get_aligned(address + BLOCK_HEADER_SIZE, alignment);
+        gap = payload - BLOCK_HEADER_SIZE - address;
+        if (gap != 0 && gap < BLOCK_MIN_SIZE) {
+            payload = get_aligned(
+                address + BLOCK_HEADER_SIZE + BLOCK_MIN_SIZE, alignment
+            );
+            gap = payload - BLOCK_HEADER_SIZE - address;
+        }
+        if (gap + needed <= block_size(node)) {
+            break;
+        }
+        node = node->next;
+    }
+
+    if (!node) {
+        OKO_ERROR(
+            "dynamic_allocator_allocate - No free block large enough for %lluB "
+            "(%lluB free).",
+            size,
+            dynamic_allocator_free_space(allocator)
+        );
+        return 0;
+    }
+
+    if (gap > 0) {
+        // Keep the leading bytes as a free block in the same list position.
+        u64 node_size = block_size(node);
+        block_write_tags(node, gap, false);
+
+        free_block* aligned_node = (free_block*)((u8*)node + gap);
+        block_write_tags(aligned_node, node_size - gap, false);
+        free_list_insert_after(allocator, node, aligned_node);
+        node = aligned_node;
+    }
+
+    u64 available = block_size(node);
+    if (available - needed >= BLOCK_MIN_SIZE) {
+        // Split, the tail keeps the node's place in the list.
+        free_block* tail = (free_block*)((u8*)node + needed);
+        block_write_tags(tail, available - needed, false);
+        free_list_replace(allocator, node, tail);
+    } else {
+        needed = available;
+        free_list_remove(allocator, node);
+    }
+
+    block_write_tags(node, needed, true);
+    node->header.requested = size;
+
+    allocator->allocated += needed;
+    allocator->allocation_count++;
+
+    return (u8*)node + BLOCK_HEADER_SIZE;
+}
+
+b8 dynamic_allocator_free(dynamic_allocator* allocator, void* block) {
+    if (!allocator || !allocator->memory || !block) {
+        OKO_ERROR(
+            "dynamic_allocator_free - requires a valid allocator and block."
+        );
+        return false;
+    }
+    if (!dynamic_allocator_owns(allocator, block)) {
+        OKO_ERROR(
+            "dynamic_allocator_free - block %p is outside this allocator.",
+            block
+        );
+        return false;
+    }
+
+    u8* header = (u8*)block - BLOCK_HEADER_SIZE;
+    if (!block_is_allocated(header)) {
+        OKO_ERROR("dynamic_allocator_free - block %p is not allocated.", block);
+        return false;
+    }
+
+    u64 size = block_size(header);
+    allocator->allocated -= size;
+    allocator->allocation_count--;
+
+    u64 prev_tag = *(u64*)(header - BLOCK_FOOTER_SIZE);
+    free_block* prev = 0;
+    if (!(prev_tag & BLOCK_ALLOCATED_FLAG)) {
+        prev = (free_block*)(header - prev_tag);
+    }
+    free_block* next = (free_block*)(header + size);
+    if (block_is_allocated(next)) {
+        next = 0;
+    }
+
+    if (prev && next) {
+        // Both neighbours are already in the list; prev absorbs the rest.
+        free_list_remove(allocator, next);
+        block_write_tags(
+            prev, block_size(prev) + size + block_size(next), false
+        );
+    } else if (prev) {
+        block_write_tags(prev, block_size(prev) + size, false);
+    } else if (next) {
+        // Nothing free lies between this block and next, so it can take next's
+        // place without breaking address order.
+        free_block* node = (free_block*)header;
+        block_write_tags(node, size + block_size(next), false);
+        free_list_replace(allocator, next, node);
+    } else {
+        // Isolated block, find its place in address order.
+        free_block* node = (free_block*)header;
+        block_write_tags(node, size, false);
+        free_block* prev_node = 0;
+        free_block* current = allocator->free_list_head;
+        while (current && current < node) {
+            prev_node = current;
+            current = current->next;
+        }
+        free_list_insert_after(allocator, prev_node, node);
+    }
+
+    return true;
+}
+
+b8 dynamic_allocator_resize(
+    dynamic_allocator* allocator, void* block, u64 new_size
+) {
+    if (!allocator || !allocator->memory || !block || new_size == 0) {
+        OKO_ERROR(
+            "dynamic_allocator_resize - requires a valid allocator, block and "
+            "size."
+        );
+        return false;
+    }
+    if (!dynamic_allocator_owns(allocator, block)) {
+        OKO_ERROR(
+            "dynamic_allocator_resize - block %p is outside this allocator.",
+            block
+        );
+        return false;
+    }
+
+    u8* header = (u8*)block - BLOCK_HEADER_SIZE;
+    if (!block_is_allocated(header)) {
+        OKO_ERROR(
+            "dynamic_allocator_resize - block %p is not allocated.", block
+        );
+        return false;
+    }
+
+    u64 size = block_size(header);
+    u64 needed = get_block_size(new_size);
+
+    if (needed <= size) {
+        if (size - needed >= BLOCK_MIN_SIZE) {
+            // Hand the tail back through the free path so it coalesces with
+            // whatever follows.
+            u8* tail = header + needed;
+            block_write_tags(header, needed, true);
+            block_write_tags(tail, size - needed, true);
+            allocator->allocation_count++;
+            dynamic_allocator_free(allocator, tail + BLOCK_HEADER_SIZE);
+        }
+        ((block_header*)header)->requested = new_size;
+        return true;
+    }
+
+    free_block* next = (free_block*)(header + size);
+    if (block_is_allocated(next) || size + block_size(next) < needed) {
+        return false;
+    }
+
+    u64 available = size + block_size(next);
+    if (available - needed >= BLOCK_MIN_SIZE) {
+        // What is left of next stays in its place in the list.
+        free_block* tail = (free_block*)(header + needed);
+        block_write_tags(tail, available - needed, false);
+        free_list_replace(allocator, next, tail);
+    } else {
+        needed = available;
+        free_list_remove(allocator, next);
+    }
+
+    block_write_tags(header, needed, true);
+    ((block_header*)header)->requested = new_size;
+    allocator->allocated += needed - size;
+    return true;
+}
+
+b8 dynamic_allocator_owns(dynamic_allocator* allocator, void* block) {
+    if (!allocator || !allocator->memory) {
+        return false;
+    }
+    u8* start = allocator->memory;
+    return (u8*)block >= start && (u8*)block < start + allocator->total_size;
+}
+
+u64 dynamic_allocator_free_space(dynamic_allocator* allocator) {
+    if (!allocator || !allocator->memory) {
+        return 0;
+    }
+    u8* first;
+    u8* end;
+    get_region(allocator, &first, &end);
+    return (u64)(end - first) - allocator->allocated;
+}
+
+u64 dynamic_allocator_largest_free_block(dynamic_allocator* allocator) {
+    if (!allocator || !allocator->memory) {
+        return 0;
+    }
+    u64 largest = 0;
+    for (free_block* node = allocator->free_list_head; node;
+         node = node->next) {
+        u64 size = block_size(node);
+        if (size > largest) {
+            largest = size;
+        }
+    }
+    return largest;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "defines.h"
+
+// General purpose allocator over a single block reserved up front.
+// Every block carries a boundary tag (header + footer) so freed blocks are
+// coalesced with their physical neighbours in O(1). Free blocks are kept in an
+// address-ordered list and allocation is first-fit, which keeps long-lived
+// blocks packed at the low end of the region.
+typedef struct dynamic_allocator {
+    u64 total_size;
+    // Bytes handed out, including block overhead.
+    u64 allocated;
+    u64 allocation_count;
+    u64 free_block_count;
+    void* memory;
+    void* free_list_head;
+    b8 owns_memory;
+} dynamic_allocator;
+
+// Bookkeeping per block. Requests are rounded up to 16 bytes plus this.
+#define DYNAMIC_ALLOCATOR_BLOCK_OVERHEAD 24
+
+OKO_API b8 dynamic_allocator_create(
+    u64 total_size, void* memory, dynamic_allocator* out_allocator
+);
+
+OKO_API void dynamic_allocator_destroy(dynamic_allocator* allocator);
+
+// Returned blocks are 16 byte aligned.
+OKO_API void* dynamic_allocator_allocate(dynamic_allocator* allocator, u64 size);
+
+// Alignment must be a power of 2.
+OKO_API void* dynamic_allocator_allocate_aligned(
+    dynamic_allocator* allocator, u64 size, u16 alignment
+);
+
+OKO_API b8 dynamic_allocator_free(dynamic_allocator* allocator, void* block);
+
+// Grows or shrinks an allocated block without moving it. Growing only succeeds
+// if the block is followed by enough free space, shrinking always does. The
+// contents up to the smaller of both sizes are kept.
+OKO_API b8 dynamic_allocator_resize(
+    dynamic_allocator* allocator, void* block, u64 new_size
+);
+
+// Indicates if the block lies within the allocator's memory.
+OKO_API b8 dynamic_allocator_owns(dynamic_allocator* allocator, void* block);
+
+OKO_API u64 dynamic_allocator_free_space(dynamic_allocator* allocator);
+
+// Walks the free list, so intended for reporting only.
+OKO_API u64 dynamic_allocator_largest_free_block(dynamic_allocator* allocator);
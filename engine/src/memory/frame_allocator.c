@@ -0,0 +1,121 @@
+#include "frame_allocator.h"
+
+#include "core/log.h"
+#include "memory/linear_allocator.h"
+
+#define FRAME_ARENA_COUNT 2
+
+typedef struct frame_allocator_state {
+    frame_allocator_config config;
+    linear_allocator arenas[FRAME_ARENA_COUNT];
+    u32 current;
+    u64 last_frame_usage;
+    u64 high_water_mark;
+} frame_allocator_state;
+
+static frame_allocator_state* state_ptr;
+
+b8 frame_allocator_system_initialize(
+    u64* memory_requirement, void* state, frame_allocator_config config
+) {
+    if (config.arena_size == 0) {
+        OKO_FATAL(
+            "frame_allocator_system_initialize - config.arena_size must be > 0."
+        );
+        return false;
+    }
+
+    *memory_requirement = sizeof(frame_allocator_state);
+    if (!state) {
+        return true;
+    }
+
+    state_ptr = state;
+    state_ptr->config = config;
+    state_ptr->current = 0;
+    state_ptr->last_frame_usage = 0;
+    state_ptr->high_water_mark = 0;
+
+    for (u32 i = 0; i < FRAME_ARENA_COUNT; ++i) {
+        if (!linear_allocator_create_reserved(
+                config.arena_size, &state_ptr->arenas[i]
+            )) {
+            OKO_FATAL("Failed to reserve memory for the frame allocator.");
+            while (i--) {
+                linear_allocator_destroy(&state_ptr->arenas[i]);
+            }
+            state_ptr = 0;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void frame_allocator_system_shutdown(void* state) {
+    if (state_ptr) {
+        for (u32 i = 0; i < FRAME_ARENA_COUNT; ++i) {
+            linear_allocator_destroy(&state_ptr->arenas[i]);
+        }
+    }
+    state_ptr = 0;
+}
+
+void frame_allocator_begin_frame() {
+    if (!state_ptr) {
+        return;
+    }
+
+    u64 usage = state_ptr->arenas[state_ptr->current].allocated;
+    state_ptr->last_frame_usage = usage;
+    if (usage > state_ptr->high_water_mark) {
+        state_ptr->high_water_mark = usage;
+    }
+
+    // The arena used two frames ago is no longer referenced by anyone. It is
+    // not cleared, that would cost a memset of the whole frame every frame.
+    state_ptr->current = (state_ptr->current + 1) % FRAME_ARENA_COUNT;
+    linear_allocator_reset(&state_ptr->arenas[state_ptr->current]);
+}
+
+void* frame_allocator_allocate(u64 size) {
+    return frame_allocator_allocate_aligned(
+        size, FRAME_ALLOCATOR_DEFAULT_ALIGNMENT
+    );
+}
+
+void* frame_allocator_allocate_aligned(u64 size, u16 alignment) {
+    if (!state_ptr) {
+        OKO_ERROR(
+            "frame_allocator_allocate called before the frame allocator was "
+            "initialized."
+        );
+        return 0;
+    }
+    return linear_allocator_allocate_aligned(
+        &state_ptr->arenas[state_ptr->current], size, alignment
+    );
+}
+
+u64 frame_allocator_get_frame_usage() {
+    if (!state_ptr) {
+        return 0;
+    }
+    return state_ptr->arenas[state_ptr->current].allocated;
+}
+
+u64 frame_allocator_get_last_frame_usage() {
+    if (!state_ptr) {
+        return 0;
+    }
+    return state_ptr->last_frame_usage;
+}
+
+u64 frame_allocator_get_high_water_mark() {
+    if (!state_ptr) {
+        return 0;
+    }
+    u64 usage = state_ptr->arenas[state_ptr->current].allocated;
+    return usage > state_ptr->high_water_mark ? usage
+                                              : state_ptr->high_water_mark;
+}
\ No newline at end of file
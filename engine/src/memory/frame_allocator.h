@@ -0,0 +1,37 @@
+#pragma once
+
+#include "defines.h"
+
+// Scratch memory that lives for two frames. Two linear arenas alternate; the
+// application resets one at the start of every frame, so data written during
+// frame N stays valid while frame N+1 is being built.
+typedef struct frame_allocator_config {
+    // Address space reserved for each of the two arenas. Pages are committed
+    // as frames first reach them.
+    u64 arena_size;
+} frame_allocator_config;
+
+OKO_API b8 frame_allocator_system_initialize(
+    u64* memory_requirement, void* state, frame_allocator_config config
+);
+OKO_API void frame_allocator_system_shutdown(void* state);
+
+// Called by the application at the start of every frame.
+OKO_API void frame_allocator_begin_frame();
+
+// Alignment of frame_allocator_allocate, enough for vec4 and mat4 data.
+#define FRAME_ALLOCATOR_DEFAULT_ALIGNMENT 16
+
+// Returns 0 if the current arena is full. The block is not zeroed and must
+// never be freed.
+OKO_API void* frame_allocator_allocate(u64 size);
+
+// Same as frame_allocator_allocate with a caller-chosen alignment, which must
+// be a power of 2.
+OKO_API void* frame_allocator_allocate_aligned(u64 size, u16 alignment);
+
+// Bytes allocated so far this frame.
+OKO_API u64 frame_allocator_get_frame_usage();
+OKO_API u64 frame_allocator_get_last_frame_usage();
+// Most bytes allocated in a single frame since startup.
+OKO_API u64 frame_allocator_get_high_water_mark();
\ No newline at end of file
@@ -20,7 +20,71 @@ void linear_allocator_create(
 
     out_allocator->total_size = total_size;
     out_allocator->owns_memory = memory == 0;
+    out_allocator->is_reserved = false;
     out_allocator->allocated = 0;
+    out_allocator->committed = total_size;
+    out_allocator->commit_size = 0;
+    // Owned memory comes zeroed, memory handed in may hold anything.
+    out_allocator->dirty = out_allocator->owns_memory ? 0 : total_size;
+}
+
+static b8 create_reserved(
+    u64 total_size,
+    void* memory,
+    u64 commit_size,
+    linear_allocator* out_allocator
+) {
+    if (!memory) {
+        return false;
+    }
+
+    out_allocator->memory = memory;
+    out_allocator->total_size = total_size;
+    out_allocator->owns_memory = true;
+    out_allocator->is_reserved = true;
+    out_allocator->allocated = 0;
+    out_allocator->committed = 0;
+    out_allocator->commit_size = commit_size;
+    // Freshly committed pages are zero.
+    out_allocator->dirty = 0;
+    return true;
+}
+
+b8 linear_allocator_create_reserved(
+    u64 total_size, linear_allocator* out_allocator
+) {
+    if (!out_allocator) {
+        OKO_ERROR("out_allocator is not a valid pointer.");
+        return false;
+    }
+
+    total_size = get_aligned(total_size, memory_get_page_size());
+    return create_reserved(
+        total_size,
+        memory_reserve(total_size),
+        LINEAR_ALLOCATOR_COMMIT_SIZE,
+        out_allocator
+    );
+}
+
+b8 linear_allocator_create_reserved_huge(
+    u64 total_size, const char* name, linear_allocator* out_allocator
+) {
+    if (!out_allocator) {
+        OKO_ERROR("out_allocator is not a valid pointer.");
+        return false;
+    }
+
+    // Committing less than a huge page at a time would split the mapping
+    // back into regular pages.
+    u64 huge_page_size = memory_get_huge_page_size();
+    total_size = get_aligned(total_size, huge_page_size);
+    return create_reserved(
+        total_size,
+        memory_reserve_huge(total_size, name),
+        huge_page_size,
+        out_allocator
+    );
 }
 
 void linear_allocator_destroy(linear_allocator* allocator) {
@@ -29,7 +93,12 @@ void linear_allocator_destroy(linear_allocator* allocator) {
         return;
     }
 
-    if (allocator->owns_memory && allocator->memory) {
+    if (allocator->is_reserved && allocator->memory) {
+        if (allocator->committed) {
+            memory_decommit(allocator->memory, allocator->committed);
+        }
+        memory_release(allocator->memory, allocator->total_size);
+    } else if (allocator->owns_memory && allocator->memory) {
         memory_free(
             allocator->memory,
             allocator->total_size,
@@ -40,18 +109,41 @@ void linear_allocator_destroy(linear_allocator* allocator) {
     allocator->memory = 0;
     allocator->total_size = 0;
     allocator->owns_memory = false;
+    allocator->is_reserved = false;
     allocator->allocated = 0;
+    allocator->committed = 0;
+    allocator->commit_size = 0;
+    allocator->dirty = 0;
 }
 
 void* linear_allocator_allocate(linear_allocator* allocator, u64 size) {
+    return linear_allocator_allocate_aligned(allocator, size, 1);
+}
+
+void* linear_allocator_allocate_aligned(
+    linear_allocator* allocator, u64 size, u16 alignment
+) {
     if (!allocator || !allocator->memory) {
         OKO_ERROR(
             "linear_allocator_allocate - provided allocator not initialized."
         );
         return 0;
     }
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        OKO_ERROR(
+            "linear_allocator_allocate - alignment must be a power of 2, got "
+            "%u.",
+            alignment
+        );
+        return 0;
+    }
 
-    if (allocator->allocated + size > allocator->total_size) {
+    // Align the address rather than the offset so the block is aligned no
+    // matter where the backing memory starts.
+    u64 base = (u64)allocator->memory;
+    u64 offset = get_aligned(base + allocator->allocated, alignment) - base;
+
+    if (offset + size > allocator->total_size) {
         u64 remaining = allocator->total_size - allocator->allocated;
         OKO_ERROR(
             "linear_allocator_allocate - Tried to allocate %lluB, only %lluB remaining.",
@@ -61,11 +153,65 @@ void* linear_allocator_allocate(linear_allocator* allocator, u64 size) {
         return 0;
     }
 
-    void* block = ((u8*)allocator->memory) + allocator->allocated;
-    allocator->allocated += size;
+    if (offset + size > allocator->committed) {
+        // Only reserved allocators get here, grow the committed range.
+        u64 commit_end =
+            get_aligned(offset + size, allocator->commit_size);
+        if (commit_end > allocator->total_size) {
+            commit_end = allocator->total_size;
+        }
+        if (!memory_commit(
+                (u8*)allocator->memory + allocator->committed,
+                commit_end - allocator->committed
+            )) {
+            return 0;
+        }
+        allocator->committed = commit_end;
+    }
+
+    void* block = ((u8*)allocator->memory) + offset;
+    allocator->allocated = offset + size;
+    if (allocator->allocated > allocator->dirty) {
+        allocator->dirty = allocator->allocated;
+    }
     return block;
 }
 
+linear_allocator_marker linear_allocator_get_marker(
+    linear_allocator* allocator
+) {
+    if (!allocator || !allocator->memory) {
+        OKO_ERROR(
+            "linear_allocator_get_marker - provided allocator not initialized."
+        );
+        return 0;
+    }
+    return allocator->allocated;
+}
+
+void linear_allocator_free_to_marker(
+    linear_allocator* allocator, linear_allocator_marker marker
+) {
+    if (!allocator || !allocator->memory) {
+        OKO_ERROR(
+            "linear_allocator_free_to_marker - provided allocator not "
+            "initialized."
+        );
+        return;
+    }
+    if (marker > allocator->allocated) {
+        OKO_ERROR(
+            "linear_allocator_free_to_marker - marker %llu is past the current "
+            "offset %llu. Markers must be restored in reverse order.",
+            marker,
+            allocator->allocated
+        );
+        return;
+    }
+
+    allocator->allocated = marker;
+}
+
 void linear_allocator_free_all(linear_allocator* allocator) {
     if (!allocator || !allocator->memory) {
         OKO_ERROR(
@@ -75,5 +221,18 @@ void linear_allocator_free_all(linear_allocator* allocator) {
     }
 
     allocator->allocated = 0;
-    memory_zero(allocator->memory, allocator->total_size);
+    // Only the part handed out since the last clear can be non-zero.
+    memory_zero(allocator->memory, allocator->dirty);
+    allocator->dirty = 0;
+}
+
+void linear_allocator_reset(linear_allocator* allocator) {
+    if (!allocator || !allocator->memory) {
+        OKO_ERROR(
+            "linear_allocator_reset - provided allocator not initialized."
+        );
+        return;
+    }
+
+    allocator->allocated = 0;
 }
\ No newline at end of file
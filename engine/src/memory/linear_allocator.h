@@ -5,16 +5,62 @@
 typedef struct linear_allocator {
     u64 total_size;
     u64 allocated;
+    // Bytes that may hold stale data since the last clearing reset.
+    u64 dirty;
+    // Bytes backed by memory. Only less than total_size for reserved
+    // allocators.
+    u64 committed;
+    // Granularity the committed range grows by.
+    u64 commit_size;
     void* memory;
     b8 owns_memory;
+    b8 is_reserved;
 } linear_allocator;
 
+// Granularity reserved allocators commit in, to keep syscalls rare.
+#define LINEAR_ALLOCATOR_COMMIT_SIZE (64 * 1024)
+
+// Offset to rewind to with linear_allocator_free_to_marker.
+typedef u64 linear_allocator_marker;
+
 OKO_API void linear_allocator_create(
     u64 total_size, void* memory, linear_allocator* out_allocator
 );
 
+// Reserves total_size bytes of address space and commits pages as allocations
+// reach them, so the arena can grow without moving or copying.
+OKO_API b8 linear_allocator_create_reserved(
+    u64 total_size, linear_allocator* out_allocator
+);
+
+// Same as linear_allocator_create_reserved, but the range is backed by huge
+// pages where available to cut TLB misses on large arenas. Commits grow in
+// whole huge pages. name identifies the arena in the memory usage report.
+OKO_API b8 linear_allocator_create_reserved_huge(
+    u64 total_size, const char* name, linear_allocator* out_allocator
+);
+
 OKO_API void linear_allocator_destroy(linear_allocator* allocator);
 
 OKO_API void* linear_allocator_allocate(linear_allocator* allocator, u64 size);
 
-OKO_API void linear_allocator_free_all(linear_allocator* allocator);
\ No newline at end of file
+// Alignment must be a power of 2.
+OKO_API void* linear_allocator_allocate_aligned(
+    linear_allocator* allocator, u64 size, u16 alignment
+);
+
+OKO_API linear_allocator_marker
+linear_allocator_get_marker(linear_allocator* allocator);
+
+// Releases everything allocated after the marker was taken. Memory is not
+// cleared.
+OKO_API void linear_allocator_free_to_marker(
+    linear_allocator* allocator, linear_allocator_marker marker
+);
+
+// Releases everything and zeroes the bytes touched since the last clear.
+OKO_API void linear_allocator_free_all(linear_allocator* allocator);
+
+// Releases everything in O(1). Memory is not cleared, later allocations return
+// stale data.
+OKO_API void linear_allocator_reset(linear_allocator* allocator);
\ No newline at end of file
@@ -0,0 +1,274 @@
+#include "pool_allocator.h"
+
+#include "core/log.h"
+
+/*
+Block layout
+void* next = next block in the chain
+u8 padding[56]
+elements[elements_per_block], each stride bytes apart
+*/
+
+// Elements start on a cache line, so elements whose stride is a multiple of
+// the line size never straddle two.
+#define POOL_BLOCK_HEADER_SIZE OKO_CACHE_LINE_SIZE
+#define POOL_BLOCK_ALIGNMENT   OKO_CACHE_LINE_SIZE
+
+typedef struct pool_block {
+    struct pool_block* next;
+} pool_block;
+
+// A free slot. poison only fits when the stride has room for it.
+typedef struct pool_slot {
+    struct pool_slot* next;
+    u64 poison;
+} pool_slot;
+
+// Written into free slots, a live element would have to hold exactly this.
+#define POOL_FREE_POISON 0xDEADF4EEB10C0000ull
+
+static b8 has_poison(pool_allocator* allocator) {
+    return allocator->stride >= sizeof(pool_slot);
+}
+
+static u64 block_size(pool_allocator* allocator) {
+    return POOL_BLOCK_HEADER_SIZE +
+           allocator->stride * allocator->elements_per_block;
+}
+
+static b8 add_block(pool_allocator* allocator) {
+    pool_block* block = memory_allocate_aligned(
+        block_size(allocator), POOL_BLOCK_ALIGNMENT, allocator->tag
+    );
+    if (!block) {
+        return false;
+    }
+
+    block->next = allocator->blocks;
+    allocator->blocks = block;
+    allocator->block_count++;
+
+    // Chain the new slots in address order in front of the free list.
+    u8* elements = (u8*)block + POOL_BLOCK_HEADER_SIZE;
+    b8 poison = has_poison(allocator);
+    for (u64 i = 0; i < allocator->elements_per_block; ++i) {
+        pool_slot* slot = (pool_slot*)(elements + allocator->stride * i);
+        slot->next = i + 1 < allocator->elements_per_block
+                         ? (pool_slot*)(elements + allocator->stride * (i + 1))
+                         : allocator->free_list;
+        if (poison) {
+            slot->poison = POOL_FREE_POISON;
+        }
+    }
+    allocator->free_list = elements;
+
+    return true;
+}
+
+b8 pool_allocator_create(
+    const char* name,
+    u64 element_size,
+    u64 elements_per_block,
+    b8 can_grow,
+    memory_tag tag,
+    pool_allocator* out_allocator
+) {
+    if (!out_allocator) {
+        OKO_ERROR("out_allocator is not a valid pointer.");
+        return false;
+    }
+    if (!element_size || !elements_per_block) {
+        OKO_ERROR(
+            "element_size and elements_per_block must be a positive non-zero "
+            "value."
+        );
+        return false;
+    }
+
+    memory_zero(out_allocator, sizeof(pool_allocator));
+    out_allocator->name = name;
+    out_allocator->tag = tag;
+    out_allocator->element_size = element_size;
+    // Every slot has to be able to hold the free list link.
+    out_allocator->stride = get_aligned(
+        element_size < sizeof(void*) ? sizeof(void*) : element_size,
+        sizeof(void*)
+    );
+    out_allocator->elements_per_block = elements_per_block;
+    out_allocator->can_grow = can_grow;
+
+    if (!add_block(out_allocator)) {
+        OKO_ERROR("pool_allocator_create - failed to allocate the first block.");
+        return false;
+    }
+
+    memory_register_pool(out_allocator);
+    return true;
+}
+
+static void release_blocks(pool_allocator* allocator) {
+    memory_unregister_pool(allocator);
+
+    u64 size = block_size(allocator);
+    pool_block* block = allocator->blocks;
+    while (block) {
+        pool_block* next = block->next;
+        memory_free_aligned(block, size, POOL_BLOCK_ALIGNMENT, allocator->tag);
+        block = next;
+    }
+
+    memory_zero(allocator, sizeof(pool_allocator));
+}
+
+void pool_allocator_destroy(pool_allocator* allocator) {
+    if (!allocator) {
+        OKO_ERROR("Pool allocator is not initialized.");
+        return;
+    }
+
+    if (allocator->allocated_count) {
+        OKO_WARN(
+            "Pool allocator '%s' destroyed with %llu elements still allocated.",
+            allocator->name ? allocator->name : "",
+            allocator->allocated_count
+        );
+    }
+
+    release_blocks(allocator);
+}
+
+void pool_allocator_discard(pool_allocator* allocator) {
+    if (!allocator) {
+        OKO_ERROR("Pool allocator is not initialized.");
+        return;
+    }
+
+    release_blocks(allocator);
+}
+
+void pool_allocator_replace(
+    pool_allocator* destination, pool_allocator* source
+) {
+    if (!destination || !source || !source->blocks) {
+        OKO_ERROR("pool_allocator_replace - requires two pools, source created.");
+        return;
+    }
+
+    if (destination->blocks) {
+        release_blocks(destination);
+    }
+    memory_unregister_pool(source);
+    memory_copy(destination, source, sizeof(pool_allocator));
+    memory_register_pool(destination);
+    memory_zero(source, sizeof(pool_allocator));
+}
+
+void* pool_allocator_allocate(pool_allocator* allocator) {
+    if (!allocator || !allocator->blocks) {
+        OKO_ERROR(
+            "pool_allocator_allocate - provided allocator not initialized."
+        );
+        return 0;
+    }
+
+    if (!allocator->free_list) {
+        if (!allocator->can_grow) {
+            OKO_ERROR(
+                "pool_allocator_allocate - pool '%s' is full (%llu elements).",
+                allocator->name ? allocator->name : "",
+                pool_allocator_capacity(allocator)
+            );
+            return 0;
+        }
+        if (!add_block(allocator)) {
+            OKO_ERROR(
+                "pool_allocator_allocate - pool '%s' failed to grow.",
+                allocator->name ? allocator->name : ""
+            );
+            return 0;
+        }
+    }
+
+    pool_slot* element = allocator->free_list;
+    allocator->free_list = element->next;
+    if (has_poison(allocator)) {
+        // element_size may stop short of the poison word.
+        element->poison = 0;
+    }
+    memory_zero(element, allocator->element_size);
+
+    allocator->allocated_count++;
+    if (allocator->allocated_count > allocator->peak_count) {
+        allocator->peak_count = allocator->allocated_count;
+    }
+    return element;
+}
+
+void pool_allocator_free(pool_allocator* allocator, void* element) {
+    if (!allocator || !element) {
+        OKO_ERROR("pool_allocator_free - requires a valid allocator and element."
+        );
+        return;
+    }
+
+    pool_slot* slot = element;
+    b8 poison = has_poison(allocator);
+    // The poison only says the slot may be free, a live element can hold the
+    // same value. Only the free list can tell, so walk it then.
+    b8 check_free_list = poison && slot->poison == POOL_FREE_POISON;
+
+#if OKO_POOL_VALIDATION
+    if (!pool_allocator_owns(allocator, element)) {
+        OKO_ERROR(
+            "pool_allocator_free - element %p is not a slot of pool '%s'.",
+            element,
+            allocator->name ? allocator->name : ""
+        );
+        return;
+    }
+    check_free_list = check_free_list || !poison;
+#endif
+
+    if (check_free_list) {
+        for (pool_slot* free = allocator->free_list; free; free = free->next) {
+            if (free == slot) {
+                OKO_ERROR(
+                    "pool_allocator_free - element %p of pool '%s' is already "
+                    "free.",
+                    element,
+                    allocator->name ? allocator->name : ""
+                );
+                return;
+            }
+        }
+    }
+
+    slot->next = allocator->free_list;
+    if (poison) {
+        slot->poison = POOL_FREE_POISON;
+    }
+    allocator->free_list = slot;
+    allocator->allocated_count--;
+}
+
+b8 pool_allocator_owns(pool_allocator* allocator, void* element) {
+    if (!allocator) {
+        return false;
+    }
+    u64 elements_size = allocator->stride * allocator->elements_per_block;
+    for (pool_block* block = allocator->blocks; block; block = block->next) {
+        u8* elements = (u8*)block + POOL_BLOCK_HEADER_SIZE;
+        if ((u8*)element >= elements &&
+            (u8*)element < elements + elements_size) {
+            return ((u8*)element - elements) % allocator->stride == 0;
+        }
+    }
+    return false;
+}
+
+u64 pool_allocator_capacity(pool_allocator* allocator) {
+    if (!allocator) {
+        return 0;
+    }
+    return allocator->block_count * allocator->elements_per_block;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "defines.h"
+
+#include "core/memory.h"
+
+// Fixed-size element allocator. Elements are carved out of blocks of
+// elements_per_block slots; free slots are chained through their own first
+// bytes, so allocate and free are O(1). When can_grow is set, a new block is
+// chained on once every slot is taken.
+//
+// Pools register with the memory system for the usage report, so the struct
+// must not move between create and destroy.
+
+// Free checks that walk the pool: elements from elsewhere and double frees of
+// pointer-sized elements. O(blocks + free slots) per free, so off unless
+// OKO_POOL_VALIDATION=1 is defined.
+#ifndef OKO_POOL_VALIDATION
+  #define OKO_POOL_VALIDATION 0
+#endif
+typedef struct pool_allocator {
+    const char* name;
+    memory_tag tag;
+    u64 element_size;
+    // Bytes between consecutive elements.
+    u64 stride;
+    u64 elements_per_block;
+    u64 block_count;
+    u64 allocated_count;
+    u64 peak_count;
+    b8 can_grow;
+    void* free_list;
+    void* blocks;
+} pool_allocator;
+
+OKO_API b8 pool_allocator_create(
+    const char* name,
+    u64 element_size,
+    u64 elements_per_block,
+    b8 can_grow,
+    memory_tag tag,
+    pool_allocator* out_allocator
+);
+
+OKO_API void pool_allocator_destroy(pool_allocator* allocator);
+
+// Like pool_allocator_destroy, for owners that drop their live elements along
+// with the pool on purpose, so they are not reported.
+OKO_API void pool_allocator_discard(pool_allocator* allocator);
+
+// Discards destination and moves source into its place, leaving source
+// destroyed. Lets a pool be rebuilt elsewhere and swapped in without moving
+// a registered pool.
+OKO_API void pool_allocator_replace(
+    pool_allocator* destination, pool_allocator* source
+);
+
+// Returns a zeroed element, or 0 if the pool is full and cannot grow.
+OKO_API void* pool_allocator_allocate(pool_allocator* allocator);
+
+// Rejects elements already free: slots of two pointers or more carry a
+// poison word while free, and only elements holding it are looked up in the
+// free list. With OKO_POOL_VALIDATION also rejects elements from elsewhere
+// and double frees of smaller slots.
+OKO_API void pool_allocator_free(pool_allocator* allocator, void* element);
+
+// True if element is the start of a slot in one of the pool's blocks. Walks
+// the block chain.
+OKO_API b8 pool_allocator_owns(pool_allocator* allocator, void* element);
+
+OKO_API u64 pool_allocator_capacity(pool_allocator* allocator);
\ No newline at end of file
@@ -8,6 +8,8 @@
 #include "core/input.h"
 #include "core/application.h"
 
+#include "memory/frame_allocator.h"
+
 #include "math/math.h"
 
 #include "game_types.h"
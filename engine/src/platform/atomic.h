@@ -0,0 +1,109 @@
+#pragma once
+
+#include "defines.h"
+
+// Typed atomics over the compiler builtins. Wrapping the value in a struct
+// keeps plain reads and writes from slipping in, every access names its
+// memory order:
+//   RELAXED: atomicity only, no ordering.
+//   ACQUIRE: on loads, later accesses stay after it.
+//   RELEASE: on stores, earlier accesses stay before it.
+//   ACQ_REL: both, for read-modify-writes.
+//   SEQ_CST: one total order over all SEQ_CST operations.
+typedef enum atomic_order {
+    ATOMIC_ORDER_RELAXED = __ATOMIC_RELAXED,
+    ATOMIC_ORDER_ACQUIRE = __ATOMIC_ACQUIRE,
+    ATOMIC_ORDER_RELEASE = __ATOMIC_RELEASE,
+    ATOMIC_ORDER_ACQ_REL = __ATOMIC_ACQ_REL,
+    ATOMIC_ORDER_SEQ_CST = __ATOMIC_SEQ_CST
+} atomic_order;
+
+// Declares atomic_<name> and its load, store, exchange and
+// compare_exchange. compare_exchange stores desired if the value equals
+// *expected and returns true, otherwise writes the current value to
+// *expected. It is the strong form, it never fails spuriously.
+#define OKO_ATOMIC_DEFINE(name, type)                                         \
+  typedef struct atomic_##name {                                              \
+      type value;                                                             \
+  } atomic_##name;                                                            \
+                                                                              \
+  OKO_INLINE type atomic_##name##_load(                                       \
+      const atomic_##name* atomic, atomic_order order                         \
+  ) {                                                                         \
+      return __atomic_load_n(&atomic->value, order);                          \
+  }                                                                           \
+                                                                              \
+  OKO_INLINE void atomic_##name##_store(                                      \
+      atomic_##name* atomic, type value, atomic_order order                   \
+  ) {                                                                         \
+      __atomic_store_n(&atomic->value, value, order);                         \
+  }                                                                           \
+                                                                              \
+  OKO_INLINE type atomic_##name##_exchange(                                   \
+      atomic_##name* atomic, type value, atomic_order order                   \
+  ) {                                                                         \
+      return __atomic_exchange_n(&atomic->value, value, order);               \
+  }                                                                           \
+                                                                              \
+  OKO_INLINE b8 atomic_##name##_compare_exchange(                             \
+      atomic_##name* atomic, type* expected, type desired, atomic_order order \
+  ) {                                                                         \
+      return __atomic_compare_exchange_n(                                     \
+          &atomic->value,                                                     \
+          expected,                                                           \
+          desired,                                                            \
+          false,                                                              \
+          order,                                                              \
+          order == ATOMIC_ORDER_ACQ_REL   ? ATOMIC_ORDER_ACQUIRE              \
+          : order == ATOMIC_ORDER_RELEASE ? ATOMIC_ORDER_RELAXED              \
+                                          : order                             \
+      );                                                                      \
+  }
+
+// Adds fetch_add, fetch_sub, fetch_and, fetch_or and fetch_xor, which return
+// the previous value.
+#define OKO_ATOMIC_DEFINE_INTEGER(name, type)                                 \
+  OKO_ATOMIC_DEFINE(name, type)                                               \
+                                                                              \
+  OKO_INLINE type atomic_##name##_fetch_add(                                  \
+      atomic_##name* atomic, type value, atomic_order order                   \
+  ) {                                                                         \
+      return __atomic_fetch_add(&atomic->value, value, order);                \
+  }                                                                           \
+                                                                              \
+  OKO_INLINE type atomic_##name##_fetch_sub(                                  \
+      atomic_##name* atomic, type value, atomic_order order                   \
+  ) {                                                                         \
+      return __atomic_fetch_sub(&atomic->value, value, order);                \
+  }                                                                           \
+                                                                              \
+  OKO_INLINE type atomic_##name##_fetch_and(                                  \
+      atomic_##name* atomic, type value, atomic_order order                   \
+  ) {                                                                         \
+      return __atomic_fetch_and(&atomic->value, value, order);                \
+  }                                                                           \
+                                                                              \
+  OKO_INLINE type atomic_##name##_fetch_or(                                   \
+      atomic_##name* atomic, type value, atomic_order order                   \
+  ) {                                                                         \
+      return __atomic_fetch_or(&atomic->value, value, order);                 \
+  }                                                                           \
+                                                                              \
+  OKO_INLINE type atomic_##name##_fetch_xor(                                  \
+      atomic_##name* atomic, type value, atomic_order order                   \
+  ) {                                                                         \
+      return __atomic_fetch_xor(&atomic->value, value, order);                \
+  }
+
+OKO_ATOMIC_DEFINE(b8, b8)
+OKO_ATOMIC_DEFINE(ptr, void*)
+OKO_ATOMIC_DEFINE_INTEGER(u32, u32)
+OKO_ATOMIC_DEFINE_INTEGER(u64, u64)
+OKO_ATOMIC_DEFINE_INTEGER(i32, i32)
+OKO_ATOMIC_DEFINE_INTEGER(i64, i64)
+
+// Orders the surrounding plain and relaxed accesses without an atomic
+// variable of its own.
+OKO_INLINE void atomic_fence(atomic_order order) {
+    __atomic_thread_fence(order);
+}
\ No newline at end of file
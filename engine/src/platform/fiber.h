@@ -0,0 +1,36 @@
+#pragma once
+
+#include "defines.h"
+
+// Saved execution state that a thread can switch into and out of by hand.
+// A fiber runs on whichever thread switches to it, and may later be resumed
+// on a different one.
+
+// Must never return: a fiber ends by switching away for good.
+typedef void (*PFN_fiber_start)(void* params);
+
+typedef struct fiber_context {
+    // opaque handle to internal context
+    void* internal_data;
+} fiber_context;
+
+// Prepares a context that calls start_function(params) when first switched
+// to, running on stack. The stack belongs to the caller and must outlive the
+// context. Windows allocates fiber stacks itself and only uses stack_size.
+OKO_API b8 fiber_context_create(
+    PFN_fiber_start start_function,
+    void* params,
+    void* stack,
+    u64 stack_size,
+    fiber_context* out_context
+);
+
+// A context for the calling thread itself, so fibers can switch back to it.
+// Destroy it on the same thread once done.
+OKO_API b8 fiber_context_create_from_thread(fiber_context* out_context);
+
+OKO_API void fiber_context_destroy(fiber_context* context);
+
+// Saves the calling thread's state into from and continues with to. Returns
+// once something switches back to from.
+OKO_API void fiber_context_switch(fiber_context* from, fiber_context* to);
\ No newline at end of file
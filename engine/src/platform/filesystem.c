@@ -137,4 +137,12 @@ b8 filesystem_write(
     }
 
     return bytes_written == data_size;
+}
+
+b8 filesystem_flush(file_handle* handle) {
+    if (!handle->is_valid) {
+        OKO_ERROR("Invalid file handle passed to filesystem_flush.");
+        return false;
+    }
+    return fflush((FILE*)handle->handle) == 0;
 }
\ No newline at end of file
@@ -35,4 +35,7 @@ OKO_API b8 filesystem_read_all_bytes(
 
 OKO_API b8 filesystem_write(
     file_handle* handle, u64 data_size, const void* data, u64* out_bytes_written
-);
\ No newline at end of file
+);
+
+// Hands buffered writes to the operating system.
+OKO_API b8 filesystem_flush(file_handle* handle);
\ No newline at end of file
@@ -16,10 +16,37 @@ void platform_system_shutdown(void* state);
 
 b8 platform_pump_messages();
 
+// When aligned is set, the block is aligned to OKO_CACHE_LINE_SIZE.
 void* platform_allocate(u64 size, b8 aligned);
 void platform_free(void* block, b8 aligned);
+// Only for blocks from platform_allocate without alignment. The contents are
+// kept up to the smaller size, the block may move.
+void* platform_reallocate(void* block, u64 size);
+
+// Alignment must be a power of 2. Blocks must be freed with
+// platform_free_aligned.
+void* platform_allocate_aligned(u64 size, u64 alignment);
+void platform_free_aligned(void* block);
+// Virtual memory. Reserved address space is inaccessible until committed.
+// Addresses and sizes must be multiples of the page size.
+u64 platform_get_page_size();
+void* platform_reserve_memory(u64 size);
+b8 platform_commit_memory(void* address, u64 size);
+void platform_decommit_memory(void* address, u64 size);
+void platform_release_memory(void* address, u64 size);
+
+// Reserves size bytes (a multiple of the huge page size) and asks for them to
+// be backed by huge pages once committed. out_huge_pages is false when the
+// platform cannot, in which case the range is a regular reservation.
+// Windows always falls back: large pages need SeLockMemoryPrivilege and are
+// committed when reserved, so they cannot back ranges committed as they grow.
+u64 platform_get_huge_page_size();
+void* platform_reserve_huge_memory(u64 size, b8* out_huge_pages);
+
 void* platform_zero_memory(void* block, u64 size);
 void* platform_copy_memory(void* dest, const void* source, u64 size);
+// Like copy, but the ranges may overlap.
+void* platform_move_memory(void* dest, const void* source, u64 size);
 void* platform_set_memory(void* dest, i32 value, u64 size);
 
 void platform_console_write(const char* message, u8 color);
@@ -27,4 +54,7 @@ void platform_console_write_error(const char* message, u8 color);
 
 f64 platform_get_absolute_time();
 
-void platform_sleep(u64 ms);
\ No newline at end of file
+void platform_sleep(u64 ms);
+
+// Logical processors available to the process, at least 1.
+u32 platform_get_processor_count();
\ No newline at end of file
@@ -1,3 +1,5 @@
+// For pthread_setname_np and pthread_setaffinity_np.
+#define _GNU_SOURCE
 #include "platform/platform.h"
 
 #if OKO_PLATFORM_LINUX
@@ -5,6 +7,9 @@
   #include "core/log.h"
   #include "core/event.h"
   #include "core/input.h"
+  #include "core/memory.h"
+  #include "platform/thread.h"
+  #include "platform/fiber.h"
 
   #include "containers/darray.h"
 
@@ -14,12 +19,19 @@
   #include <X11/Xlib.h>
   #include <X11/Xlib-xcb.h>  // sudo apt-get install libxkbcommon-x11-dev
   #include <sys/time.h>
+  #include <sys/mman.h>
+  #include <pthread.h>
+  #include <sched.h>
+  #include <semaphore.h>
+  #include <errno.h>
+  #include <ucontext.h>
 
   #if _POSIX_C_SOURCE >= 199309L
     #include <time.h>  // nanosleep
   #else
     #include <unistd.h>  // usleep
   #endif
+  #include <unistd.h>  // sysconf
 
   #include <stdlib.h>
   #include <stdio.h>
@@ -284,17 +296,112 @@ OKO_API b8 platform_pump_messages() {
 }
 
 void* platform_allocate(u64 size, b8 aligned) {
+    if (aligned) {
+        return platform_allocate_aligned(size, OKO_CACHE_LINE_SIZE);
+    }
     return malloc(size);
 }
 void platform_free(void* block, b8 aligned) {
     free(block);
 }
+void* platform_reallocate(void* block, u64 size) {
+    return realloc(block, size);
+}
+void* platform_allocate_aligned(u64 size, u64 alignment) {
+    // posix_memalign requires a multiple of sizeof(void*).
+    if (alignment < sizeof(void*)) {
+        alignment = sizeof(void*);
+    }
+    void* block = 0;
+    if (posix_memalign(&block, alignment, size) != 0) {
+        return 0;
+    }
+    return block;
+}
+void platform_free_aligned(void* block) {
+    free(block);
+}
+u64 platform_get_page_size() {
+    return (u64)sysconf(_SC_PAGESIZE);
+}
+void* platform_reserve_memory(u64 size) {
+    // MAP_NORESERVE: nothing is charged against overcommit until committed.
+    void* address = mmap(
+        0, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0
+    );
+    return address == MAP_FAILED ? 0 : address;
+}
+b8 platform_commit_memory(void* address, u64 size) {
+    // Pages are zero filled by the kernel on first touch.
+    return mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+}
+void platform_decommit_memory(void* address, u64 size) {
+    madvise(address, size, MADV_DONTNEED);
+    mprotect(address, size, PROT_NONE);
+}
+void platform_release_memory(void* address, u64 size) {
+    munmap(address, size);
+}
+u64 platform_get_huge_page_size() {
+    static u64 huge_page_size = 0;
+    if (!huge_page_size) {
+        huge_page_size = 2 * 1024 * 1024;
+        FILE* file =
+            fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r");
+        if (file) {
+            unsigned long long size = 0;
+            if (fscanf(file, "%llu", &size) == 1 && size) {
+                huge_page_size = size;
+            }
+            fclose(file);
+        }
+    }
+    return huge_page_size;
+}
+static b8 transparent_huge_pages_enabled() {
+    // "always [madvise] never", the bracketed entry is the active mode.
+    FILE* file = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (!file) {
+        return false;
+    }
+    char mode[128] = {0};
+    b8 enabled = fgets(mode, sizeof(mode), file) && !strstr(mode, "[never]");
+    fclose(file);
+    return enabled;
+}
+void* platform_reserve_huge_memory(u64 size, b8* out_huge_pages) {
+    *out_huge_pages = false;
+    u64 huge_page_size = platform_get_huge_page_size();
+
+    // Over-reserve, then trim so the range starts on a huge page boundary.
+    u64 padded_size = size + huge_page_size;
+    u8* address = platform_reserve_memory(padded_size);
+    if (!address) {
+        return 0;
+    }
+    u8* aligned = (u8*)get_aligned((u64)address, huge_page_size);
+    if (aligned > address) {
+        munmap(address, aligned - address);
+    }
+    u64 tail = (address + padded_size) - (aligned + size);
+    if (tail) {
+        munmap(aligned + size, tail);
+    }
+
+    if (transparent_huge_pages_enabled()) {
+        *out_huge_pages = madvise(aligned, size, MADV_HUGEPAGE) == 0;
+    }
+    return aligned;
+}
 void* platform_zero_memory(void* block, u64 size) {
     return memset(block, 0, size);
 }
 void* platform_copy_memory(void* dest, const void* source, u64 size) {
     return memcpy(dest, source, size);
 }
+void* platform_move_memory(void* dest, const void* source, u64 size) {
+    return memmove(dest, source, size);
+}
 void* platform_set_memory(void* dest, i32 value, u64 size) {
     return memset(dest, value, size);
 }
@@ -332,6 +439,310 @@ void platform_sleep(u64 ms) {
   #endif
 }
 
+typedef struct thread_start_params {
+    PFN_thread_start start_function;
+    void* params;
+} thread_start_params;
+
+static void* thread_entry(void* data) {
+    thread_start_params start = *(thread_start_params*)data;
+    platform_free(data, false);
+    u32 result = start.start_function(start.params);
+    memory_release_thread_cache();
+    return (void*)(u64)result;
+}
+
+b8 thread_create(
+    PFN_thread_start start_function, void* params, thread* out_thread
+) {
+    if (!start_function || !out_thread) {
+        OKO_ERROR("thread_create - requires a start function and out_thread.");
+        return false;
+    }
+
+    thread_start_params* start =
+        platform_allocate(sizeof(thread_start_params), false);
+    pthread_t* handle = platform_allocate(sizeof(pthread_t), false);
+    if (!start || !handle) {
+        OKO_ERROR("thread_create - failed to allocate the thread handle.");
+        platform_free(start, false);
+        platform_free(handle, false);
+        return false;
+    }
+    start->start_function = start_function;
+    start->params = params;
+
+    i32 result = pthread_create(handle, 0, thread_entry, start);
+    if (result != 0) {
+        OKO_ERROR("thread_create - pthread_create failed with %i.", result);
+        platform_free(start, false);
+        platform_free(handle, false);
+        return false;
+    }
+    out_thread->internal_data = handle;
+    out_thread->thread_id = (u64)*handle;
+    return true;
+}
+
+void thread_wait(thread* handle) {
+    if (!handle || !handle->internal_data) {
+        return;
+    }
+    pthread_join(*(pthread_t*)handle->internal_data, 0);
+    platform_free(handle->internal_data, false);
+    handle->internal_data = 0;
+    handle->thread_id = 0;
+}
+
+u64 thread_get_current_id() {
+    return (u64)pthread_self();
+}
+
+void thread_yield() {
+    sched_yield();
+}
+
+static pthread_t get_pthread(thread* handle) {
+    return handle ? *(pthread_t*)handle->internal_data : pthread_self();
+}
+
+b8 thread_set_name(thread* handle, const char* name) {
+    // The kernel takes 16 bytes, terminator included.
+    char truncated[16];
+    strncpy(truncated, name, sizeof(truncated) - 1);
+    truncated[sizeof(truncated) - 1] = 0;
+    return pthread_setname_np(get_pthread(handle), truncated) == 0;
+}
+
+b8 thread_set_affinity(thread* handle, u64 processor_mask) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (u32 i = 0; i < 64 && i < CPU_SETSIZE; ++i) {
+        if (processor_mask & (1ULL << i)) {
+            CPU_SET(i, &set);
+        }
+    }
+    i32 result = pthread_setaffinity_np(get_pthread(handle), sizeof(set), &set);
+    if (result != 0) {
+        OKO_WARN("thread_set_affinity - failed with %i.", result);
+        return false;
+    }
+    return true;
+}
+
+b8 mutex_create(mutex* out_mutex) {
+    pthread_mutex_t* handle = platform_allocate(sizeof(pthread_mutex_t), false);
+    if (!handle) {
+        OKO_ERROR("mutex_create - failed to allocate the mutex.");
+        return false;
+    }
+    if (pthread_mutex_init(handle, 0) != 0) {
+        OKO_ERROR("mutex_create - pthread_mutex_init failed.");
+        platform_free(handle, false);
+        return false;
+    }
+    out_mutex->internal_data = handle;
+    return true;
+}
+
+void mutex_destroy(mutex* mutex) {
+    if (mutex && mutex->internal_data) {
+        pthread_mutex_destroy(mutex->internal_data);
+        platform_free(mutex->internal_data, false);
+        mutex->internal_data = 0;
+    }
+}
+
+void mutex_lock(mutex* mutex) {
+    pthread_mutex_lock(mutex->internal_data);
+}
+
+b8 mutex_try_lock(mutex* mutex) {
+    return pthread_mutex_trylock(mutex->internal_data) == 0;
+}
+
+void mutex_unlock(mutex* mutex) {
+    pthread_mutex_unlock(mutex->internal_data);
+}
+
+b8 condition_variable_create(condition_variable* out_condition) {
+    pthread_cond_t* handle = platform_allocate(sizeof(pthread_cond_t), false);
+    if (!handle) {
+        OKO_ERROR(
+            "condition_variable_create - failed to allocate the condition "
+            "variable."
+        );
+        return false;
+    }
+    if (pthread_cond_init(handle, 0) != 0) {
+        OKO_ERROR("condition_variable_create - pthread_cond_init failed.");
+        platform_free(handle, false);
+        return false;
+    }
+    out_condition->internal_data = handle;
+    return true;
+}
+
+void condition_variable_destroy(condition_variable* condition) {
+    if (condition && condition->internal_data) {
+        pthread_cond_destroy(condition->internal_data);
+        platform_free(condition->internal_data, false);
+        condition->internal_data = 0;
+    }
+}
+
+void condition_variable_wait(condition_variable* condition, mutex* mutex) {
+    pthread_cond_wait(condition->internal_data, mutex->internal_data);
+}
+
+void condition_variable_signal(condition_variable* condition) {
+    pthread_cond_signal(condition->internal_data);
+}
+
+void condition_variable_broadcast(condition_variable* condition) {
+    pthread_cond_broadcast(condition->internal_data);
+}
+
+b8 semaphore_create(u32 initial_count, semaphore* out_semaphore) {
+    sem_t* handle = platform_allocate(sizeof(sem_t), false);
+    if (!handle) {
+        OKO_ERROR("semaphore_create - failed to allocate the semaphore.");
+        return false;
+    }
+    if (sem_init(handle, 0, initial_count) != 0) {
+        OKO_ERROR("semaphore_create - sem_init failed.");
+        platform_free(handle, false);
+        return false;
+    }
+    out_semaphore->internal_data = handle;
+    return true;
+}
+
+void semaphore_destroy(semaphore* semaphore) {
+    if (semaphore && semaphore->internal_data) {
+        sem_destroy(semaphore->internal_data);
+        platform_free(semaphore->internal_data, false);
+        semaphore->internal_data = 0;
+    }
+}
+
+void semaphore_signal(semaphore* semaphore, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        sem_post(semaphore->internal_data);
+    }
+}
+
+void semaphore_wait(semaphore* semaphore) {
+    while (sem_wait(semaphore->internal_data) != 0) {
+        // Retry only when a signal handler interrupts the wait.
+        if (errno != EINTR) {
+            OKO_ERROR("semaphore_wait - sem_wait failed with %i.", errno);
+            return;
+        }
+    }
+}
+
+b8 thread_local_create(thread_local_key* out_key) {
+    pthread_key_t key;
+    if (pthread_key_create(&key, 0) != 0) {
+        OKO_ERROR("thread_local_create - pthread_key_create failed.");
+        return false;
+    }
+    out_key->internal_data = key;
+    return true;
+}
+
+void thread_local_destroy(thread_local_key* key) {
+    pthread_key_delete((pthread_key_t)key->internal_data);
+}
+
+b8 thread_local_set(thread_local_key* key, void* value) {
+    return pthread_setspecific((pthread_key_t)key->internal_data, value) == 0;
+}
+
+void* thread_local_get(thread_local_key* key) {
+    return pthread_getspecific((pthread_key_t)key->internal_data);
+}
+
+// makecontext only passes int arguments, so pointers arrive in halves.
+static void fiber_entry(
+    u32 start_high, u32 start_low, u32 params_high, u32 params_low
+) {
+    PFN_fiber_start start =
+        (PFN_fiber_start)(((u64)start_high << 32) | start_low);
+    start((void*)(((u64)params_high << 32) | params_low));
+}
+
+b8 fiber_context_create(
+    PFN_fiber_start start_function,
+    void* params,
+    void* stack,
+    u64 stack_size,
+    fiber_context* out_context
+) {
+    if (!start_function || !stack || !out_context) {
+        OKO_ERROR(
+            "fiber_context_create - requires a start function, stack and out_context."
+        );
+        return false;
+    }
+
+    ucontext_t* context = platform_allocate(sizeof(ucontext_t), false);
+    if (!context) {
+        OKO_ERROR("fiber_context_create - failed to allocate the context.");
+        return false;
+    }
+    if (getcontext(context) != 0) {
+        OKO_ERROR("fiber_context_create - getcontext failed.");
+        platform_free(context, false);
+        return false;
+    }
+    context->uc_stack.ss_sp = stack;
+    context->uc_stack.ss_size = stack_size;
+    context->uc_link = 0;
+    u64 start = (u64)start_function;
+    u64 data = (u64)params;
+    makecontext(
+        context,
+        (void (*)())fiber_entry,
+        4,
+        (u32)(start >> 32),
+        (u32)start,
+        (u32)(data >> 32),
+        (u32)data
+    );
+    out_context->internal_data = context;
+    return true;
+}
+
+b8 fiber_context_create_from_thread(fiber_context* out_context) {
+    // Filled in by the first switch away.
+    out_context->internal_data = platform_allocate(sizeof(ucontext_t), false);
+    if (!out_context->internal_data) {
+        OKO_ERROR(
+            "fiber_context_create_from_thread - failed to allocate the context."
+        );
+        return false;
+    }
+    return true;
+}
+
+void fiber_context_destroy(fiber_context* context) {
+    if (context && context->internal_data) {
+        platform_free(context->internal_data, false);
+        context->internal_data = 0;
+    }
+}
+
+void fiber_context_switch(fiber_context* from, fiber_context* to) {
+    swapcontext(from->internal_data, to->internal_data);
+}
+
+u32 platform_get_processor_count() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (u32)count : 1;
+}
+
 void platform_push_vulkan_required_extension_names(const char*** names_darray) {
     darray_push(*names_darray, &"VK_KHR_xcb_surface");
 }
@@ -6,12 +6,16 @@
   #include "core/log.h"
   #include "core/input.h"
   #include "core/event.h"
+  #include "core/memory.h"
+  #include "platform/thread.h"
+  #include "platform/fiber.h"
 
   #include "containers/darray.h"
 
   #include <windows.h>
   #include <windowsx.h>  // param input extraction
   #include <stdlib.h>
+  #include <malloc.h>  // _aligned_malloc
 
 // For vk surface creation
   #include <vulkan/vulkan.h>
@@ -175,11 +179,63 @@ b8 platform_pump_messages() {
 }
 
 void *platform_allocate(u64 size, b8 aligned) {
+    if (aligned) {
+        return platform_allocate_aligned(size, OKO_CACHE_LINE_SIZE);
+    }
     return malloc(size);
 }
 
 void platform_free(void *block, b8 aligned) {
-    free(block);
+    if (aligned) {
+        platform_free_aligned(block);
+    } else {
+        free(block);
+    }
+}
+
+void *platform_reallocate(void *block, u64 size) {
+    return realloc(block, size);
+}
+
+void *platform_allocate_aligned(u64 size, u64 alignment) {
+    return _aligned_malloc(size, alignment);
+}
+
+void platform_free_aligned(void *block) {
+    _aligned_free(block);
+}
+
+u64 platform_get_page_size() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+}
+
+void *platform_reserve_memory(u64 size) {
+    return VirtualAlloc(0, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+b8 platform_commit_memory(void *address, u64 size) {
+    return VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != 0;
+}
+
+void platform_decommit_memory(void *address, u64 size) {
+    VirtualFree(address, size, MEM_DECOMMIT);
+}
+
+void platform_release_memory(void *address, u64 size) {
+    VirtualFree(address, 0, MEM_RELEASE);
+}
+
+u64 platform_get_huge_page_size() {
+    u64 size = GetLargePageMinimum();
+    return size ? size : 2 * 1024 * 1024;
+}
+
+void *platform_reserve_huge_memory(u64 size, b8 *out_huge_pages) {
+    // Always a regular reservation, see platform.h.
+    *out_huge_pages = false;
+    return platform_reserve_memory(size);
 }
 
 void *platform_zero_memory(void *block, u64 size) {
@@ -190,6 +246,10 @@ void *platform_copy_memory(void *dest, const void *source, u64 size) {
     return memcpy(dest, source, size);
 }
 
+void *platform_move_memory(void *dest, const void *source, u64 size) {
+    return memmove(dest, source, size);
+}
+
 void *platform_set_memory(void *dest, i32 value, u64 size) {
     return memset(dest, value, size);
 }
@@ -242,6 +302,306 @@ void platform_sleep(u64 ms) {
     Sleep(ms);
 }
 
+typedef struct thread_start_params {
+    PFN_thread_start start_function;
+    void *params;
+} thread_start_params;
+
+static DWORD WINAPI thread_entry(LPVOID data) {
+    thread_start_params start = *(thread_start_params *)data;
+    platform_free(data, false);
+    u32 result = start.start_function(start.params);
+    memory_release_thread_cache();
+    return result;
+}
+
+b8 thread_create(
+    PFN_thread_start start_function, void *params, thread *out_thread
+) {
+    if (!start_function || !out_thread) {
+        OKO_ERROR("thread_create - requires a start function and out_thread.");
+        return false;
+    }
+
+    thread_start_params *start =
+        platform_allocate(sizeof(thread_start_params), false);
+    if (!start) {
+        OKO_ERROR("thread_create - failed to allocate the start parameters.");
+        return false;
+    }
+    start->start_function = start_function;
+    start->params = params;
+
+    DWORD thread_id = 0;
+    HANDLE handle = CreateThread(0, 0, thread_entry, start, 0, &thread_id);
+    if (!handle) {
+        OKO_ERROR(
+            "thread_create - CreateThread failed with %lu.", GetLastError()
+        );
+        platform_free(start, false);
+        return false;
+    }
+    out_thread->internal_data = handle;
+    out_thread->thread_id = thread_id;
+    return true;
+}
+
+void thread_wait(thread *handle) {
+    if (!handle || !handle->internal_data) {
+        return;
+    }
+    WaitForSingleObject(handle->internal_data, INFINITE);
+    CloseHandle(handle->internal_data);
+    handle->internal_data = 0;
+    handle->thread_id = 0;
+}
+
+u64 thread_get_current_id() {
+    return GetCurrentThreadId();
+}
+
+void thread_yield() {
+    SwitchToThread();
+}
+
+static HANDLE get_thread_handle(thread *handle) {
+    return handle ? handle->internal_data : GetCurrentThread();
+}
+
+b8 thread_set_name(thread *handle, const char *name) {
+    wchar_t wide_name[64];
+    if (!MultiByteToWideChar(CP_UTF8, 0, name, -1, wide_name, 64)) {
+        return false;
+    }
+    HRESULT result = SetThreadDescription(get_thread_handle(handle), wide_name);
+    return SUCCEEDED(result);
+}
+
+b8 thread_set_affinity(thread *handle, u64 processor_mask) {
+    if (!SetThreadAffinityMask(
+            get_thread_handle(handle), (DWORD_PTR)processor_mask
+        )) {
+        OKO_WARN("thread_set_affinity - failed with %lu.", GetLastError());
+        return false;
+    }
+    return true;
+}
+
+b8 mutex_create(mutex *out_mutex) {
+    SRWLOCK *lock = platform_allocate(sizeof(SRWLOCK), false);
+    if (!lock) {
+        OKO_ERROR("mutex_create - failed to allocate the mutex.");
+        return false;
+    }
+    InitializeSRWLock(lock);
+    out_mutex->internal_data = lock;
+    return true;
+}
+
+void mutex_destroy(mutex *mutex) {
+    if (mutex && mutex->internal_data) {
+        platform_free(mutex->internal_data, false);
+        mutex->internal_data = 0;
+    }
+}
+
+void mutex_lock(mutex *mutex) {
+    AcquireSRWLockExclusive(mutex->internal_data);
+}
+
+b8 mutex_try_lock(mutex *mutex) {
+    return TryAcquireSRWLockExclusive(mutex->internal_data) != 0;
+}
+
+void mutex_unlock(mutex *mutex) {
+    ReleaseSRWLockExclusive(mutex->internal_data);
+}
+
+b8 condition_variable_create(condition_variable *out_condition) {
+    CONDITION_VARIABLE *handle =
+        platform_allocate(sizeof(CONDITION_VARIABLE), false);
+    if (!handle) {
+        OKO_ERROR(
+            "condition_variable_create - failed to allocate the condition "
+            "variable."
+        );
+        return false;
+    }
+    InitializeConditionVariable(handle);
+    out_condition->internal_data = handle;
+    return true;
+}
+
+void condition_variable_destroy(condition_variable *condition) {
+    if (condition && condition->internal_data) {
+        platform_free(condition->internal_data, false);
+        condition->internal_data = 0;
+    }
+}
+
+void condition_variable_wait(condition_variable *condition, mutex *mutex) {
+    SleepConditionVariableSRW(
+        condition->internal_data, mutex->internal_data, INFINITE, 0
+    );
+}
+
+void condition_variable_signal(condition_variable *condition) {
+    WakeConditionVariable(condition->internal_data);
+}
+
+void condition_variable_broadcast(condition_variable *condition) {
+    WakeAllConditionVariable(condition->internal_data);
+}
+
+b8 semaphore_create(u32 initial_count, semaphore *out_semaphore) {
+    HANDLE handle = CreateSemaphoreA(0, initial_count, 0x7FFFFFFF, 0);
+    if (!handle) {
+        OKO_ERROR(
+            "semaphore_create - CreateSemaphore failed with %lu.",
+            GetLastError()
+        );
+        return false;
+    }
+    out_semaphore->internal_data = handle;
+    return true;
+}
+
+void semaphore_destroy(semaphore *semaphore) {
+    if (semaphore && semaphore->internal_data) {
+        CloseHandle(semaphore->internal_data);
+        semaphore->internal_data = 0;
+    }
+}
+
+void semaphore_signal(semaphore *semaphore, u32 count) {
+    if (count) {
+        ReleaseSemaphore(semaphore->internal_data, count, 0);
+    }
+}
+
+void semaphore_wait(semaphore *semaphore) {
+    WaitForSingleObject(semaphore->internal_data, INFINITE);
+}
+
+b8 thread_local_create(thread_local_key *out_key) {
+    DWORD index = TlsAlloc();
+    if (index == TLS_OUT_OF_INDEXES) {
+        OKO_ERROR("thread_local_create - TlsAlloc failed.");
+        return false;
+    }
+    out_key->internal_data = index;
+    return true;
+}
+
+void thread_local_destroy(thread_local_key *key) {
+    TlsFree((DWORD)key->internal_data);
+}
+
+b8 thread_local_set(thread_local_key *key, void *value) {
+    return TlsSetValue((DWORD)key->internal_data, value) != 0;
+}
+
+void *thread_local_get(thread_local_key *key) {
+    return TlsGetValue((DWORD)key->internal_data);
+}
+
+typedef struct win32_fiber {
+    LPVOID fiber;
+    PFN_fiber_start start_function;
+    void *params;
+    // Converted from a thread rather than created.
+    b8 is_thread;
+} win32_fiber;
+
+static VOID CALLBACK fiber_entry(LPVOID data) {
+    win32_fiber *context = data;
+    context->start_function(context->params);
+}
+
+b8 fiber_context_create(
+    PFN_fiber_start start_function,
+    void *params,
+    void *stack,
+    u64 stack_size,
+    fiber_context *out_context
+) {
+    if (!start_function || !out_context) {
+        OKO_ERROR(
+            "fiber_context_create - requires a start function and out_context."
+        );
+        return false;
+    }
+
+    win32_fiber *context = platform_allocate(sizeof(win32_fiber), false);
+    if (!context) {
+        OKO_ERROR("fiber_context_create - failed to allocate the context.");
+        return false;
+    }
+    context->start_function = start_function;
+    context->params = params;
+    context->is_thread = false;
+    context->fiber = CreateFiberEx(
+        stack_size, stack_size, FIBER_FLAG_FLOAT_SWITCH, fiber_entry, context
+    );
+    if (!context->fiber) {
+        OKO_ERROR(
+            "fiber_context_create - CreateFiberEx failed with %lu.",
+            GetLastError()
+        );
+        platform_free(context, false);
+        return false;
+    }
+    out_context->internal_data = context;
+    return true;
+}
+
+b8 fiber_context_create_from_thread(fiber_context *out_context) {
+    win32_fiber *context = platform_allocate(sizeof(win32_fiber), false);
+    if (!context) {
+        OKO_ERROR(
+            "fiber_context_create_from_thread - failed to allocate the context."
+        );
+        return false;
+    }
+    context->start_function = 0;
+    context->params = 0;
+    context->is_thread = true;
+    context->fiber = ConvertThreadToFiberEx(0, FIBER_FLAG_FLOAT_SWITCH);
+    if (!context->fiber) {
+        OKO_ERROR(
+            "fiber_context_create_from_thread - ConvertThreadToFiberEx failed with %lu.",
+            GetLastError()
+        );
+        platform_free(context, false);
+        return false;
+    }
+    out_context->internal_data = context;
+    return true;
+}
+
+void fiber_context_destroy(fiber_context *context) {
+    if (context && context->internal_data) {
+        win32_fiber *fiber = context->internal_data;
+        if (fiber->is_thread) {
+            ConvertFiberToThread();
+        } else {
+            DeleteFiber(fiber->fiber);
+        }
+        platform_free(fiber, false);
+        context->internal_data = 0;
+    }
+}
+
+void fiber_context_switch(fiber_context *from, fiber_context *to) {
+    SwitchToFiber(((win32_fiber *)to->internal_data)->fiber);
+}
+
+u32 platform_get_processor_count() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors ? info.dwNumberOfProcessors : 1;
+}
+
 void platform_push_vulkan_required_extension_names(const char ***names_darray) {
     darray_push(*names_darray, &"VK_KHR_win32_surface");
 }
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "defines.h"
+
+// The return value becomes the thread's exit code.
+typedef u32 (*PFN_thread_start)(void* params);
+
+typedef struct thread {
+    // opaque handle to internal thread
+    void* internal_data;
+    u64 thread_id;
+} thread;
+
+// Runs start_function(params) on a new thread. Once it returns, the thread
+// hands its memory system cache back before exiting.
+OKO_API b8 thread_create(
+    PFN_thread_start start_function, void* params, thread* out_thread
+);
+
+// Blocks until the thread has exited, then releases its handle.
+OKO_API void thread_wait(thread* handle);
+
+OKO_API u64 thread_get_current_id();
+
+// Gives the rest of the time slice to another ready thread, for spin loops
+// waiting on other threads.
+OKO_API void thread_yield();
+
+// Shows up in debuggers and profilers. Linux keeps the first 15 characters.
+// A handle of 0 means the calling thread.
+OKO_API b8 thread_set_name(thread* handle, const char* name);
+
+// Keeps the thread on the processors whose bits are set in processor_mask,
+// see platform_get_processor_count. A handle of 0 means the calling thread.
+OKO_API b8 thread_set_affinity(thread* handle, u64 processor_mask);
+
+// Not recursive: a thread must not lock a mutex it already holds.
+typedef struct mutex {
+    // opaque handle to internal mutex
+    void* internal_data;
+} mutex;
+
+OKO_API b8 mutex_create(mutex* out_mutex);
+
+OKO_API void mutex_destroy(mutex* mutex);
+
+OKO_API void mutex_lock(mutex* mutex);
+
+// Returns false instead of blocking when another thread holds the mutex.
+OKO_API b8 mutex_try_lock(mutex* mutex);
+
+OKO_API void mutex_unlock(mutex* mutex);
+
+typedef struct condition_variable {
+    // opaque handle to internal condition variable
+    void* internal_data;
+} condition_variable;
+
+OKO_API b8 condition_variable_create(condition_variable* out_condition);
+
+OKO_API void condition_variable_destroy(condition_variable* condition);
+
+// Releases mutex, which the caller holds, sleeps until woken and takes the
+// mutex again before returning. Wakeups can be spurious, so wait in a loop
+// that checks the actual condition.
+OKO_API void condition_variable_wait(
+    condition_variable* condition, mutex* mutex
+);
+
+// Wakes one waiting thread.
+OKO_API void condition_variable_signal(condition_variable* condition);
+
+// Wakes every waiting thread.
+OKO_API void condition_variable_broadcast(condition_variable* condition);
+
+// Counting semaphore, for threads that sleep until there is work.
+typedef struct semaphore {
+    // opaque handle to internal semaphore
+    void* internal_data;
+} semaphore;
+
+OKO_API b8 semaphore_create(u32 initial_count, semaphore* out_semaphore);
+
+OKO_API void semaphore_destroy(semaphore* semaphore);
+
+// Raises the count, waking up to count waiting threads.
+OKO_API void semaphore_signal(semaphore* semaphore, u32 count);
+
+// Blocks until the count is above 0, then lowers it.
+OKO_API void semaphore_wait(semaphore* semaphore);
+
+// A pointer with a separate value per thread, for keys created at runtime
+// such as one per object. Fixed per-thread globals are simpler as
+// OKO_THREAD_LOCAL. Every thread starts out with 0.
+typedef struct thread_local_key {
+    // opaque handle to internal key
+    u64 internal_data;
+} thread_local_key;
+
+OKO_API b8 thread_local_create(thread_local_key* out_key);
+
+OKO_API void thread_local_destroy(thread_local_key* key);
+
+OKO_API b8 thread_local_set(thread_local_key* key, void* value);
+
+OKO_API void* thread_local_get(thread_local_key* key);
\ No newline at end of file
@@ -248,6 +248,13 @@ b8 vulkan_material_shader_create(
         return false;
     }
 
+    if (!slot_map_create(
+            0, MATERIAL_SHADER_MAX_OBJECT_COUNT, 0, &out_shader->object_ids
+        )) {
+        OKO_ERROR("Object id slot map creation failed for shader.");
+        return false;
+    }
+
     return true;
 }
 
@@ -266,6 +273,7 @@ void vulkan_material_shader_destroy(
     // Destroy uniform buffers.
     vulkan_buffer_destroy(context, &shader->global_uniform_buffer);
     vulkan_buffer_destroy(context, &shader->object_uniform_buffer);
+    slot_map_destroy(&shader->object_ids);
 
     // Destroy pipeline.
     vulkan_pipeline_destroy(context, &shader->pipeline);
@@ -376,8 +384,9 @@ void vulkan_material_shader_update_object(
     );
 
     // Obtain material data.
+    u32 object_index = slot_handle_index(data.object_id);
     vulkan_material_shader_object_state* object_state =
-        &shader->object_states[data.object_id];
+        &shader->object_states[object_index];
     VkDescriptorSet object_descriptor_set =
         object_state->descriptor_sets[image_index];
 
@@ -393,7 +402,7 @@ void vulkan_material_shader_update_object(
     // Descriptor 0 - Uniform buffer
     u32 range = sizeof(object_uniform_object);
     u64 offset = sizeof(object_uniform_object) *
-                 data.object_id;  // also the index into the array.
+                 object_index;  // also the index into the array.
     object_uniform_object obo;
 
     // TODO: get diffuse colour from a material.
@@ -515,13 +524,18 @@ void vulkan_material_shader_update_object(
 b8 vulkan_material_shader_acquire_resources(
     vulkan_context* context, vulkan_material_shader* shader, u32* out_object_id
 ) {
-    // TODO: free list
-    *out_object_id = shader->object_uniform_buffer_index;
-    shader->object_uniform_buffer_index++;
+    slot_handle object_id = slot_map_insert(&shader->object_ids, 0);
+    if (object_id == INVALID_ID) {
+        OKO_ERROR(
+            "vulkan_material_shader_acquire_resources - all %u object ids are in use.",
+            MATERIAL_SHADER_MAX_OBJECT_COUNT
+        );
+        return false;
+    }
+    *out_object_id = object_id;
 
-    u32 object_id = *out_object_id;
     vulkan_material_shader_object_state* object_state =
-        &shader->object_states[object_id];
+        &shader->object_states[slot_handle_index(object_id)];
     for (u32 i = 0; i < MATERIAL_SHADER_DESCRIPTOR_COUNT; ++i) {
         for (u32 j = 0; j < 3; ++j) {
             object_state->descriptor_states[i].generations[j] = INVALID_ID;
@@ -547,6 +561,7 @@ b8 vulkan_material_shader_acquire_resources(
     );
     if (result != VK_SUCCESS) {
         OKO_ERROR("Error allocating descriptor sets in shader!");
+        slot_map_remove(&shader->object_ids, object_id);
         return false;
     }
 
@@ -556,8 +571,15 @@ b8 vulkan_material_shader_acquire_resources(
 void vulkan_material_shader_release_resources(
     vulkan_context* context, vulkan_material_shader* shader, u32 object_id
 ) {
+    if (!slot_map_is_valid(&shader->object_ids, object_id)) {
+        OKO_WARN(
+            "vulkan_material_shader_release_resources - object id %u is stale or invalid.",
+            object_id
+        );
+        return;
+    }
     vulkan_material_shader_object_state* object_state =
-        &shader->object_states[object_id];
+        &shader->object_states[slot_handle_index(object_id)];
 
     const u32 descriptor_set_count = 3;
     // Release object descriptor sets.
@@ -578,5 +600,5 @@ void vulkan_material_shader_release_resources(
         }
     }
 
-    // TODO: add the object_id to the free list
+    slot_map_remove(&shader->object_ids, object_id);
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "core/assert.h"
 
 #include "renderer/renderer_types.h"
+#include "containers/slot_map.h"
 
 #include <vulkan/vulkan.h>
 
@@ -153,8 +154,9 @@ typedef struct vulkan_material_shader {
     VkDescriptorSetLayout object_descriptor_set_layout;
     // object uniform buffers
     vulkan_buffer object_uniform_buffer;
-    // TODO: manage a free list of some kind here instead
-    u32 object_uniform_buffer_index;
+    // Hands out object ids. The slot index of an id picks its entry in
+    // object_states and its range of the object uniform buffer.
+    slot_map object_ids;
 
     // TODO: make dynamic
     vulkan_material_shader_object_state
@@ -0,0 +1,805 @@
+#include "job_system.h"
+
+#include "core/memory.h"
+#include "core/log.h"
+#include "containers/ring_queue.h"
+#include "containers/string.h"
+#include "platform/platform.h"
+#include "platform/thread.h"
+#include "platform/fiber.h"
+
+// Rounds of looking for work, yielding in between, before an idle worker
+// goes to sleep.
+#define IDLE_SPIN_COUNT 64
+
+// Room for a few nested calls that log, which takes about 64 KiB.
+#define DEFAULT_FIBER_STACK_SIZE (256 * 1024)
+
+typedef struct job {
+    // 0 for a parked fiber held back on a counter, its 1-based index in
+    // params.
+    PFN_job_entry entry;
+    void* params;
+    job_counter* counter;
+    job_priority priority;
+    // 1-based index of the next job held back on the same counter.
+    u32 next;
+} job;
+
+// Chase-Lev deque of job indices. The owner pushes and pops at bottom,
+// thieves take from top. Every deque can hold max_jobs entries, all the jobs
+// there can be, so it never fills up.
+typedef struct job_deque {
+    OKO_CACHE_ALIGNED atomic_i64 top;
+    OKO_CACHE_ALIGNED atomic_i64 bottom;
+    atomic_u32* items;
+} job_deque;
+
+typedef struct job_worker {
+    job_deque deques[JOB_PRIORITY_COUNT];
+    thread thread;
+} job_worker;
+
+typedef struct job_system_state {
+    // Including the initializing thread, which is worker 0.
+    u32 thread_count;
+    u32 job_mask;
+    job* jobs;
+    // Indices of unused jobs.
+    ring_queue free_jobs;
+    // Jobs from threads without a deque, per priority.
+    ring_queue injected[JOB_PRIORITY_COUNT];
+    job_worker* workers;
+    atomic_u32* deque_items;
+    semaphore wake;
+    atomic_i32 sleeping;
+    atomic_b8 running;
+
+    u32 fiber_count;
+    u64 fiber_stack_size;
+    fiber_context* fibers;
+    // Reserved range of one slot per fiber: an uncommitted guard page below
+    // a committed stack, so an overflow faults instead of running into the
+    // next fiber's stack.
+    u8* fiber_stacks;
+    u32 committed_stack_count;
+    // 1-based indices of fibers not in use, and of parked fibers whose
+    // counter reached 0.
+    ring_queue free_fibers;
+    ring_queue ready_fibers;
+    // Fibers parked or ready, which keep workers from stopping.
+    atomic_i32 parked;
+} job_system_state;
+
+typedef struct job_thread_state {
+    // 1-based worker of the thread, 0 for threads without a deque.
+    u32 worker;
+    u32 random;
+    // 1-based fiber running on the thread, 0 on the thread's own stack.
+    u32 fiber;
+    // Left by a fiber for the one it switches to, as it cannot do either
+    // while still on its own stack: hand release_fiber back to the pool,
+    // and park park_fiber until park_counter reaches 0.
+    u32 release_fiber;
+    u32 park_fiber;
+    job_counter* park_counter;
+    // The worker thread's own stack, to return to when it stops.
+    fiber_context* thread_context;
+} job_thread_state;
+
+static job_system_state* state_ptr = 0;
+
+static OKO_THREAD_LOCAL job_thread_state thread_state;
+
+// A fiber may resume on another thread, and compilers are free to keep the
+// address of a thread-local across the switch, so it is only ever read
+// through here. MSVC builds need /GT for the same reason.
+static OKO_NOINLINE job_thread_state* get_thread_state() {
+    job_thread_state* local = &thread_state;
+#ifndef _MSC_VER
+    // Keeps the call from being treated as pure and merged.
+    __asm__ volatile("" : "+r"(local));
+#endif
+    return local;
+}
+
+static void deque_push(job_deque* deque, u32 mask, u32 index) {
+    i64 bottom = atomic_i64_load(&deque->bottom, ATOMIC_ORDER_RELAXED);
+    atomic_u32_store(&deque->items[bottom & mask], index, ATOMIC_ORDER_RELAXED);
+    // Publishes the entry and the job behind it to thieves.
+    atomic_i64_store(&deque->bottom, bottom + 1, ATOMIC_ORDER_RELEASE);
+}
+
+static u32 deque_pop(job_deque* deque, u32 mask) {
+    i64 bottom = atomic_i64_load(&deque->bottom, ATOMIC_ORDER_RELAXED) - 1;
+    // Claim the bottom entry before looking at top, so a thief either sees
+    // the claim or the owner sees the thief's.
+    atomic_i64_store(&deque->bottom, bottom, ATOMIC_ORDER_SEQ_CST);
+    i64 top = atomic_i64_load(&deque->top, ATOMIC_ORDER_SEQ_CST);
+    if (top > bottom) {
+        atomic_i64_store(&deque->bottom, bottom + 1, ATOMIC_ORDER_RELAXED);
+        return INVALID_ID;
+    }
+
+    u32 index =
+        atomic_u32_load(&deque->items[bottom & mask], ATOMIC_ORDER_RELAXED);
+    if (top == bottom) {
+        // The last entry, thieves may be after it too.
+        if (!atomic_i64_compare_exchange(
+                &deque->top, &top, top + 1, ATOMIC_ORDER_SEQ_CST
+            )) {
+            index = INVALID_ID;
+        }
+        atomic_i64_store(&deque->bottom, bottom + 1, ATOMIC_ORDER_RELAXED);
+    }
+    return index;
+}
+
+// May come back empty-handed while entries remain when another thread got
+// the top one first.
+static u32 deque_steal(job_deque* deque, u32 mask) {
+    i64 top = atomic_i64_load(&deque->top, ATOMIC_ORDER_SEQ_CST);
+    i64 bottom = atomic_i64_load(&deque->bottom, ATOMIC_ORDER_SEQ_CST);
+    if (top >= bottom) {
+        return INVALID_ID;
+    }
+
+    u32 index =
+        atomic_u32_load(&deque->items[top & mask], ATOMIC_ORDER_RELAXED);
+    if (!atomic_i64_compare_exchange(
+            &deque->top, &top, top + 1, ATOMIC_ORDER_SEQ_CST
+        )) {
+        return INVALID_ID;
+    }
+    return index;
+}
+
+static u32 next_random() {
+    job_thread_state* local = get_thread_state();
+    if (!local->random) {
+        local->random = (u32)thread_get_current_id() | 1;
+    }
+    local->random ^= local->random << 13;
+    local->random ^= local->random >> 17;
+    local->random ^= local->random << 5;
+    return local->random;
+}
+
+// Highest priority first: the own deque, then the shared queue, then the
+// other deques starting at a random one.
+static u32 find_job() {
+    u32 worker = get_thread_state()->worker;
+    u32 mask = state_ptr->job_mask;
+    u32 thread_count = state_ptr->thread_count;
+    for (u32 priority = 0; priority < JOB_PRIORITY_COUNT; ++priority) {
+        u32 index;
+        if (worker) {
+            job_worker* own = &state_ptr->workers[worker - 1];
+            index = deque_pop(&own->deques[priority], mask);
+            if (index != INVALID_ID) {
+                return index;
+            }
+        }
+
+        if (ring_queue_dequeue(&state_ptr->injected[priority], &index)) {
+            return index;
+        }
+
+        u32 start = next_random() % thread_count;
+        for (u32 i = 0; i < thread_count; ++i) {
+            u32 victim = (start + i) % thread_count;
+            if (victim + 1 == worker) {
+                continue;
+            }
+            index = deque_steal(
+                &state_ptr->workers[victim].deques[priority], mask
+            );
+            if (index != INVALID_ID) {
+                return index;
+            }
+        }
+    }
+    return INVALID_ID;
+}
+
+static void wake_workers(u32 count) {
+    // A read-modify-write, so it sees a worker that just announced it is
+    // going to sleep, or that worker sees the jobs queued before this.
+    i32 sleeping =
+        atomic_i32_fetch_add(&state_ptr->sleeping, 0, ATOMIC_ORDER_SEQ_CST);
+    if (sleeping > 0) {
+        semaphore_signal(
+            &state_ptr->wake, count < (u32)sleeping ? count : (u32)sleeping
+        );
+    }
+}
+
+static void enqueue_job(u32 index) {
+    job_priority priority = state_ptr->jobs[index].priority;
+    u32 worker = get_thread_state()->worker;
+    if (worker) {
+        job_worker* own = &state_ptr->workers[worker - 1];
+        deque_push(&own->deques[priority], state_ptr->job_mask, index);
+    } else {
+        ring_queue_enqueue(&state_ptr->injected[priority], &index);
+    }
+}
+
+// Queues the chain of held back jobs starting at 1-based head.
+static u32 enqueue_chain(u32 head) {
+    u32 count = 0;
+    while (head) {
+        u32 index = head - 1;
+        job* j = &state_ptr->jobs[index];
+        head = j->next;
+        if (j->entry) {
+            enqueue_job(index);
+        } else {
+            u32 fiber = (u32)(u64)j->params;
+            ring_queue_enqueue(&state_ptr->ready_fibers, &fiber);
+            ring_queue_enqueue(&state_ptr->free_jobs, &index);
+        }
+        count++;
+    }
+    return count;
+}
+
+static void finish_jobs(job_counter* counter, u32 count) {
+    u64 state = atomic_u64_load(&counter->state, ATOMIC_ORDER_RELAXED);
+    u64 new_state;
+    do {
+        new_state = state - count;
+        if ((u32)new_state == 0) {
+            // Last one out takes the held back jobs.
+            new_state = 0;
+        }
+    } while (!atomic_u64_compare_exchange(
+        &counter->state, &state, new_state, ATOMIC_ORDER_ACQ_REL
+    ));
+
+    u32 head = (u32)(state >> 32);
+    if (new_state == 0 && head) {
+        wake_workers(enqueue_chain(head));
+    }
+}
+
+static void run_job(u32 index) {
+    job* j = &state_ptr->jobs[index];
+    PFN_job_entry entry = j->entry;
+    void* params = j->params;
+    job_counter* counter = j->counter;
+    // Hand the slot back first, the job may submit more.
+    ring_queue_enqueue(&state_ptr->free_jobs, &index);
+
+    entry(params);
+    if (counter) {
+        finish_jobs(counter, 1);
+    }
+}
+
+static b8 run_next_job() {
+    u32 index = find_job();
+    if (index == INVALID_ID) {
+        return false;
+    }
+    run_job(index);
+    return true;
+}
+
+static u32 allocate_job(const job_desc* desc, job_counter* counter) {
+    u32 index;
+    while (!ring_queue_dequeue(&state_ptr->free_jobs, &index)) {
+        // Every job is in use, help finish some.
+        if (!run_next_job()) {
+            thread_yield();
+        }
+    }
+
+    job* j = &state_ptr->jobs[index];
+    j->entry = desc->entry;
+    j->params = desc->params;
+    j->counter = counter;
+    j->priority = desc->priority < JOB_PRIORITY_COUNT ? desc->priority
+                                                      : JOB_PRIORITY_NORMAL;
+    j->next = 0;
+    return index;
+}
+
+// Queues the chain of jobs from first to last once dependency reaches 0,
+// right away if it already has.
+static void hold_back(job_counter* dependency, u32 first, u32 last) {
+    u64 state = atomic_u64_load(&dependency->state, ATOMIC_ORDER_ACQUIRE);
+    for (;;) {
+        if ((u32)state == 0) {
+            // Nothing to wait for.
+            wake_workers(enqueue_chain(first + 1));
+            return;
+        }
+        state_ptr->jobs[last].next = (u32)(state >> 32);
+        u64 new_state = ((u64)(first + 1) << 32) | (u32)state;
+        // Acquire on failure too, the jobs may be queued right away.
+        if (atomic_u64_compare_exchange(
+                &dependency->state, &state, new_state, ATOMIC_ORDER_ACQ_REL
+            )) {
+            return;
+        }
+    }
+}
+
+// Runs on the fiber switched to, before anything else.
+static void finish_switch() {
+    job_thread_state* local = get_thread_state();
+    u32 release = local->release_fiber;
+    u32 park = local->park_fiber;
+    job_counter* counter = local->park_counter;
+    local->release_fiber = 0;
+    local->park_fiber = 0;
+    local->park_counter = 0;
+
+    if (release) {
+        ring_queue_enqueue(&state_ptr->free_fibers, &release);
+    }
+    if (park) {
+        // Held back like any job, so the fiber is ready once counter
+        // reaches 0.
+        job_desc desc = {0, (void*)(u64)park, JOB_PRIORITY_HIGH};
+        u32 index = allocate_job(&desc, 0);
+        hold_back(counter, index, index);
+    }
+}
+
+// to is 1-based, 0 for the thread's own stack. Returns once something
+// switches back to the current fiber, possibly on another thread, so local
+// must not be used afterwards.
+static void switch_fiber(job_thread_state* local, u32 to) {
+    fiber_context* from_context = local->fiber
+                                      ? &state_ptr->fibers[local->fiber - 1]
+                                      : local->thread_context;
+    fiber_context* to_context =
+        to ? &state_ptr->fibers[to - 1] : local->thread_context;
+    local->fiber = to;
+    fiber_context_switch(from_context, to_context);
+    finish_switch();
+}
+
+// Continues a fiber whose counter reached 0. The current one goes back to
+// the pool, so only the worker loop may call this.
+static b8 resume_ready_fiber() {
+    job_thread_state* local = get_thread_state();
+    u32 fiber;
+    if (!local->fiber ||
+        !ring_queue_dequeue(&state_ptr->ready_fibers, &fiber)) {
+        return false;
+    }
+    atomic_i32_fetch_sub(&state_ptr->parked, 1, ATOMIC_ORDER_RELEASE);
+    local->release_fiber = local->fiber;
+    switch_fiber(local, fiber);
+    return true;
+}
+
+// Parks the calling fiber until counter reaches 0 and carries on running
+// jobs on a free one. Fails on threads without fibers and when none is free.
+static b8 wait_on_fiber(job_counter* counter) {
+    job_thread_state* local = get_thread_state();
+    u32 fiber;
+    if (!local->fiber ||
+        !ring_queue_dequeue(&state_ptr->free_fibers, &fiber)) {
+        return false;
+    }
+    atomic_i32_fetch_add(&state_ptr->parked, 1, ATOMIC_ORDER_RELAXED);
+    local->park_fiber = local->fiber;
+    local->park_counter = counter;
+    switch_fiber(local, fiber);
+    return true;
+}
+
+// Until the system stops, nothing is queued and no fiber is parked.
+static void worker_loop() {
+    for (;;) {
+        if (resume_ready_fiber() || run_next_job()) {
+            continue;
+        }
+        // Only stop once nothing is left.
+        if (!atomic_b8_load(&state_ptr->running, ATOMIC_ORDER_ACQUIRE) &&
+            !atomic_i32_load(&state_ptr->parked, ATOMIC_ORDER_ACQUIRE)) {
+            break;
+        }
+
+        b8 found = false;
+        for (u32 i = 0; i < IDLE_SPIN_COUNT && !found; ++i) {
+            thread_yield();
+            found = resume_ready_fiber() || run_next_job();
+        }
+        if (found) {
+            continue;
+        }
+
+        // Announce the sleep, then look once more: a submitter either sees
+        // the announcement or its jobs are visible here.
+        atomic_i32_fetch_add(&state_ptr->sleeping, 1, ATOMIC_ORDER_SEQ_CST);
+        u32 index = find_job();
+        if (index == INVALID_ID &&
+            !ring_queue_count(&state_ptr->ready_fibers) &&
+            atomic_b8_load(&state_ptr->running, ATOMIC_ORDER_ACQUIRE)) {
+            semaphore_wait(&state_ptr->wake);
+        }
+        atomic_i32_fetch_sub(&state_ptr->sleeping, 1, ATOMIC_ORDER_SEQ_CST);
+        if (index != INVALID_ID) {
+            run_job(index);
+        }
+    }
+}
+
+static void fiber_main(void* params) {
+    // Later switches to this fiber return inside switch_fiber instead.
+    finish_switch();
+    for (;;) {
+        worker_loop();
+        job_thread_state* local = get_thread_state();
+        local->release_fiber = local->fiber;
+        switch_fiber(local, 0);
+    }
+}
+
+static u32 worker_run(void* params) {
+    job_thread_state* local = get_thread_state();
+    local->worker = (u32)(u64)params;
+    if (!state_ptr->fiber_count) {
+        worker_loop();
+        return 0;
+    }
+
+    fiber_context thread_context;
+    if (!fiber_context_create_from_thread(&thread_context)) {
+        worker_loop();
+        return 0;
+    }
+    local->thread_context = &thread_context;
+    // Each worker thread has a fiber set aside to start on.
+    switch_fiber(local, local->worker - 1);
+    fiber_context_destroy(&thread_context);
+    local->thread_context = 0;
+    return 0;
+}
+
+static u64 get_items_size(u32 thread_count, u32 capacity) {
+    return (u64)thread_count * JOB_PRIORITY_COUNT * capacity *
+           sizeof(atomic_u32);
+}
+
+// Stops and joins the worker threads started so far.
+static void stop_workers() {
+    atomic_b8_store(&state_ptr->running, false, ATOMIC_ORDER_RELEASE);
+    if (!state_ptr->workers) {
+        return;
+    }
+    if (state_ptr->wake.internal_data) {
+        semaphore_signal(&state_ptr->wake, state_ptr->thread_count);
+    }
+    for (u32 i = 1; i < state_ptr->thread_count; ++i) {
+        thread_wait(&state_ptr->workers[i].thread);
+    }
+}
+
+static u64 get_fiber_slot_size() {
+    return memory_get_page_size() + state_ptr->fiber_stack_size;
+}
+
+static u8* get_fiber_stack(u32 index) {
+    return state_ptr->fiber_stacks + index * get_fiber_slot_size() +
+           memory_get_page_size();
+}
+
+// Frees whatever was created so far, also after a failed initialize.
+static void release_state() {
+    get_thread_state()->worker = 0;
+
+    if (state_ptr->fibers) {
+        for (u32 i = 0; i < state_ptr->fiber_count; ++i) {
+            fiber_context_destroy(&state_ptr->fibers[i]);
+        }
+        memory_free(
+            state_ptr->fibers,
+            sizeof(fiber_context) * state_ptr->fiber_count,
+            MEMORY_TAG_JOB
+        );
+    }
+    if (state_ptr->fiber_stacks) {
+        for (u32 i = 0; i < state_ptr->committed_stack_count; ++i) {
+            memory_decommit(get_fiber_stack(i), state_ptr->fiber_stack_size);
+        }
+        memory_release(
+            state_ptr->fiber_stacks,
+            get_fiber_slot_size() * state_ptr->fiber_count
+        );
+    }
+    ring_queue_destroy(&state_ptr->ready_fibers);
+    ring_queue_destroy(&state_ptr->free_fibers);
+
+    u32 capacity = state_ptr->job_mask + 1;
+    semaphore_destroy(&state_ptr->wake);
+    if (state_ptr->deque_items) {
+        memory_free(
+            state_ptr->deque_items,
+            get_items_size(state_ptr->thread_count, capacity),
+            MEMORY_TAG_JOB
+        );
+    }
+    if (state_ptr->workers) {
+        memory_free_aligned(
+            state_ptr->workers,
+            sizeof(job_worker) * state_ptr->thread_count,
+            OKO_CACHE_LINE_SIZE,
+            MEMORY_TAG_JOB
+        );
+    }
+    for (u32 i = 0; i < JOB_PRIORITY_COUNT; ++i) {
+        ring_queue_destroy(&state_ptr->injected[i]);
+    }
+    ring_queue_destroy(&state_ptr->free_jobs);
+    if (state_ptr->jobs) {
+        memory_free(state_ptr->jobs, sizeof(job) * capacity, MEMORY_TAG_JOB);
+    }
+    state_ptr = 0;
+}
+
+// Undoes a partial job_system_initialize.
+static b8 fail_initialize() {
+    stop_workers();
+    release_state();
+    return false;
+}
+
+
+b8 job_system_initialize(
+    u64* memory_requirement, void* state, job_system_config config
+) {
+    *memory_requirement = sizeof(job_system_state);
+    if (!state) {
+        return true;
+    }
+
+    if ((u64)state % OKO_CACHE_LINE_SIZE) {
+        OKO_ERROR(
+            "job_system_initialize - state must be aligned to OKO_CACHE_LINE_SIZE."
+        );
+        return false;
+    }
+    if (config.max_jobs == 0) {
+        OKO_ERROR("job_system_initialize - config.max_jobs must be > 0.");
+        return false;
+    }
+
+    u32 worker_count = config.worker_count;
+    if (worker_count == 0) {
+        u32 processor_count = platform_get_processor_count();
+        worker_count = processor_count > 1 ? processor_count - 1 : 1;
+    }
+    u32 capacity = 1;
+    while (capacity < config.max_jobs) {
+        capacity <<= 1;
+    }
+
+    state_ptr = state;
+    memory_zero(state_ptr, sizeof(job_system_state));
+    state_ptr->thread_count = worker_count + 1;
+    state_ptr->job_mask = capacity - 1;
+    atomic_b8_store(&state_ptr->running, true, ATOMIC_ORDER_RELAXED);
+
+    state_ptr->jobs = memory_allocate(sizeof(job) * capacity, MEMORY_TAG_JOB);
+    if (!state_ptr->jobs ||
+        !ring_queue_create(
+            sizeof(u32), capacity, RING_QUEUE_MODE_MPMC, 0, &state_ptr->free_jobs
+        )) {
+        OKO_ERROR("job_system_initialize - failed to allocate the jobs.");
+        return fail_initialize();
+    }
+    for (u32 i = 0; i < capacity; ++i) {
+        ring_queue_enqueue(&state_ptr->free_jobs, &i);
+    }
+    for (u32 i = 0; i < JOB_PRIORITY_COUNT; ++i) {
+        if (!ring_queue_create(
+                sizeof(u32),
+                capacity,
+                RING_QUEUE_MODE_MPMC,
+                0,
+                &state_ptr->injected[i]
+            )) {
+            OKO_ERROR(
+                "job_system_initialize - failed to create the injection queues."
+            );
+            return fail_initialize();
+        }
+    }
+
+    state_ptr->workers = memory_allocate_aligned(
+        sizeof(job_worker) * state_ptr->thread_count,
+        OKO_CACHE_LINE_SIZE,
+        MEMORY_TAG_JOB
+    );
+    state_ptr->deque_items = memory_allocate(
+        get_items_size(state_ptr->thread_count, capacity), MEMORY_TAG_JOB
+    );
+    if (!state_ptr->workers || !state_ptr->deque_items) {
+        OKO_ERROR("job_system_initialize - failed to allocate the workers.");
+        return fail_initialize();
+    }
+    memory_zero(state_ptr->workers, sizeof(job_worker) * state_ptr->thread_count);
+    atomic_u32* items = state_ptr->deque_items;
+    for (u32 i = 0; i < state_ptr->thread_count; ++i) {
+        for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+            state_ptr->workers[i].deques[p].items = items;
+            items += capacity;
+        }
+    }
+
+    if (!semaphore_create(0, &state_ptr->wake)) {
+        OKO_ERROR("job_system_initialize - failed to create the semaphore.");
+        return fail_initialize();
+    }
+
+    if (config.fiber_count) {
+        // One for each worker to start on, and at least one to wait with.
+        u32 fiber_count = config.fiber_count > worker_count
+                              ? config.fiber_count
+                              : worker_count + 1;
+        u64 stack_size = get_aligned(
+            config.fiber_stack_size ? config.fiber_stack_size
+                                    : DEFAULT_FIBER_STACK_SIZE,
+            memory_get_page_size()
+        );
+        state_ptr->fiber_count = fiber_count;
+        state_ptr->fiber_stack_size = stack_size;
+        state_ptr->fibers =
+            memory_allocate(sizeof(fiber_context) * fiber_count, MEMORY_TAG_JOB);
+        state_ptr->fiber_stacks =
+            memory_reserve(get_fiber_slot_size() * fiber_count);
+        if (!state_ptr->fibers || !state_ptr->fiber_stacks ||
+            !ring_queue_create(
+                sizeof(u32),
+                fiber_count,
+                RING_QUEUE_MODE_MPMC,
+                0,
+                &state_ptr->free_fibers
+            ) ||
+            !ring_queue_create(
+                sizeof(u32),
+                fiber_count,
+                RING_QUEUE_MODE_MPMC,
+                0,
+                &state_ptr->ready_fibers
+            )) {
+            OKO_ERROR("job_system_initialize - failed to allocate the fibers.");
+            return fail_initialize();
+        }
+        for (u32 i = 0; i < fiber_count; ++i) {
+            // Stacks grow down, toward the guard page left below.
+            u8* stack = get_fiber_stack(i);
+            if (!memory_commit(stack, stack_size)) {
+                OKO_ERROR(
+                    "job_system_initialize - failed to commit fiber stack %u.", i
+                );
+                return fail_initialize();
+            }
+            state_ptr->committed_stack_count++;
+            if (!fiber_context_create(
+                    fiber_main, 0, stack, stack_size, &state_ptr->fibers[i]
+                )) {
+                OKO_ERROR("job_system_initialize - failed to create fiber %u.", i);
+                return fail_initialize();
+            }
+        }
+        // Fibers 1 to worker_count are set aside for the workers.
+        for (u32 i = worker_count + 1; i <= fiber_count; ++i) {
+            ring_queue_enqueue(&state_ptr->free_fibers, &i);
+        }
+    }
+
+    // The initializing thread is worker 1, the threads follow.
+    get_thread_state()->worker = 1;
+    for (u32 i = 1; i < state_ptr->thread_count; ++i) {
+        if (!thread_create(
+                worker_run,
+                (void*)(u64)(i + 1),
+                &state_ptr->workers[i].thread
+            )) {
+            OKO_ERROR("job_system_initialize - failed to start worker %u.", i);
+            return fail_initialize();
+        }
+        char name[16];
+        string_format(name, "job worker %u", i);
+        thread_set_name(&state_ptr->workers[i].thread, name);
+    }
+
+    OKO_INFO(
+        "Job system started %u workers for %u jobs on %u fibers.",
+        worker_count,
+        capacity,
+        state_ptr->fiber_count
+    );
+    return true;
+}
+
+void job_system_shutdown(void* state) {
+    if (state_ptr) {
+        stop_workers();
+        // Whatever the workers left on this thread's deque.
+        while (run_next_job()) {
+        }
+        release_state();
+    }
+}
+
+b8 job_system_submit(const job_desc* jobs, u32 count, job_counter* counter) {
+    if (!state_ptr || (count && !jobs)) {
+        OKO_ERROR("job_system_submit requires an initialized system and jobs.");
+        return false;
+    }
+
+    if (counter) {
+        atomic_u64_fetch_add(&counter->state, count, ATOMIC_ORDER_RELAXED);
+    }
+    for (u32 i = 0; i < count; ++i) {
+        enqueue_job(allocate_job(&jobs[i], counter));
+    }
+    wake_workers(count);
+    return true;
+}
+
+b8 job_system_submit_after(
+    job_counter* dependency,
+    const job_desc* jobs,
+    u32 count,
+    job_counter* counter
+) {
+    if (!dependency) {
+        return job_system_submit(jobs, count, counter);
+    }
+    if (!state_ptr || (count && !jobs)) {
+        OKO_ERROR(
+            "job_system_submit_after requires an initialized system and jobs."
+        );
+        return false;
+    }
+    if (!count) {
+        return true;
+    }
+
+    if (counter) {
+        atomic_u64_fetch_add(&counter->state, count, ATOMIC_ORDER_RELAXED);
+    }
+    // Chain the jobs up front, so they are held back in one step.
+    u32 first = allocate_job(&jobs[0], counter);
+    u32 last = first;
+    for (u32 i = 1; i < count; ++i) {
+        u32 index = allocate_job(&jobs[i], counter);
+        state_ptr->jobs[last].next = index + 1;
+        last = index;
+    }
+
+    hold_back(dependency, first, last);
+    return true;
+}
+
+void job_system_wait(job_counter* counter) {
+    if (!state_ptr) {
+        OKO_ERROR("job_system_wait called before job system initialization.");
+        return;
+    }
+    while (job_counter_pending(counter)) {
+        if (wait_on_fiber(counter)) {
+            continue;
+        }
+        if (!run_next_job()) {
+            thread_yield();
+        }
+    }
+}
+
+u32 job_counter_pending(job_counter* counter) {
+    return (u32)atomic_u64_load(&counter->state, ATOMIC_ORDER_ACQUIRE);
+}
+
+u32 job_system_worker_count() {
+    return state_ptr ? state_ptr->thread_count - 1 : 0;
+}
\ No newline at end of file
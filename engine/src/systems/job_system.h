@@ -0,0 +1,97 @@
+#pragma once
+
+#include "defines.h"
+
+#include "platform/atomic.h"
+
+// Runs jobs on a pool of worker threads. Every worker, and the thread that
+// initializes the system, owns a Chase-Lev deque per priority: it pushes and
+// pops its own jobs at the bottom while idle workers steal from the top of
+// the others. Jobs submitted from any other thread go through a shared queue
+// per priority. Higher priorities are always looked for first, in every
+// source.
+// Jobs report completion through counters. Waiting on a counter runs other
+// jobs in the meantime instead of blocking, so jobs may submit and wait for
+// jobs of their own, and jobs can be held back until a counter reaches 0.
+// With fibers, workers run jobs on a pool of fibers instead of their own
+// stacks. A job that waits parks its fiber on the counter and the worker
+// moves on to a free fiber, so long dependency chains neither grow the
+// stack nor keep the worker from other jobs. The fiber is resumed, by any
+// worker, once the counter reaches 0. Jobs must then not hold locks or rely
+// on the thread across a wait.
+
+typedef void (*PFN_job_entry)(void* params);
+
+typedef enum job_priority {
+    JOB_PRIORITY_HIGH,
+    JOB_PRIORITY_NORMAL,
+    JOB_PRIORITY_LOW,
+    JOB_PRIORITY_COUNT
+} job_priority;
+
+typedef struct job_desc {
+    PFN_job_entry entry;
+    // Handed to entry as is. Must stay valid until the job has run.
+    void* params;
+    job_priority priority;
+} job_desc;
+
+// Tracks a group of jobs. Zero-initialize before first use, and keep it in
+// place while jobs refer to it.
+typedef struct job_counter {
+    // Jobs not yet finished in the low 32 bits. The high 32 bits hold the
+    // jobs held back until that reaches 0, as the 1-based index of the first
+    // one. Both change in a single atomic step, so the job that finishes
+    // last always sees every job held back.
+    atomic_u64 state;
+} job_counter;
+
+typedef struct job_system_config {
+    // Worker threads besides the initializing thread. 0 for one per
+    // remaining processor, at least 1.
+    u32 worker_count;
+    // Jobs that can be queued, held back or parked on a fiber at once,
+    // rounded up to a power of 2. Submitting more makes the submitter run
+    // jobs until some finish.
+    u32 max_jobs;
+    // Fibers shared by the worker threads, raised to worker_count + 1 if
+    // lower. Caps the jobs parked in a wait at once, past that waits run
+    // other jobs on the same stack. 0 to run jobs on the worker threads.
+    u32 fiber_count;
+    // Bytes of stack per fiber, rounded up to whole pages, 0 for 256 KiB.
+    // Each stack has an uncommitted guard page below it.
+    u64 fiber_stack_size;
+} job_system_config;
+
+// state must be aligned to OKO_CACHE_LINE_SIZE.
+OKO_API b8 job_system_initialize(
+    u64* memory_requirement, void* state, job_system_config config
+);
+
+// Lets queued jobs run, then stops the workers.
+OKO_API void job_system_shutdown(void* state);
+
+// Queues count jobs. counter may be 0, otherwise it is raised by count and
+// drops by one as each job finishes.
+OKO_API b8 job_system_submit(
+    const job_desc* jobs, u32 count, job_counter* counter
+);
+
+// Like job_system_submit, but the jobs are only queued once dependency
+// reaches 0, right away if it already has.
+OKO_API b8 job_system_submit_after(
+    job_counter* dependency,
+    const job_desc* jobs,
+    u32 count,
+    job_counter* counter
+);
+
+// Returns once counter reaches 0. Jobs on a fiber park it, anything else
+// runs queued jobs in the meantime.
+OKO_API void job_system_wait(job_counter* counter);
+
+// Jobs of the counter that have not finished, for polling.
+OKO_API u32 job_counter_pending(job_counter* counter);
+
+// Worker threads, not counting the initializing thread.
+OKO_API u32 job_system_worker_count();
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include "parallel_for.h"
+
+#include "containers/darray.h"
+#include "platform/atomic.h"
+#include "platform/platform.h"
+#include "systems/job_system.h"
+
+// The inline timing runs until it has taken at least this long, so the
+// estimate is not just timer noise.
+#define PROBE_SECONDS 0.000002
+// Loops estimated to need less than this run inline, splitting would cost
+// about as much as it saves.
+#define INLINE_SECONDS 0.00005
+// Each claimed batch aims for this long, which keeps claiming cheap next to
+// the work while leaving enough batches to even out uneven items.
+#define BATCH_SECONDS 0.00002
+// Batches per thread at least, however cheap the items.
+#define MIN_BATCHES_PER_THREAD 4
+
+typedef struct parallel_for_state {
+    PFN_parallel_for_range fn;
+    void* user_data;
+    u64 count;
+    u64 batch_size;
+    // Next item not claimed yet.
+    atomic_u64 next;
+} parallel_for_state;
+
+typedef struct darray_range {
+    PFN_parallel_for_elements fn;
+    void* user_data;
+    u8* elements;
+    u64 stride;
+} darray_range;
+
+static void run_batches(void* params) {
+    parallel_for_state* state = params;
+    for (;;) {
+        u64 begin = atomic_u64_fetch_add(
+            &state->next, state->batch_size, ATOMIC_ORDER_RELAXED
+        );
+        if (begin >= state->count) {
+            return;
+        }
+        u64 end = begin + state->batch_size;
+        if (end > state->count) {
+            end = state->count;
+        }
+        state->fn(begin, end, state->user_data);
+    }
+}
+
+void parallel_for(
+    u64 count, u64 min_batch, PFN_parallel_for_range fn, void* user_data
+) {
+    if (!count || !fn) {
+        return;
+    }
+    if (!min_batch) {
+        min_batch = 1;
+    }
+
+    // Time doubling runs until the estimate means something.
+    u64 done = 0;
+    u64 probe = min_batch;
+    f64 start = platform_get_absolute_time();
+    f64 elapsed = 0;
+    while (done < count && elapsed < PROBE_SECONDS) {
+        u64 end = done + probe < count ? done + probe : count;
+        fn(done, end, user_data);
+        done = end;
+        probe *= 2;
+        elapsed = platform_get_absolute_time() - start;
+    }
+
+    u64 remaining = count - done;
+    if (!remaining) {
+        return;
+    }
+    f64 item_seconds = elapsed / done;
+    u32 thread_count = job_system_worker_count() + 1;
+    if (thread_count == 1 || item_seconds * remaining < INLINE_SECONDS) {
+        fn(done, count, user_data);
+        return;
+    }
+
+    u64 batch_size = (u64)(BATCH_SECONDS / item_seconds);
+    u64 balanced = remaining / (thread_count * MIN_BATCHES_PER_THREAD);
+    if (batch_size > balanced) {
+        batch_size = balanced;
+    }
+    if (batch_size < min_batch) {
+        batch_size = min_batch;
+    }
+
+    parallel_for_state state;
+    state.fn = fn;
+    state.user_data = user_data;
+    state.count = count;
+    state.batch_size = batch_size;
+    atomic_u64_store(&state.next, done, ATOMIC_ORDER_RELAXED);
+
+    // A job per worker that can get a batch, the caller takes part too.
+    u64 batch_count = (remaining + batch_size - 1) / batch_size;
+    u32 job_count = thread_count - 1;
+    if (batch_count - 1 < job_count) {
+        job_count = (u32)(batch_count - 1);
+    }
+    job_counter counter = {0};
+    job_desc desc = {run_batches, &state, JOB_PRIORITY_HIGH};
+    for (u32 i = 0; i < job_count; ++i) {
+        job_system_submit(&desc, 1, &counter);
+    }
+    run_batches(&state);
+    job_system_wait(&counter);
+}
+
+static void run_elements(u64 begin, u64 end, void* user_data) {
+    darray_range* range = user_data;
+    range->fn(
+        range->elements + begin * range->stride,
+        begin,
+        end - begin,
+        range->user_data
+    );
+}
+
+void parallel_for_darray(
+    void* array, u64 min_batch, PFN_parallel_for_elements fn, void* user_data
+) {
+    if (!array || !fn) {
+        return;
+    }
+    darray_range range;
+    range.fn = fn;
+    range.user_data = user_data;
+    range.elements = array;
+    range.stride = darray_stride(array);
+    parallel_for(darray_length(array), min_batch, run_elements, &range);
+}
\ No newline at end of file
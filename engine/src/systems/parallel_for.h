@@ -0,0 +1,30 @@
+#pragma once
+
+#include "defines.h"
+
+// Data-parallel loops on top of the job system. The calling thread times a
+// few items first and runs everything itself when the loop is too cheap to
+// be worth splitting, or when the job system is not running. Otherwise the
+// rest is claimed in batches sized from that timing, by the caller and by
+// one job per worker. Both return once every item is done, and the caller
+// waits the way job_system_wait does.
+
+// Handles the items from begin up to, not including, end.
+typedef void (*PFN_parallel_for_range)(u64 begin, u64 end, void* user_data);
+
+// Handles count elements of the array from index first on, elements
+// pointing at the first of them.
+typedef void (*PFN_parallel_for_elements)(
+    void* elements, u64 first, u64 count, void* user_data
+);
+
+// min_batch is the fewest items handed out at once, for loops whose items
+// share setup or write neighbouring memory. 0 counts as 1.
+OKO_API void parallel_for(
+    u64 count, u64 min_batch, PFN_parallel_for_range fn, void* user_data
+);
+
+// parallel_for over every element of a darray.
+OKO_API void parallel_for_darray(
+    void* array, u64 min_batch, PFN_parallel_for_elements fn, void* user_data
+);
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "core/log.h"
 #include "core/memory.h"
 #include "containers/hashtable.h"
+#include "containers/bitset.h"
 
 #include "renderer/renderer.h"
 
@@ -17,6 +18,8 @@ typedef struct texture_system_state {
 
     // Array of registered textures.
     texture* registered_textures;
+    // Bit per registered texture, set while the slot holds a loaded texture.
+    bitset used_slots;
 
     // Hashtable for texture lookups.
     hashtable registered_texture_table;
@@ -45,13 +48,19 @@ b8 texture_system_initialize(
     }
 
     // Block of memory will contain state structure, then block for array, then
-    // block for hashtable.
+    // block for hashtable, then the slot bits. Entries only exist for loaded
+    // textures, so the table is sized for max_texture_count at a 0.75 load
+    // factor.
     u64 struct_requirement = sizeof(texture_system_state);
     u64 array_requirement = sizeof(texture) * config.max_texture_count;
-    u64 hashtable_requirement =
-        sizeof(texture_reference) * config.max_texture_count;
-    *memory_requirement =
-        struct_requirement + array_requirement + hashtable_requirement;
+    u32 table_count = config.max_texture_count + config.max_texture_count / 3;
+    u64 hashtable_requirement = hashtable_get_memory_requirement(
+        sizeof(texture_reference), table_count
+    );
+    u64 bitset_requirement =
+        bitset_get_memory_requirement(config.max_texture_count);
+    *memory_requirement = struct_requirement + array_requirement +
+                          hashtable_requirement + bitset_requirement;
 
     if (!state) {
         return true;
@@ -71,19 +80,17 @@ b8 texture_system_initialize(
     // Create a hashtable for texture lookups.
     hashtable_create(
         sizeof(texture_reference),
-        config.max_texture_count,
+        table_count,
         hashtable_block,
         false,
         &state_ptr->registered_texture_table
     );
 
-    // Fill the hashtable with invalid references to use as a default.
-    texture_reference invalid_ref;
-    invalid_ref.auto_release = false;
-    invalid_ref.handle =
-        INVALID_ID;  // Primary reason for needing default values.
-    invalid_ref.reference_count = 0;
-    hashtable_fill(&state_ptr->registered_texture_table, &invalid_ref);
+    // Slot bits are after the hashtable.
+    void* bitset_block = hashtable_block + hashtable_requirement;
+    bitset_create(
+        config.max_texture_count, bitset_block, &state_ptr->used_slots
+    );
 
     // Invalidate all textures in the array.
     u32 count = state_ptr->config.max_texture_count;
@@ -101,15 +108,17 @@ b8 texture_system_initialize(
 void texture_system_shutdown(void* state) {
     if (state_ptr) {
         // Destroy all loaded textures.
-        for (u32 i = 0; i < state_ptr->config.max_texture_count; ++i) {
-            texture* t = &state_ptr->registered_textures[i];
-            if (t->generation != INVALID_ID) {
-                renderer_destroy_texture(t);
-            }
+        bitset* used = &state_ptr->used_slots;
+        for (u32 i = bitset_find_first_set(used); i != INVALID_ID;
+             i = bitset_find_next_set(used, i + 1)) {
+            renderer_destroy_texture(&state_ptr->registered_textures[i]);
         }
 
         destroy_default_textures(state_ptr);
 
+        // Frees the key copies.
+        hashtable_destroy(&state_ptr->registered_texture_table);
+
         state_ptr = 0;
     }
 }
@@ -125,39 +134,42 @@ texture* texture_system_acquire(const char* name, b8 auto_release) {
     }
 
     texture_reference ref;
-    if (state_ptr &&
-        hashtable_get(&state_ptr->registered_texture_table, name, &ref)) {
+    if (state_ptr) {
+        // Hash the name once for both the lookup and the update.
+        u64 hash = hashtable_hash_name(name);
+        if (!hashtable_get_hashed(
+                &state_ptr->registered_texture_table, name, hash, &ref
+            )) {
+            // First request for this name, no texture exists yet.
+            ref.auto_release = false;
+            ref.handle = INVALID_ID;
+            ref.reference_count = 0;
+        }
+
         // This can only be changed the first time a texture is loaded.
         if (ref.reference_count == 0) {
             ref.auto_release = auto_release;
         }
         ref.reference_count++;
-        if (ref.handle == INVALID_ID) {
-            // This means no texture exists here. Find a free index first.
-            u32 count = state_ptr->config.max_texture_count;
-            texture* t = 0;
-            for (u32 i = 0; i < count; ++i) {
-                if (state_ptr->registered_textures[i].id == INVALID_ID) {
-                    // A free slot has been found. Use its index as the handle.
-                    ref.handle = i;
-                    t = &state_ptr->registered_textures[i];
-                    break;
-                }
-            }
-
-            // Make sure an empty slot was actually found.
-            if (!t || ref.handle == INVALID_ID) {
+        b8 created = ref.handle == INVALID_ID;
+        if (created) {
+            // This means no texture exists here. Find a free index first and
+            // use it as the handle.
+            ref.handle = bitset_find_first_clear(&state_ptr->used_slots);
+            if (ref.handle == INVALID_ID) {
                 OKO_FATAL(
                     "texture_system_acquire - Texture system cannot hold anymore textures. Adjust configuration to allow more."
                 );
                 return 0;
             }
+            texture* t = &state_ptr->registered_textures[ref.handle];
 
             // Create new texture.
             if (!load_texture(name, t)) {
                 OKO_ERROR("Failed to load texture '%s'.", name);
                 return 0;
             }
+            bitset_set(&state_ptr->used_slots, ref.handle);
 
             // Also use the handle as the texture id.
             t->id = ref.handle;
@@ -175,7 +187,24 @@ texture* texture_system_acquire(const char* name, b8 auto_release) {
         }
 
         // Update the entry.
-        hashtable_set(&state_ptr->registered_texture_table, name, &ref);
+        if (!hashtable_set_hashed(
+                &state_ptr->registered_texture_table, name, hash, &ref
+            )) {
+            OKO_ERROR(
+                "texture_system_acquire - failed to register texture '%s'.",
+                name
+            );
+            if (created) {
+                // Nothing refers to it, give back the texture and its slot.
+                texture* t = &state_ptr->registered_textures[ref.handle];
+                renderer_destroy_texture(t);
+                memory_zero(t, sizeof(texture));
+                t->id = INVALID_ID;
+                t->generation = INVALID_ID;
+                bitset_clear(&state_ptr->used_slots, ref.handle);
+            }
+            return 0;
+        }
         return &state_ptr->registered_textures[ref.handle];
     }
 
@@ -194,8 +223,10 @@ void texture_system_release(const char* name) {
         return;
     }
     texture_reference ref;
-    if (state_ptr &&
-        hashtable_get(&state_ptr->registered_texture_table, name, &ref)) {
+    u64 hash = hashtable_hash_name(name);
+    if (state_ptr && hashtable_get_hashed(
+                         &state_ptr->registered_texture_table, name, hash, &ref
+                     )) {
         if (ref.reference_count == 0) {
             OKO_WARN("Tried to release non-existent texture: '%s'", name);
             return;
@@ -211,14 +242,15 @@ void texture_system_release(const char* name) {
             memory_zero(t, sizeof(texture));
             t->id = INVALID_ID;
             t->generation = INVALID_ID;
+            bitset_clear(&state_ptr->used_slots, ref.handle);
 
-            // Reset the reference.
-            ref.handle = INVALID_ID;
-            ref.auto_release = false;
+            // Drop the reference, the next acquire starts over.
+            hashtable_remove(&state_ptr->registered_texture_table, name);
             OKO_TRACE(
                 "Released texture '%s'., Texture unloaded because reference count=0 and auto_release=true.",
                 name
             );
+            return;
         } else {
             OKO_TRACE(
                 "Released texture '%s', now has a reference count of '%i' (auto_release=%s).",
@@ -229,7 +261,9 @@ void texture_system_release(const char* name) {
         }
 
         // Update the entry.
-        hashtable_set(&state_ptr->registered_texture_table, name, &ref);
+        hashtable_set_hashed(
+            &state_ptr->registered_texture_table, name, hash, &ref
+        );
     } else {
         OKO_ERROR(
             "texture_system_release failed to release texture '%s'.", name
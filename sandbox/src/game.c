@@ -86,6 +86,12 @@ b8 game_update(game* game_inst, f32 delta_time) {
             alloc_count,
             alloc_count - prev_alloc_count
         );
+        OKO_DEBUG(
+            "Frame allocator: %lluB this frame, %lluB last frame, %lluB peak",
+            frame_allocator_get_frame_usage(),
+            frame_allocator_get_last_frame_usage(),
+            frame_allocator_get_high_water_mark()
+        );
     }
 
     // TODO: temporary
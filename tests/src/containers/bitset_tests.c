@@ -0,0 +1,182 @@
+#include "bitset_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/bitset.h>
+#include <core/clock.h>
+#include <core/log.h>
+#include <core/memory.h>
+
+#define BENCH_SLOT_COUNT 65536
+#define BENCH_ROUNDS     2000
+
+// Stand-in for a registry entry such as a texture.
+typedef struct bench_slot {
+    u32 id;
+    u8 payload[60];
+} bench_slot;
+
+// Naive reference for the searches.
+static u32 scan_next(bitset* set, u32 index, b8 want_set) {
+    for (u32 i = index; i < set->bit_count; ++i) {
+        if (bitset_test(set, i) == want_set) {
+            return i;
+        }
+    }
+    return INVALID_ID;
+}
+
+u8 bitset_should_set_clear_and_count() {
+    bitset set;
+    expect_to_be_true(bitset_create(100, 0, &set));
+    expect_should_be(2, set.word_count);
+    expect_should_be(1, set.level_count);
+    expect_should_be(0, bitset_count(&set));
+    expect_should_be(INVALID_ID, bitset_find_first_set(&set));
+    expect_should_be(0, bitset_find_first_clear(&set));
+
+    bitset_set(&set, 3);
+    bitset_set(&set, 64);
+    bitset_set(&set, 99);
+    bitset_set(&set, 99);
+    expect_to_be_true(bitset_test(&set, 64));
+    expect_to_be_false(bitset_test(&set, 65));
+    expect_should_be(3, bitset_count(&set));
+    expect_should_be(3, bitset_find_first_set(&set));
+    expect_should_be(64, bitset_find_next_set(&set, 4));
+    expect_should_be(99, bitset_find_next_set(&set, 65));
+    expect_should_be(INVALID_ID, bitset_find_next_set(&set, 100));
+
+    bitset_clear(&set, 3);
+    expect_should_be(64, bitset_find_first_set(&set));
+
+    // Bits past the end never show up as clear.
+    for (u32 i = 0; i < 100; ++i) {
+        bitset_set(&set, i);
+    }
+    expect_should_be(100, bitset_count(&set));
+    expect_should_be(INVALID_ID, bitset_find_first_clear(&set));
+    bitset_clear(&set, 77);
+    expect_should_be(77, bitset_find_first_clear(&set));
+    expect_should_be(INVALID_ID, bitset_find_next_clear(&set, 78));
+
+    bitset_destroy(&set);
+    expect_should_be(0, set.words);
+    return true;
+}
+
+u8 bitset_should_search_like_a_scan() {
+    u32 sizes[] = {1, 64, 65, 4096, 4097, 300000};
+    u64 random = 0x2545F4914F6CDD1DULL;
+    for (u32 s = 0; s < sizeof(sizes) / sizeof(u32); ++s) {
+        u32 bit_count = sizes[s];
+        u64 size = bitset_get_memory_requirement(bit_count);
+        void* memory = memory_allocate(size, MEMORY_TAG_ARRAY);
+        bitset set;
+        expect_to_be_true(bitset_create(bit_count, memory, &set));
+
+        // Mostly sets, so the searches also run over long full stretches.
+        for (u32 op = 0; op < 4000; ++op) {
+            random ^= random << 13;
+            random ^= random >> 7;
+            random ^= random << 17;
+            u32 index = (u32)(random % bit_count);
+            if (random >> 62) {
+                bitset_set(&set, index);
+            } else {
+                bitset_clear(&set, index);
+            }
+
+            u32 from = (u32)((random >> 32) % bit_count);
+            expect_should_be(
+                scan_next(&set, from, true), bitset_find_next_set(&set, from)
+            );
+            expect_should_be(
+                scan_next(&set, from, false),
+                bitset_find_next_clear(&set, from)
+            );
+        }
+        expect_should_be(scan_next(&set, 0, true), bitset_find_first_set(&set));
+        expect_should_be(
+            scan_next(&set, 0, false), bitset_find_first_clear(&set)
+        );
+
+        // Fill completely, then free one bit near the end.
+        for (u32 i = 0; i < bit_count; ++i) {
+            bitset_set(&set, i);
+        }
+        expect_should_be(INVALID_ID, bitset_find_first_clear(&set));
+        bitset_clear(&set, bit_count - 1);
+        expect_should_be(bit_count - 1, bitset_find_first_clear(&set));
+        expect_should_be(bit_count - 1, bitset_count(&set));
+
+        bitset_destroy(&set);
+        memory_free(memory, size, MEMORY_TAG_ARRAY);
+    }
+    return true;
+}
+
+u8 bitset_slot_allocation_benchmark() {
+    bench_slot* slots =
+        memory_allocate(sizeof(bench_slot) * BENCH_SLOT_COUNT, MEMORY_TAG_GAME);
+    bitset used;
+    bitset_create(BENCH_SLOT_COUNT, 0, &used);
+
+    // Fill all but the last 64 slots, then free and retake one slot per
+    // round from that tail, the worst case for a scan.
+    for (u32 i = 0; i < BENCH_SLOT_COUNT; ++i) {
+        slots[i].id = i < BENCH_SLOT_COUNT - 64 ? i : INVALID_ID;
+        if (slots[i].id != INVALID_ID) {
+            bitset_set(&used, i);
+        }
+    }
+
+    clock timer;
+    u64 found = 0;
+    clock_start(&timer);
+    for (u32 round = 0; round < BENCH_ROUNDS; ++round) {
+        for (u32 i = 0; i < BENCH_SLOT_COUNT; ++i) {
+            if (slots[i].id == INVALID_ID) {
+                found += i;
+                break;
+            }
+        }
+    }
+    clock_update(&timer);
+    f64 scan_time = timer.elapsed * 1e9 / BENCH_ROUNDS;
+
+    u64 found_bitset = 0;
+    clock_start(&timer);
+    for (u32 round = 0; round < BENCH_ROUNDS; ++round) {
+        found_bitset += bitset_find_first_clear(&used);
+    }
+    clock_update(&timer);
+    f64 bitset_time = timer.elapsed * 1e9 / BENCH_ROUNDS;
+    expect_should_be(found, found_bitset);
+
+    OKO_INFO(
+        "First free of %u slots: scan %.1f ns, bitset %.1f ns.",
+        BENCH_SLOT_COUNT,
+        scan_time,
+        bitset_time
+    );
+
+    bitset_destroy(&used);
+    memory_free(slots, sizeof(bench_slot) * BENCH_SLOT_COUNT, MEMORY_TAG_GAME);
+    return true;
+}
+
+void bitset_register_tests() {
+    test_manager_register_test(
+        bitset_should_set_clear_and_count, "Bitset should set, clear and count"
+    );
+    test_manager_register_test(
+        bitset_should_search_like_a_scan, "Bitset should search like a scan"
+    );
+    test_manager_register_test(
+        bitset_slot_allocation_benchmark,
+        "Bitset slot allocation benchmark against a scan"
+    );
+}
\ No newline at end of file
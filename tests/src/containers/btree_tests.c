@@ -0,0 +1,325 @@
+#include "btree_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/btree.h>
+#include <containers/darray.h>
+#include <core/clock.h>
+#include <core/log.h>
+#include <core/memory.h>
+
+#define BENCH_COUNT   65536
+#define BENCH_LOOKUPS 65536
+#define BENCH_INSERTS 10000
+// Prime, so stepping by it visits every index in a scattered order.
+#define BENCH_STEP    7919
+
+// Multiplying by an odd constant is a bijection on u64: distinct keys in no
+// particular order.
+static u64 scatter(u64 i) {
+    return i * 0x9E3779B97F4A7C15ULL;
+}
+
+typedef struct sorted_entry {
+    u64 key;
+    u64 value;
+} sorted_entry;
+
+u8 btree_should_insert_get_and_walk_in_order() {
+    btree tree;
+    expect_to_be_true(btree_create(64, &tree));
+    expect_should_be(1, tree.height);
+
+    for (u64 i = 0; i < 10000; ++i) {
+        expect_to_be_true(btree_insert(&tree, scatter(i), i));
+    }
+    expect_should_be(10000, tree.count);
+    expect_to_be_true(tree.height > 2);
+
+    for (u64 i = 0; i < 10000; ++i) {
+        u64 value = 0;
+        expect_to_be_true(btree_get(&tree, scatter(i), &value));
+        expect_should_be(i, value);
+    }
+    u64 value = 7;
+    expect_to_be_false(btree_get(&tree, scatter(10000), &value));
+    expect_should_be(7, value);
+
+    // Updates keep the count.
+    expect_to_be_true(btree_insert(&tree, scatter(42), 4242));
+    expect_to_be_true(btree_get(&tree, scatter(42), &value));
+    expect_should_be(4242, value);
+    expect_should_be(10000, tree.count);
+
+    btree_iterator it = btree_range(&tree, 0, ~0ULL);
+    u64 key;
+    u64 previous = 0;
+    u64 walked = 0;
+    while (btree_iterator_next(&it, &key, 0)) {
+        if (walked) {
+            expect_to_be_true(key > previous);
+        }
+        previous = key;
+        walked++;
+    }
+    expect_should_be(10000, walked);
+
+    btree_destroy(&tree);
+    expect_should_be(0, tree.root);
+    return true;
+}
+
+u8 btree_should_walk_ranges() {
+    btree tree;
+    expect_to_be_true(btree_create(64, &tree));
+    // Multiples of 3 below 30000, inserted out of order.
+    for (u64 i = 0; i < 10000; ++i) {
+        u64 key = ((i * BENCH_STEP) % 10000) * 3;
+        expect_to_be_true(btree_insert(&tree, key, key / 3));
+    }
+
+    btree_iterator it = btree_range(&tree, 100, 200);
+    u64 key;
+    u64 value;
+    u64 expected = 102;
+    u64 walked = 0;
+    while (btree_iterator_next(&it, &key, &value)) {
+        expect_should_be(expected, key);
+        expect_should_be(key / 3, value);
+        expected += 3;
+        walked++;
+    }
+    expect_should_be(33, walked);
+    // Exhausted iterators stay exhausted.
+    expect_to_be_false(btree_iterator_next(&it, &key, &value));
+
+    it = btree_range(&tree, 1, 2);
+    expect_to_be_false(btree_iterator_next(&it, &key, &value));
+    it = btree_range(&tree, 29997, ~0ULL);
+    expect_to_be_true(btree_iterator_next(&it, &key, &value));
+    expect_should_be(29997, key);
+    expect_to_be_false(btree_iterator_next(&it, &key, &value));
+    it = btree_range(&tree, 50000, 60000);
+    expect_to_be_false(btree_iterator_next(&it, &key, &value));
+
+    btree_destroy(&tree);
+    return true;
+}
+
+u8 btree_should_remove_and_free_nodes() {
+    btree tree;
+    expect_to_be_true(btree_create(64, &tree));
+    for (u64 i = 0; i < 20000; ++i) {
+        expect_to_be_true(btree_insert(&tree, scatter(i), i));
+    }
+
+    // Remove every other key, then check both halves.
+    for (u64 i = 0; i < 20000; i += 2) {
+        expect_to_be_true(btree_remove(&tree, scatter(i)));
+    }
+    expect_to_be_false(btree_remove(&tree, scatter(0)));
+    expect_should_be(10000, tree.count);
+    for (u64 i = 0; i < 20000; ++i) {
+        u64 value = 0;
+        expect_should_be(i % 2 == 1, btree_get(&tree, scatter(i), &value));
+    }
+
+    btree_iterator it = btree_range(&tree, 0, ~0ULL);
+    u64 walked = 0;
+    while (btree_iterator_next(&it, 0, 0)) {
+        walked++;
+    }
+    expect_should_be(10000, walked);
+
+    // In a different order than they went in.
+    for (u64 i = 0; i < 10000; ++i) {
+        u64 index = ((i * BENCH_STEP) % 10000) * 2 + 1;
+        expect_to_be_true(btree_remove(&tree, scatter(index)));
+    }
+    expect_should_be(0, tree.count);
+    expect_should_be(1, tree.height);
+    // Only the empty root leaf is left.
+    expect_should_be(1, tree.nodes.allocated_count);
+    it = btree_range(&tree, 0, ~0ULL);
+    expect_to_be_false(btree_iterator_next(&it, 0, 0));
+
+    expect_to_be_true(btree_insert(&tree, 5, 50));
+    u64 value = 0;
+    expect_to_be_true(btree_get(&tree, 5, &value));
+    expect_should_be(50, value);
+
+    btree_destroy(&tree);
+    return true;
+}
+
+u8 btree_should_bulk_load() {
+    u64 count = 100000;
+    u64* keys = memory_allocate(count * sizeof(u64), MEMORY_TAG_GAME);
+    u64* values = memory_allocate(count * sizeof(u64), MEMORY_TAG_GAME);
+    for (u64 i = 0; i < count; ++i) {
+        keys[i] = i * 2;
+        values[i] = i;
+    }
+
+    btree tree;
+    expect_to_be_true(btree_create(256, &tree));
+    expect_to_be_true(btree_insert(&tree, 1, 1));
+    expect_to_be_true(btree_bulk_load(&tree, keys, values, count));
+    expect_should_be(count, tree.count);
+    // 6667 full leaves under 3 levels of 16-way nodes.
+    expect_should_be(5, tree.height);
+    u64 value = 0;
+    expect_to_be_false(btree_get(&tree, 1, &value));
+    expect_to_be_true(btree_get(&tree, 199998, &value));
+    expect_should_be(99999, value);
+
+    // Still an ordinary tree afterwards.
+    for (u64 i = 1; i < 2000; i += 2) {
+        expect_to_be_true(btree_insert(&tree, i, i));
+    }
+    expect_should_be(count + 1000, tree.count);
+    btree_iterator it = btree_range(&tree, 0, 2000);
+    u64 key;
+    u64 expected = 0;
+    while (btree_iterator_next(&it, &key, 0)) {
+        expect_should_be(expected, key);
+        expected++;
+    }
+    expect_should_be(2001, expected);
+
+    OKO_DEBUG("The following error message is intentional.");
+    keys[10] = keys[9];
+    expect_to_be_false(btree_bulk_load(&tree, keys, values, count));
+    expect_should_be(count + 1000, tree.count);
+
+    btree_destroy(&tree);
+    memory_free(keys, count * sizeof(u64), MEMORY_TAG_GAME);
+    memory_free(values, count * sizeof(u64), MEMORY_TAG_GAME);
+    return true;
+}
+
+// Index of the first entry with a key >= key.
+static u64 sorted_lower_bound(sorted_entry* entries, u64 key) {
+    u64 low = 0;
+    u64 high = darray_length(entries);
+    while (low < high) {
+        u64 middle = (low + high) / 2;
+        if (entries[middle].key < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+u8 btree_benchmark_against_sorted_darray() {
+    u64* keys = memory_allocate(BENCH_COUNT * sizeof(u64), MEMORY_TAG_GAME);
+    u64* values = memory_allocate(BENCH_COUNT * sizeof(u64), MEMORY_TAG_GAME);
+    sorted_entry* sorted = darray_reserve(sorted_entry, BENCH_COUNT);
+    for (u64 i = 0; i < BENCH_COUNT; ++i) {
+        keys[i] = i * 4;
+        values[i] = i;
+        sorted_entry entry = {i * 4, i};
+        darray_push(sorted, entry);
+    }
+
+    btree tree;
+    btree_create(1024, &tree);
+    btree_bulk_load(&tree, keys, values, BENCH_COUNT);
+
+    clock timer;
+    u64 found = 0;
+    u64 index = 0;
+    clock_start(&timer);
+    for (u32 i = 0; i < BENCH_LOOKUPS; ++i) {
+        u64 value;
+        found += btree_get(&tree, index * 4, &value);
+        index = (index + BENCH_STEP) % BENCH_COUNT;
+    }
+    clock_update(&timer);
+    f64 tree_lookup = timer.elapsed * 1e9 / BENCH_LOOKUPS;
+    expect_should_be(BENCH_LOOKUPS, found);
+
+    found = 0;
+    index = 0;
+    clock_start(&timer);
+    for (u32 i = 0; i < BENCH_LOOKUPS; ++i) {
+        u64 position = sorted_lower_bound(sorted, index * 4);
+        found += position < BENCH_COUNT && sorted[position].key == index * 4;
+        index = (index + BENCH_STEP) % BENCH_COUNT;
+    }
+    clock_update(&timer);
+    f64 sorted_lookup = timer.elapsed * 1e9 / BENCH_LOOKUPS;
+    expect_should_be(BENCH_LOOKUPS, found);
+
+    // Walk everything once.
+    u64 sum = 0;
+    clock_start(&timer);
+    btree_iterator it = btree_range(&tree, 0, ~0ULL);
+    u64 value;
+    while (btree_iterator_next(&it, 0, &value)) {
+        sum += value;
+    }
+    clock_update(&timer);
+    f64 tree_walk = timer.elapsed * 1e9 / BENCH_COUNT;
+    expect_should_be((u64)BENCH_COUNT * (BENCH_COUNT - 1) / 2, sum);
+
+    // Scattered inserts between existing keys.
+    index = 0;
+    clock_start(&timer);
+    for (u32 i = 0; i < BENCH_INSERTS; ++i) {
+        btree_insert(&tree, index * 4 + 1, i);
+        index = (index + BENCH_STEP) % BENCH_COUNT;
+    }
+    clock_update(&timer);
+    f64 tree_insert = timer.elapsed * 1e9 / BENCH_INSERTS;
+    expect_should_be(BENCH_COUNT + BENCH_INSERTS, tree.count);
+
+    index = 0;
+    clock_start(&timer);
+    for (u32 i = 0; i < BENCH_INSERTS; ++i) {
+        sorted_entry entry = {index * 4 + 1, i};
+        u64 position = sorted_lower_bound(sorted, entry.key);
+        darray_insert_at(sorted, position, entry);
+        index = (index + BENCH_STEP) % BENCH_COUNT;
+    }
+    clock_update(&timer);
+    f64 sorted_insert = timer.elapsed * 1e9 / BENCH_INSERTS;
+    expect_should_be(BENCH_COUNT + BENCH_INSERTS, darray_length(sorted));
+
+    OKO_INFO(
+        "%u entries: btree lookup %.1f ns insert %.1f ns walk %.1f ns, sorted darray lookup %.1f ns insert %.1f ns.",
+        BENCH_COUNT,
+        tree_lookup,
+        tree_insert,
+        tree_walk,
+        sorted_lookup,
+        sorted_insert
+    );
+
+    btree_destroy(&tree);
+    darray_destroy(sorted);
+    memory_free(keys, BENCH_COUNT * sizeof(u64), MEMORY_TAG_GAME);
+    memory_free(values, BENCH_COUNT * sizeof(u64), MEMORY_TAG_GAME);
+    return true;
+}
+
+void btree_register_tests() {
+    test_manager_register_test(
+        btree_should_insert_get_and_walk_in_order,
+        "Btree should insert, get and walk in order"
+    );
+    test_manager_register_test(btree_should_walk_ranges, "Btree should walk ranges");
+    test_manager_register_test(
+        btree_should_remove_and_free_nodes,
+        "Btree should remove and free nodes"
+    );
+    test_manager_register_test(btree_should_bulk_load, "Btree should bulk load");
+    test_manager_register_test(
+        btree_benchmark_against_sorted_darray,
+        "Btree benchmark against sorted darray"
+    );
+}
\ No newline at end of file
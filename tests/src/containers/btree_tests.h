@@ -0,0 +1,3 @@
+#pragma once
+
+void btree_register_tests();
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "darray_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/darray.h>
+#include <math/math_types.h>
+
+u8 darray_should_push_n_and_append() {
+    u32* array = darray_create(u32);
+    u32 values[100];
+    for (u32 i = 0; i < 100; ++i) {
+        values[i] = i;
+    }
+
+    darray_push_n(array, values, 100);
+    expect_should_be(100, darray_length(array));
+    expect_to_be_true(darray_capacity(array) >= 100);
+
+    u32* other = darray_reserve(u32, 3);
+    darray_push_n(other, values, 3);
+    darray_append(array, other);
+    expect_should_be(103, darray_length(array));
+
+    for (u32 i = 0; i < 103; ++i) {
+        u32 expected = i < 100 ? i : i - 100;
+        expect_should_be(expected, array[i]);
+    }
+
+    darray_destroy(other);
+    darray_destroy(array);
+    return true;
+}
+
+u8 darray_should_append_to_itself() {
+    u32* array = darray_reserve(u32, 4);
+    u32 values[4] = {1, 2, 3, 4};
+    darray_push_n(array, values, 4);
+
+    // Full, so appending moves the array while reading from it.
+    darray_append(array, array);
+    expect_should_be(8, darray_length(array));
+    for (u32 i = 0; i < 8; ++i) {
+        expect_should_be(values[i % 4], array[i]);
+    }
+
+    darray_destroy(array);
+    return true;
+}
+
+u8 darray_should_reserve_more_and_shrink() {
+    u64* array = darray_create(u64);
+    darray_reserve_more(array, 1000);
+    u64 capacity = darray_capacity(array);
+    expect_to_be_true(capacity >= 1000);
+
+    // No reallocation while pushing into reserved room.
+    u64* before = array;
+    for (u64 i = 0; i < 1000; ++i) {
+        darray_push(array, i);
+    }
+    expect_should_be(before, array);
+    expect_should_be(capacity, darray_capacity(array));
+
+    darray_length_set(array, 10);
+    darray_shrink_to_fit(array);
+    expect_should_be(10, darray_capacity(array));
+    for (u64 i = 0; i < 10; ++i) {
+        expect_should_be(i, array[i]);
+    }
+
+    // An emptied array keeps room for one element and can still grow.
+    darray_clear(array);
+    darray_shrink_to_fit(array);
+    expect_should_be(1, darray_capacity(array));
+    darray_push(array, (u64)7);
+    darray_push(array, (u64)8);
+    expect_should_be(8, array[1]);
+
+    darray_destroy(array);
+    return true;
+}
+
+u8 darray_should_insert_and_pop_keeping_order() {
+    u32* array = darray_create(u32);
+    for (u32 i = 0; i < 8; ++i) {
+        darray_push(array, i);
+    }
+
+    // Shifting the tail overlaps the source and destination ranges.
+    darray_insert_at(array, 2, (u32)100);
+    darray_insert_at(array, 8, (u32)200);
+    darray_insert_at(array, darray_length(array), (u32)300);
+    u32 expected[] = {0, 1, 100, 2, 3, 4, 5, 6, 200, 7, 300};
+    expect_should_be(11, darray_length(array));
+    for (u32 i = 0; i < 11; ++i) {
+        expect_should_be(expected[i], array[i]);
+    }
+
+    u32 popped = 0;
+    darray_pop_at(array, 2, &popped);
+    expect_should_be(100, popped);
+    darray_pop_at(array, 7, 0);
+    darray_pop_at(array, darray_length(array) - 1, &popped);
+    expect_should_be(300, popped);
+    expect_should_be(8, darray_length(array));
+    for (u32 i = 0; i < 8; ++i) {
+        expect_should_be(i, array[i]);
+    }
+
+    darray_destroy(array);
+    return true;
+}
+
+u8 darray_should_swap_remove() {
+    u32* array = darray_create(u32);
+    for (u32 i = 0; i < 5; ++i) {
+        darray_push(array, i);
+    }
+
+    u32 removed = 0;
+    darray_swap_remove(array, 1, &removed);
+    expect_should_be(1, removed);
+    expect_should_be(4, darray_length(array));
+    expect_should_be(4, array[1]);
+
+    // Removing the last element only shortens the array.
+    darray_swap_remove(array, 3, 0);
+    expect_should_be(3, darray_length(array));
+    expect_should_be(0, array[0]);
+    expect_should_be(4, array[1]);
+    expect_should_be(2, array[2]);
+
+    darray_destroy(array);
+    return true;
+}
+
+u8 darray_should_keep_elements_aligned() {
+    // Plain arrays already suit 16 byte vector loads.
+    vec4* vectors = darray_create(vec4);
+    expect_should_be(0, (u64)vectors % 16);
+    darray_destroy(vectors);
+
+    mat4* matrices = darray_create_aligned(mat4, 64);
+    expect_should_be(64, darray_alignment(matrices));
+    for (u32 i = 0; i < 100; ++i) {
+        mat4 m = {0};
+        m.data[0] = (f32)i;
+        darray_push(matrices, m);
+        // Growing moves the array, the elements stay aligned.
+        expect_should_be(0, (u64)matrices % 64);
+    }
+
+    mat4 range[10] = {0};
+    darray_push_n(matrices, range, 10);
+    darray_shrink_to_fit(matrices);
+    expect_should_be(0, (u64)matrices % 64);
+    expect_should_be(110, darray_length(matrices));
+    for (u32 i = 0; i < 100; ++i) {
+        expect_float_to_be((f32)i, matrices[i].data[0]);
+    }
+    darray_destroy(matrices);
+
+    // Alignments below the default get the default.
+    u8* bytes = darray_reserve_aligned(u8, 64, 4);
+    expect_should_be(DARRAY_DEFAULT_ALIGNMENT, darray_alignment(bytes));
+    darray_destroy(bytes);
+    return true;
+}
+
+void darray_register_tests() {
+    test_manager_register_test(
+        darray_should_push_n_and_append, "Darray should push ranges and append"
+    );
+    test_manager_register_test(
+        darray_should_append_to_itself, "Darray should append to itself"
+    );
+    test_manager_register_test(
+        darray_should_reserve_more_and_shrink,
+        "Darray should reserve more and shrink to fit"
+    );
+    test_manager_register_test(
+        darray_should_insert_and_pop_keeping_order,
+        "Darray should insert and pop keeping order"
+    );
+    test_manager_register_test(
+        darray_should_swap_remove, "Darray should swap remove"
+    );
+    test_manager_register_test(
+        darray_should_keep_elements_aligned,
+        "Darray should keep elements aligned"
+    );
+}
\ No newline at end of file
@@ -5,12 +5,17 @@
 
 #include <defines.h>
 #include <containers/hashtable.h>
+#include <containers/string.h>
+#include <core/log.h>
+#include <core/memory.h>
 
 u8 hashtable_should_create_and_destroy() {
     hashtable table;
     u64 element_size = sizeof(u64);
     u64 element_count = 3;
-    u64 memory[3];
+    u64 memory_size =
+        hashtable_get_memory_requirement(element_size, element_count);
+    void* memory = memory_allocate(memory_size, MEMORY_TAG_DICT);
 
     hashtable_create(element_size, element_count, memory, false, &table);
 
@@ -24,6 +29,7 @@ u8 hashtable_should_create_and_destroy() {
     expect_should_be(0, table.element_size);
     expect_should_be(0, table.element_count);
 
+    memory_free(memory, memory_size, MEMORY_TAG_DICT);
     return true;
 }
 
@@ -31,7 +37,9 @@ u8 hashtable_should_set_and_get_successfully() {
     hashtable table;
     u64 element_size = sizeof(u64);
     u64 element_count = 3;
-    u64 memory[3];
+    u64 memory_size =
+        hashtable_get_memory_requirement(element_size, element_count);
+    void* memory = memory_allocate(memory_size, MEMORY_TAG_DICT);
 
     hashtable_create(element_size, element_count, memory, false, &table);
 
@@ -51,6 +59,7 @@ u8 hashtable_should_set_and_get_successfully() {
     expect_should_be(0, table.element_size);
     expect_should_be(0, table.element_count);
 
+    memory_free(memory, memory_size, MEMORY_TAG_DICT);
     return true;
 }
 
@@ -64,7 +73,9 @@ u8 hashtable_should_set_and_get_ptr_successfully() {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct*);
     u64 element_count = 3;
-    ht_test_struct* memory[3];
+    u64 memory_size =
+        hashtable_get_memory_requirement(element_size, element_count);
+    void* memory = memory_allocate(memory_size, MEMORY_TAG_DICT);
 
     hashtable_create(element_size, element_count, memory, true, &table);
 
@@ -91,6 +102,7 @@ u8 hashtable_should_set_and_get_ptr_successfully() {
     expect_should_be(0, table.element_size);
     expect_should_be(0, table.element_count);
 
+    memory_free(memory, memory_size, MEMORY_TAG_DICT);
     return true;
 }
 
@@ -98,7 +110,9 @@ u8 hashtable_should_set_and_get_nonexistant() {
     hashtable table;
     u64 element_size = sizeof(u64);
     u64 element_count = 3;
-    u64 memory[3];
+    u64 memory_size =
+        hashtable_get_memory_requirement(element_size, element_count);
+    void* memory = memory_allocate(memory_size, MEMORY_TAG_DICT);
 
     hashtable_create(element_size, element_count, memory, false, &table);
 
@@ -118,6 +132,7 @@ u8 hashtable_should_set_and_get_nonexistant() {
     expect_should_be(0, table.element_size);
     expect_should_be(0, table.element_count);
 
+    memory_free(memory, memory_size, MEMORY_TAG_DICT);
     return true;
 }
 
@@ -125,7 +140,9 @@ u8 hashtable_should_set_and_get_ptr_nonexistant() {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct*);
     u64 element_count = 3;
-    ht_test_struct* memory[3];
+    u64 memory_size =
+        hashtable_get_memory_requirement(element_size, element_count);
+    void* memory = memory_allocate(memory_size, MEMORY_TAG_DICT);
 
     hashtable_create(element_size, element_count, memory, true, &table);
 
@@ -152,6 +169,7 @@ u8 hashtable_should_set_and_get_ptr_nonexistant() {
     expect_should_be(0, table.element_size);
     expect_should_be(0, table.element_count);
 
+    memory_free(memory, memory_size, MEMORY_TAG_DICT);
     return true;
 }
 
@@ -159,7 +177,9 @@ u8 hashtable_should_set_and_unset_ptr() {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct*);
     u64 element_count = 3;
-    ht_test_struct* memory[3];
+    u64 memory_size =
+        hashtable_get_memory_requirement(element_size, element_count);
+    void* memory = memory_allocate(memory_size, MEMORY_TAG_DICT);
 
     hashtable_create(element_size, element_count, memory, true, &table);
 
@@ -198,6 +218,7 @@ u8 hashtable_should_set_and_unset_ptr() {
     expect_should_be(0, table.element_size);
     expect_should_be(0, table.element_count);
 
+    memory_free(memory, memory_size, MEMORY_TAG_DICT);
     return true;
 }
 
@@ -205,7 +226,9 @@ u8 hashtable_try_call_non_ptr_on_ptr_table() {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct*);
     u64 element_count = 3;
-    ht_test_struct* memory[3];
+    u64 memory_size =
+        hashtable_get_memory_requirement(element_size, element_count);
+    void* memory = memory_allocate(memory_size, MEMORY_TAG_DICT);
 
     hashtable_create(element_size, element_count, memory, true, &table);
 
@@ -234,6 +257,7 @@ u8 hashtable_try_call_non_ptr_on_ptr_table() {
     expect_should_be(0, table.element_size);
     expect_should_be(0, table.element_count);
 
+    memory_free(memory, memory_size, MEMORY_TAG_DICT);
     return true;
 }
 
@@ -241,7 +265,9 @@ u8 hashtable_try_call_ptr_on_non_ptr_table() {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct);
     u64 element_count = 3;
-    ht_test_struct memory[3];
+    u64 memory_size =
+        hashtable_get_memory_requirement(element_size, element_count);
+    void* memory = memory_allocate(memory_size, MEMORY_TAG_DICT);
 
     hashtable_create(element_size, element_count, memory, false, &table);
 
@@ -271,6 +297,7 @@ u8 hashtable_try_call_ptr_on_non_ptr_table() {
     expect_should_be(0, table.element_size);
     expect_should_be(0, table.element_count);
 
+    memory_free(memory, memory_size, MEMORY_TAG_DICT);
     return true;
 }
 
@@ -278,7 +305,9 @@ u8 hashtable_should_set_get_and_update_ptr_successfully() {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct*);
     u64 element_count = 3;
-    ht_test_struct* memory[3];
+    u64 memory_size =
+        hashtable_get_memory_requirement(element_size, element_count);
+    void* memory = memory_allocate(memory_size, MEMORY_TAG_DICT);
 
     hashtable_create(element_size, element_count, memory, true, &table);
 
@@ -316,6 +345,187 @@ u8 hashtable_should_set_get_and_update_ptr_successfully() {
     expect_should_be(0, table.element_size);
     expect_should_be(0, table.element_count);
 
+    memory_free(memory, memory_size, MEMORY_TAG_DICT);
+    return true;
+}
+
+u8 hashtable_should_keep_colliding_keys_apart() {
+    hashtable table;
+    u64 element_size = sizeof(u64);
+    u32 element_count = 64;
+    u64 memory_size =
+        hashtable_get_memory_requirement(element_size, element_count);
+    void* memory = memory_allocate(memory_size, MEMORY_TAG_DICT);
+
+    hashtable_create(element_size, element_count, memory, false, &table);
+
+    // More keys than a direct-mapped table of this size could hold apart.
+    char name[16];
+    for (u64 i = 0; i < 48; ++i) {
+        string_format(name, "texture_%llu", i);
+        expect_to_be_true(hashtable_set(&table, name, &i));
+    }
+    expect_should_be(48, table.count);
+
+    for (u64 i = 0; i < 48; ++i) {
+        u64 value = 0;
+        string_format(name, "texture_%llu", i);
+        expect_to_be_true(hashtable_get(&table, name, &value));
+        expect_should_be(i, value);
+    }
+
+    hashtable_stats stats;
+    hashtable_get_stats(&table, &stats);
+    expect_should_be(48, stats.count);
+    expect_should_be(64, stats.capacity);
+    expect_float_to_be(0.75f, stats.load_factor);
+
+    hashtable_destroy(&table);
+    memory_free(memory, memory_size, MEMORY_TAG_DICT);
+    return true;
+}
+
+u8 hashtable_should_remove_and_keep_probe_chains() {
+    hashtable table;
+    u64 element_size = sizeof(u64);
+    u32 element_count = 16;
+    u64 memory_size =
+        hashtable_get_memory_requirement(element_size, element_count);
+    void* memory = memory_allocate(memory_size, MEMORY_TAG_DICT);
+
+    hashtable_create(element_size, element_count, memory, false, &table);
+
+    char name[16];
+    for (u64 i = 0; i < 16; ++i) {
+        string_format(name, "key%llu", i);
+        hashtable_set(&table, name, &i);
+    }
+
+    // Full, new keys are rejected but updates still work.
+    OKO_DEBUG("The following error message is intentional.");
+    u64 value = 99;
+    expect_to_be_false(hashtable_set(&table, "one_too_many", &value));
+    expect_to_be_true(hashtable_set(&table, "key3", &value));
+
+    // Remove every other key, the rest must stay reachable.
+    for (u64 i = 0; i < 16; i += 2) {
+        string_format(name, "key%llu", i);
+        expect_to_be_true(hashtable_remove(&table, name));
+    }
+    expect_should_be(8, table.count);
+
+    for (u64 i = 0; i < 16; ++i) {
+        string_format(name, "key%llu", i);
+        value = 0;
+        b8 found = hashtable_get(&table, name, &value);
+        if (i % 2 == 0) {
+            expect_to_be_false(found);
+        } else {
+            u64 expected = i == 3 ? 99 : i;
+            expect_to_be_true(found);
+            expect_should_be(expected, value);
+        }
+    }
+    expect_to_be_false(hashtable_remove(&table, "key0"));
+
+    hashtable_destroy(&table);
+    memory_free(memory, memory_size, MEMORY_TAG_DICT);
+    return true;
+}
+
+u8 hashtable_growable_should_rehash_incrementally() {
+    hashtable table;
+    expect_to_be_true(hashtable_create_growable(sizeof(u64), 4, false, &table));
+    expect_should_be(8, table.capacity);
+
+    char name[24];
+    u32 key_count = 5000;
+    u32 growths = 0;
+    for (u64 i = 0; i < key_count; ++i) {
+        string_format(name, "entity_%llu", i);
+        u32 capacity = table.capacity;
+        expect_to_be_true(hashtable_set(&table, name, &i));
+        if (table.capacity != capacity) {
+            growths++;
+            // The old slots are still there, moved over by later calls.
+            expect_should_not_be(0, table.old_memory);
+        }
+
+        // Spot check keys on both sides of a rehash in progress.
+        u64 probe = i / 2;
+        u64 value = 0;
+        string_format(name, "entity_%llu", probe);
+        expect_to_be_true(hashtable_get(&table, name, &value));
+        expect_should_be(probe, value);
+    }
+    expect_should_be(key_count, table.count);
+    expect_should_be(10, growths);
+
+    // Updating and removing also work while the table grows.
+    for (u64 i = 0; i < key_count; i += 2) {
+        string_format(name, "entity_%llu", i);
+        expect_to_be_true(hashtable_remove(&table, name));
+    }
+    u64 value = 7;
+    expect_to_be_true(hashtable_set(&table, "entity_1", &value));
+    expect_should_be(key_count / 2, table.count);
+
+    for (u64 i = 0; i < key_count; ++i) {
+        string_format(name, "entity_%llu", i);
+        value = 0;
+        b8 found = hashtable_get(&table, name, &value);
+        if (i % 2 == 0) {
+            expect_to_be_false(found);
+        } else {
+            u64 expected = i == 1 ? 7 : i;
+            expect_to_be_true(found);
+            expect_should_be(expected, value);
+        }
+    }
+
+    hashtable_stats stats;
+    hashtable_get_stats(&table, &stats);
+    expect_should_be(key_count / 2, stats.count);
+    expect_to_be_true(stats.load_factor <= 0.75f);
+
+    hashtable_destroy(&table);
+    expect_should_be(0, table.memory);
+    expect_should_be(0, table.old_memory);
+    return true;
+}
+
+u8 hashtable_growable_should_reserve_and_hold_pointers() {
+    hashtable table;
+    expect_to_be_true(
+        hashtable_create_growable(sizeof(ht_test_struct*), 0, true, &table)
+    );
+    expect_to_be_true(hashtable_reserve(&table, 1000));
+    expect_should_be(2048, table.capacity);
+    expect_should_be(0, table.old_memory);
+
+    ht_test_struct values[1000];
+    char name[24];
+    for (u32 i = 0; i < 1000; ++i) {
+        values[i].u_value = i;
+        ht_test_struct* value = &values[i];
+        string_format(name, "material_%u", i);
+        expect_to_be_true(hashtable_set_ptr(&table, name, (void**)&value));
+    }
+    // Reserved up front, so nothing had to grow.
+    expect_should_be(2048, table.capacity);
+
+    for (u32 i = 0; i < 1000; ++i) {
+        ht_test_struct* value = 0;
+        string_format(name, "material_%u", i);
+        expect_to_be_true(hashtable_get_ptr(&table, name, (void**)&value));
+        expect_should_be(&values[i], value);
+    }
+
+    // Unsetting a pointer removes it, as with fixed tables.
+    expect_to_be_true(hashtable_set_ptr(&table, "material_10", 0));
+    expect_should_be(999, table.count);
+
+    hashtable_destroy(&table);
     return true;
 }
 
@@ -356,4 +566,20 @@ void hashtable_register_tests() {
         hashtable_should_set_get_and_update_ptr_successfully,
         "Hashtable Should get pointer, update, and get again successfully."
     );
+    test_manager_register_test(
+        hashtable_should_keep_colliding_keys_apart,
+        "Hashtable should keep colliding keys apart"
+    );
+    test_manager_register_test(
+        hashtable_should_remove_and_keep_probe_chains,
+        "Hashtable should remove entries and keep probe chains intact"
+    );
+    test_manager_register_test(
+        hashtable_growable_should_rehash_incrementally,
+        "Growable hashtable should rehash incrementally"
+    );
+    test_manager_register_test(
+        hashtable_growable_should_reserve_and_hold_pointers,
+        "Growable hashtable should reserve and hold pointers"
+    );
 }
\ No newline at end of file
@@ -0,0 +1,252 @@
+#include "ring_queue_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/ring_queue.h>
+#include <core/clock.h>
+#include <core/log.h>
+#include <platform/thread.h>
+
+#define STRESS_ITEMS      400000
+#define BENCH_ITEMS       400000
+#define BENCH_MAX_THREADS 16
+#define BENCH_BATCH       32
+
+u8 ring_queue_should_keep_fifo_order_single_threaded() {
+    ring_queue queue;
+    expect_to_be_true(ring_queue_create(
+        sizeof(u32), 6, RING_QUEUE_MODE_SINGLE_THREADED, 0, &queue
+    ));
+    expect_should_be(8, queue.capacity);
+
+    u32 value = 0;
+    expect_to_be_false(ring_queue_dequeue(&queue, &value));
+
+    // Go around the ring a few times so batches wrap.
+    u32 next_in = 0;
+    u32 next_out = 0;
+    for (u32 round = 0; round < 10; ++round) {
+        u32 values[5];
+        for (u32 i = 0; i < 5; ++i) {
+            values[i] = next_in + i;
+        }
+        expect_should_be(5, ring_queue_enqueue_batch(&queue, values, 5));
+        next_in += 5;
+
+        u32 out[5] = {0};
+        expect_should_be(5, ring_queue_dequeue_batch(&queue, out, 5));
+        for (u32 i = 0; i < 5; ++i) {
+            expect_should_be(next_out + i, out[i]);
+        }
+        next_out += 5;
+    }
+
+    // A batch larger than the free space is cut short.
+    u32 many[10] = {0};
+    expect_should_be(8, ring_queue_enqueue_batch(&queue, many, 10));
+    expect_should_be(8, ring_queue_count(&queue));
+    expect_to_be_false(ring_queue_enqueue(&queue, &value));
+    expect_should_be(8, ring_queue_dequeue_batch(&queue, many, 10));
+    expect_should_be(0, ring_queue_count(&queue));
+
+    ring_queue_destroy(&queue);
+    expect_should_be(0, queue.memory);
+    return true;
+}
+
+typedef struct queue_worker {
+    ring_queue* queue;
+    u32 item_count;
+    u32 first_item;
+    u32 batch;
+    // Filled in by consumers.
+    u64 sum;
+    u32 received;
+    u32 out_of_order;
+} queue_worker;
+
+static u32 produce(void* params) {
+    queue_worker* worker = params;
+    u32 values[BENCH_BATCH];
+    u32 sent = 0;
+    while (sent < worker->item_count) {
+        u32 count = worker->item_count - sent;
+        if (count > worker->batch) {
+            count = worker->batch;
+        }
+        for (u32 i = 0; i < count; ++i) {
+            values[i] = worker->first_item + sent + i;
+        }
+        u32 done = 0;
+        while (done < count) {
+            u32 taken = ring_queue_enqueue_batch(
+                worker->queue, values + done, count - done
+            );
+            if (!taken) {
+                thread_yield();
+            }
+            done += taken;
+        }
+        sent += count;
+    }
+    return 0;
+}
+
+static u32 consume(void* params) {
+    queue_worker* worker = params;
+    u32 values[BENCH_BATCH];
+    u32 last = 0;
+    while (worker->received < worker->item_count) {
+        u32 wanted = worker->item_count - worker->received;
+        if (wanted > worker->batch) {
+            wanted = worker->batch;
+        }
+        u32 taken = ring_queue_dequeue_batch(worker->queue, values, wanted);
+        if (!taken) {
+            thread_yield();
+        }
+        for (u32 i = 0; i < taken; ++i) {
+            // Only meaningful with a single producer.
+            if (values[i] < last) {
+                worker->out_of_order++;
+            }
+            last = values[i];
+            worker->sum += values[i];
+        }
+        worker->received += taken;
+    }
+    return 0;
+}
+
+// Runs thread_count producers and as many consumers over one queue and
+// returns the elapsed seconds. Items are 1..total, split evenly.
+static f64 run_queue(
+    ring_queue* queue,
+    u32 thread_count,
+    u32 total,
+    u32 batch,
+    queue_worker* out_consumers
+) {
+    queue_worker producers[BENCH_MAX_THREADS];
+    thread threads[BENCH_MAX_THREADS * 2];
+    u32 per_thread = total / thread_count;
+
+    clock timer;
+    clock_start(&timer);
+    for (u32 i = 0; i < thread_count; ++i) {
+        producers[i] = (queue_worker){0};
+        producers[i].queue = queue;
+        producers[i].item_count = per_thread;
+        producers[i].first_item = 1 + i * per_thread;
+        producers[i].batch = batch;
+        out_consumers[i] = (queue_worker){0};
+        out_consumers[i].queue = queue;
+        out_consumers[i].item_count = per_thread;
+        out_consumers[i].batch = batch;
+        thread_create(consume, &out_consumers[i], &threads[i * 2]);
+        thread_create(produce, &producers[i], &threads[i * 2 + 1]);
+    }
+    for (u32 i = 0; i < thread_count * 2; ++i) {
+        thread_wait(&threads[i]);
+    }
+    clock_update(&timer);
+    return timer.elapsed;
+}
+
+static u64 expected_sum(u32 total) {
+    return (u64)total * (total + 1) / 2;
+}
+
+u8 ring_queue_spsc_should_deliver_in_order() {
+    ring_queue queue;
+    expect_to_be_true(
+        ring_queue_create(sizeof(u32), 1024, RING_QUEUE_MODE_SPSC, 0, &queue)
+    );
+
+    queue_worker consumer;
+    run_queue(&queue, 1, STRESS_ITEMS, 7, &consumer);
+    expect_should_be(STRESS_ITEMS, consumer.received);
+    expect_should_be(0, consumer.out_of_order);
+    expect_should_be(expected_sum(STRESS_ITEMS), consumer.sum);
+    expect_should_be(0, ring_queue_count(&queue));
+
+    ring_queue_destroy(&queue);
+    return true;
+}
+
+u8 ring_queue_mpmc_should_deliver_every_item_once() {
+    ring_queue queue;
+    expect_to_be_true(
+        ring_queue_create(sizeof(u32), 256, RING_QUEUE_MODE_MPMC, 0, &queue)
+    );
+
+    queue_worker consumers[4];
+    run_queue(&queue, 4, STRESS_ITEMS, 5, consumers);
+    u64 sum = 0;
+    u32 received = 0;
+    for (u32 i = 0; i < 4; ++i) {
+        sum += consumers[i].sum;
+        received += consumers[i].received;
+    }
+    expect_should_be(STRESS_ITEMS, received);
+    expect_should_be(expected_sum(STRESS_ITEMS), sum);
+    expect_should_be(0, ring_queue_count(&queue));
+
+    ring_queue_destroy(&queue);
+    return true;
+}
+
+u8 ring_queue_throughput_benchmark() {
+    queue_worker consumers[BENCH_MAX_THREADS];
+
+    ring_queue queue;
+    ring_queue_create(sizeof(u32), 4096, RING_QUEUE_MODE_SPSC, 0, &queue);
+    f64 single = run_queue(&queue, 1, BENCH_ITEMS, 1, consumers);
+    f64 batched = run_queue(&queue, 1, BENCH_ITEMS, BENCH_BATCH, consumers);
+    ring_queue_destroy(&queue);
+    OKO_INFO(
+        "SPSC queue: %.1f Mitems/s, batched %.1f Mitems/s.",
+        BENCH_ITEMS / single / 1000000.0,
+        BENCH_ITEMS / batched / 1000000.0
+    );
+
+    for (u32 threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2) {
+        ring_queue_create(sizeof(u32), 4096, RING_QUEUE_MODE_MPMC, 0, &queue);
+        single = run_queue(&queue, threads, BENCH_ITEMS, 1, consumers);
+        batched = run_queue(&queue, threads, BENCH_ITEMS, BENCH_BATCH, consumers);
+        u64 sum = 0;
+        for (u32 i = 0; i < threads; ++i) {
+            sum += consumers[i].sum;
+        }
+        expect_should_be(expected_sum(BENCH_ITEMS), sum);
+        ring_queue_destroy(&queue);
+
+        OKO_INFO(
+            "MPMC queue, %2u producers/consumers: %.1f Mitems/s, batched %.1f Mitems/s.",
+            threads,
+            BENCH_ITEMS / single / 1000000.0,
+            BENCH_ITEMS / batched / 1000000.0
+        );
+    }
+    return true;
+}
+
+void ring_queue_register_tests() {
+    test_manager_register_test(
+        ring_queue_should_keep_fifo_order_single_threaded,
+        "Ring queue should keep FIFO order single threaded"
+    );
+    test_manager_register_test(
+        ring_queue_spsc_should_deliver_in_order,
+        "SPSC ring queue should deliver in order"
+    );
+    test_manager_register_test(
+        ring_queue_mpmc_should_deliver_every_item_once,
+        "MPMC ring queue should deliver every item once"
+    );
+    test_manager_register_test(
+        ring_queue_throughput_benchmark, "Ring queue throughput benchmark"
+    );
+}
\ No newline at end of file
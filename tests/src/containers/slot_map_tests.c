@@ -0,0 +1,142 @@
+#include "slot_map_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/slot_map.h>
+#include <core/log.h>
+#include <core/memory.h>
+
+u8 slot_map_should_insert_get_and_remove() {
+    slot_map map;
+    expect_to_be_true(slot_map_create(sizeof(u64), 4, 0, &map));
+
+    slot_handle handles[4];
+    for (u64 i = 0; i < 4; ++i) {
+        u64 value = i * 10;
+        handles[i] = slot_map_insert(&map, &value);
+        expect_should_not_be(INVALID_ID, handles[i]);
+    }
+    expect_should_be(0, handles[0]);
+    expect_should_be(4, map.count);
+
+    OKO_DEBUG("The following warning message is intentional.");
+    u64 value = 99;
+    expect_should_be(INVALID_ID, slot_map_insert(&map, &value));
+
+    u64* element = slot_map_get(&map, handles[2]);
+    expect_should_not_be(0, element);
+    expect_should_be(20, *element);
+
+    expect_to_be_true(slot_map_remove(&map, handles[1]));
+    expect_to_be_false(slot_map_remove(&map, handles[1]));
+    expect_to_be_false(slot_map_is_valid(&map, handles[1]));
+    expect_should_be(0, slot_map_get(&map, handles[1]));
+    expect_should_be(3, map.count);
+
+    // The slot comes back under a new generation, the old handle stays stale.
+    slot_handle reused = slot_map_insert(&map, 0);
+    expect_should_be(
+        slot_handle_index(handles[1]), slot_handle_index(reused)
+    );
+    expect_should_not_be(handles[1], reused);
+    expect_to_be_false(slot_map_is_valid(&map, handles[1]));
+    element = slot_map_get(&map, reused);
+    expect_should_be(0, *element);
+
+    // Everything else is still where it was.
+    for (u64 i = 0; i < 4; i += 2) {
+        element = slot_map_get(&map, handles[i]);
+        expect_should_be(i * 10, *element);
+    }
+    expect_to_be_false(slot_map_is_valid(&map, INVALID_ID));
+
+    slot_map_destroy(&map);
+    expect_should_be(0, map.slots);
+    return true;
+}
+
+u8 slot_map_should_keep_elements_packed() {
+    u32 capacity = 100;
+    u64 size = slot_map_get_memory_requirement(sizeof(u32), capacity);
+    void* memory = memory_allocate(size, MEMORY_TAG_ARRAY);
+    slot_map map;
+    expect_to_be_true(slot_map_create(sizeof(u32), capacity, memory, &map));
+
+    slot_handle handles[100];
+    for (u32 i = 0; i < capacity; ++i) {
+        handles[i] = slot_map_insert(&map, &i);
+    }
+    for (u32 i = 0; i < capacity; i += 2) {
+        expect_to_be_true(slot_map_remove(&map, handles[i]));
+    }
+    expect_should_be(50, map.count);
+
+    // The front of the element array holds exactly the odd values, and each
+    // dense position maps back to a handle that finds it.
+    u32* elements = slot_map_elements(&map);
+    u32 sum = 0;
+    for (u32 i = 0; i < map.count; ++i) {
+        expect_should_be(1, elements[i] % 2);
+        sum += elements[i];
+        slot_handle handle = slot_map_handle_at(&map, i);
+        expect_should_be(handles[elements[i]], handle);
+        expect_should_be(&elements[i], slot_map_get(&map, handle));
+    }
+    expect_should_be(2500, sum);
+    expect_should_be(INVALID_ID, slot_map_handle_at(&map, map.count));
+
+    slot_map_destroy(&map);
+    memory_free(memory, size, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 slot_map_should_reuse_oldest_slots_first() {
+    slot_map map;
+    expect_to_be_true(slot_map_create(0, 8, 0, &map));
+
+    slot_handle handles[8];
+    for (u32 i = 0; i < 8; ++i) {
+        handles[i] = slot_map_insert(&map, 0);
+        expect_should_be(i, handles[i]);
+    }
+
+    // Freed in the order 5, 2, 7: handed back in that order.
+    expect_to_be_true(slot_map_remove(&map, handles[5]));
+    expect_to_be_true(slot_map_remove(&map, handles[2]));
+    expect_to_be_true(slot_map_remove(&map, handles[7]));
+    expect_should_be(5, slot_handle_index(slot_map_insert(&map, 0)));
+    expect_should_be(2, slot_handle_index(slot_map_insert(&map, 0)));
+    expect_should_be(7, slot_handle_index(slot_map_insert(&map, 0)));
+
+    // Churning one slot runs through every generation before one repeats.
+    slot_handle first = slot_map_handle_at(&map, 0);
+    slot_handle handle = first;
+    for (u32 i = 0; i < SLOT_MAP_GENERATION_MAX; ++i) {
+        expect_to_be_true(slot_map_remove(&map, handle));
+        handle = slot_map_insert(&map, 0);
+        expect_should_not_be(first, handle);
+        expect_to_be_false(slot_map_is_valid(&map, first));
+    }
+    expect_to_be_true(slot_map_remove(&map, handle));
+    expect_should_be(first, slot_map_insert(&map, 0));
+
+    slot_map_destroy(&map);
+    return true;
+}
+
+void slot_map_register_tests() {
+    test_manager_register_test(
+        slot_map_should_insert_get_and_remove,
+        "Slot map should insert, get and remove"
+    );
+    test_manager_register_test(
+        slot_map_should_keep_elements_packed,
+        "Slot map should keep elements packed"
+    );
+    test_manager_register_test(
+        slot_map_should_reuse_oldest_slots_first,
+        "Slot map should reuse oldest slots first"
+    );
+}
\ No newline at end of file
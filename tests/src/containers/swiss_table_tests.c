@@ -0,0 +1,248 @@
+#include "swiss_table_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/swiss_table.h>
+#include <containers/hashtable.h>
+#include <containers/string.h>
+#include <core/clock.h>
+#include <core/log.h>
+#include <core/memory.h>
+
+#define NAME_STRIDE      32
+#define BENCH_MAX_COUNT  1000000
+#define BENCH_LOOKUPS    1000000
+// Prime, so stepping by it visits every key in a scattered order.
+#define BENCH_STEP       7919
+
+typedef struct st_test_struct {
+    b8 b_value;
+    f32 f_value;
+    u64 u_value;
+} st_test_struct;
+
+u8 swiss_table_should_set_get_and_update() {
+    swiss_table table;
+    expect_to_be_true(swiss_table_create(sizeof(u64), 3, false, &table));
+    expect_should_be(16, table.capacity);
+
+    u64 value = 23;
+    expect_to_be_true(swiss_table_set(&table, "test1", &value));
+    u64 out_value = 0;
+    expect_to_be_true(swiss_table_get(&table, "test1", &out_value));
+    expect_should_be(23, out_value);
+
+    value = 42;
+    expect_to_be_true(swiss_table_set(&table, "test1", &value));
+    expect_to_be_true(swiss_table_get(&table, "test1", &out_value));
+    expect_should_be(42, out_value);
+    expect_should_be(1, table.count);
+
+    // Misses leave the output alone.
+    out_value = 0;
+    expect_to_be_false(swiss_table_get(&table, "test2", &out_value));
+    expect_should_be(0, out_value);
+
+    u64 hash = hashtable_hash_name("test1");
+    expect_to_be_true(swiss_table_get_hashed(&table, "test1", hash, &out_value));
+    expect_should_be(42, out_value);
+
+    swiss_table_destroy(&table);
+    expect_should_be(0, table.memory);
+    expect_should_be(0, table.capacity);
+    return true;
+}
+
+u8 swiss_table_should_set_and_unset_ptr() {
+    swiss_table table;
+    expect_to_be_true(
+        swiss_table_create(sizeof(st_test_struct*), 0, true, &table)
+    );
+
+    st_test_struct t;
+    t.u_value = 63;
+    st_test_struct* value = &t;
+    expect_to_be_true(swiss_table_set_ptr(&table, "test1", (void**)&value));
+
+    st_test_struct* out_value = 0;
+    expect_to_be_true(swiss_table_get_ptr(&table, "test1", (void**)&out_value));
+    expect_should_be(63, out_value->u_value);
+
+    expect_to_be_true(swiss_table_set_ptr(&table, "test1", 0));
+    expect_to_be_false(
+        swiss_table_get_ptr(&table, "test1", (void**)&out_value)
+    );
+    expect_should_be(0, out_value);
+    expect_should_be(0, table.count);
+
+    OKO_DEBUG("The following error message is intentional.");
+    u64 plain = 1;
+    expect_to_be_false(swiss_table_set(&table, "test2", &plain));
+
+    swiss_table_destroy(&table);
+    return true;
+}
+
+u8 swiss_table_should_grow_and_survive_churn() {
+    swiss_table table;
+    expect_to_be_true(swiss_table_create(sizeof(u64), 0, false, &table));
+
+    char name[NAME_STRIDE];
+    for (u64 i = 0; i < 20000; ++i) {
+        string_format(name, "entity_%llu", i);
+        expect_to_be_true(swiss_table_set(&table, name, &i));
+    }
+    expect_should_be(20000, table.count);
+    expect_should_be(32768, table.capacity);
+
+    for (u64 i = 0; i < 20000; ++i) {
+        u64 value = 0;
+        string_format(name, "entity_%llu", i);
+        expect_to_be_true(swiss_table_get(&table, name, &value));
+        expect_should_be(i, value);
+    }
+
+    // Remove and add keys over and over: deleted markers get cleaned up
+    // without the table growing.
+    for (u64 i = 0; i < 200000; ++i) {
+        string_format(name, "entity_%llu", i);
+        expect_to_be_true(swiss_table_remove(&table, name));
+        u64 next = i + 20000;
+        string_format(name, "entity_%llu", next);
+        expect_to_be_true(swiss_table_set(&table, name, &next));
+    }
+    expect_should_be(20000, table.count);
+    expect_should_be(32768, table.capacity);
+
+    for (u64 i = 200000; i < 220000; ++i) {
+        u64 value = 0;
+        string_format(name, "entity_%llu", i);
+        expect_to_be_true(swiss_table_get(&table, name, &value));
+        expect_should_be(i, value);
+    }
+    string_format(name, "entity_%llu", (u64)5);
+    expect_to_be_false(swiss_table_remove(&table, name));
+
+    swiss_table_stats stats;
+    swiss_table_get_stats(&table, &stats);
+    expect_should_be(20000, stats.count);
+    expect_to_be_true(stats.average_probe_length < 1.0f);
+
+    // Reserving up front moves everything once.
+    expect_to_be_true(swiss_table_reserve(&table, 100000));
+    expect_should_be(131072, table.capacity);
+    u64 value = 0;
+    expect_to_be_true(swiss_table_get(&table, "entity_210000", &value));
+    expect_should_be(210000, value);
+
+    swiss_table_destroy(&table);
+    return true;
+}
+
+static char* create_names(u32 count, const char* prefix) {
+    char* names = memory_allocate(count * NAME_STRIDE, MEMORY_TAG_GAME);
+    for (u32 i = 0; i < count; ++i) {
+        string_format(names + i * NAME_STRIDE, "%s/mesh_%u", prefix, i);
+    }
+    return names;
+}
+
+// Nanoseconds per lookup over BENCH_LOOKUPS scattered names. The found count
+// is checked by the caller, which also keeps the lookups from being dropped.
+static f64 time_hashtable(
+    hashtable* table, const char* names, u32 count, u64* out_found
+) {
+    u64 found = 0;
+    u32 index = 0;
+    clock timer;
+    clock_start(&timer);
+    for (u32 i = 0; i < BENCH_LOOKUPS; ++i) {
+        u64 value;
+        found += hashtable_get(table, names + index * NAME_STRIDE, &value);
+        index = (index + BENCH_STEP) % count;
+    }
+    clock_update(&timer);
+    *out_found = found;
+    return timer.elapsed * 1e9 / BENCH_LOOKUPS;
+}
+
+static f64 time_swiss_table(
+    swiss_table* table, const char* names, u32 count, u64* out_found
+) {
+    u64 found = 0;
+    u32 index = 0;
+    clock timer;
+    clock_start(&timer);
+    for (u32 i = 0; i < BENCH_LOOKUPS; ++i) {
+        u64 value;
+        found += swiss_table_get(table, names + index * NAME_STRIDE, &value);
+        index = (index + BENCH_STEP) % count;
+    }
+    clock_update(&timer);
+    *out_found = found;
+    return timer.elapsed * 1e9 / BENCH_LOOKUPS;
+}
+
+u8 swiss_table_lookup_benchmark() {
+    char* hits = create_names(BENCH_MAX_COUNT, "assets/models");
+    char* misses = create_names(BENCH_MAX_COUNT, "assets/missing");
+
+    for (u32 count = 10000; count <= BENCH_MAX_COUNT; count *= 10) {
+        hashtable table;
+        swiss_table swiss;
+        hashtable_create_growable(sizeof(u64), count, false, &table);
+        swiss_table_create(sizeof(u64), count, false, &swiss);
+        for (u64 i = 0; i < count; ++i) {
+            hashtable_set(&table, hits + i * NAME_STRIDE, &i);
+            swiss_table_set(&swiss, hits + i * NAME_STRIDE, &i);
+        }
+        expect_should_be(count, table.count);
+        expect_should_be(count, swiss.count);
+
+        u64 found[4];
+        f64 table_hit = time_hashtable(&table, hits, count, &found[0]);
+        f64 table_miss = time_hashtable(&table, misses, count, &found[1]);
+        f64 swiss_hit = time_swiss_table(&swiss, hits, count, &found[2]);
+        f64 swiss_miss = time_swiss_table(&swiss, misses, count, &found[3]);
+        expect_should_be(BENCH_LOOKUPS, found[0]);
+        expect_should_be(0, found[1]);
+        expect_should_be(BENCH_LOOKUPS, found[2]);
+        expect_should_be(0, found[3]);
+        OKO_INFO(
+            "%7u entries: hashtable hit %.1f ns miss %.1f ns, swiss table hit %.1f ns miss %.1f ns.",
+            count,
+            table_hit,
+            table_miss,
+            swiss_hit,
+            swiss_miss
+        );
+
+        hashtable_destroy(&table);
+        swiss_table_destroy(&swiss);
+    }
+
+    memory_free(hits, BENCH_MAX_COUNT * NAME_STRIDE, MEMORY_TAG_GAME);
+    memory_free(misses, BENCH_MAX_COUNT * NAME_STRIDE, MEMORY_TAG_GAME);
+    return true;
+}
+
+void swiss_table_register_tests() {
+    test_manager_register_test(
+        swiss_table_should_set_get_and_update,
+        "Swiss table should set, get and update"
+    );
+    test_manager_register_test(
+        swiss_table_should_set_and_unset_ptr,
+        "Swiss table should set and unset pointer entry"
+    );
+    test_manager_register_test(
+        swiss_table_should_grow_and_survive_churn,
+        "Swiss table should grow and survive churn"
+    );
+    test_manager_register_test(
+        swiss_table_lookup_benchmark,
+        "Swiss table lookup benchmark against hashtable"
+    );
+}
\ No newline at end of file
@@ -0,0 +1,3 @@
+#pragma once
+
+void swiss_table_register_tests();
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "hash_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <core/hash.h>
+#include <core/clock.h>
+#include <core/log.h>
+#include <core/memory.h>
+#include <containers/hashtable.h>
+#include <containers/string.h>
+
+#define NAME_COUNT 100000
+#define NAME_STRIDE 48
+#define BUCKET_COUNT 4096
+
+// The hash the hashtable used before, kept to compare against.
+static u64 legacy_hash(const char* name) {
+    u64 hash = 0;
+    for (const u8* us = (const u8*)name; *us; us++) {
+        hash = hash * 97 + *us;
+    }
+    return hash;
+}
+
+// Names shaped like the asset paths the engine hashes.
+static char* create_names() {
+    char* names = memory_allocate(NAME_COUNT * NAME_STRIDE, MEMORY_TAG_GAME);
+    for (u32 i = 0; i < NAME_COUNT; ++i) {
+        string_format(
+            names + i * NAME_STRIDE,
+            "assets/textures/level_%u/material_%u",
+            i / 100,
+            i
+        );
+    }
+    return names;
+}
+
+// Keys that land in an already used bucket when key_count names are spread
+// over BUCKET_COUNT buckets by the hash's low bits.
+static u32 count_collisions(
+    const char* names, u32 key_count, u64 (*hash)(const char*)
+) {
+    u8 used[BUCKET_COUNT] = {0};
+    u32 collisions = 0;
+    for (u32 i = 0; i < key_count; ++i) {
+        u32 bucket = (u32)hash(names + i * NAME_STRIDE) & (BUCKET_COUNT - 1);
+        if (used[bucket]) {
+            collisions++;
+        }
+        used[bucket] = 1;
+    }
+    return collisions;
+}
+
+static f64 measure_throughput(const char* names, u64 (*hash)(const char*)) {
+    u64 bytes = 0;
+    u64 sink = 0;
+    clock timer;
+    clock_start(&timer);
+    for (u32 i = 0; i < NAME_COUNT; ++i) {
+        const char* name = names + i * NAME_STRIDE;
+        sink ^= hash(name);
+        bytes += string_length(name);
+    }
+    clock_update(&timer);
+    // Keeps the loop from being optimized away.
+    if (sink == 0) {
+        OKO_TRACE("hash sink was 0");
+    }
+    return bytes / timer.elapsed / (1024.0 * 1024.0);
+}
+
+u8 hash_should_match_reference_vectors() {
+    // wyhash reference outputs, seeded with their index.
+    const char* inputs[] = {
+        "",
+        "a",
+        "abc",
+        "message digest",
+        "abcdefghijklmnopqrstuvwxyz",
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",
+        "123456789012345678901234567890123456789012345678901234567890123456789"
+        "01234567890",
+    };
+    const u64 expected[] = {
+        0x93228a4de0eec5a2ULL,
+        0xc5bac3db178713c4ULL,
+        0xa97f2f7b1d9b3314ULL,
+        0x786d1f1df3801df4ULL,
+        0xdca5a8138ad37c87ULL,
+        0xb9e734f117cfaf70ULL,
+        0x6cc5eab49a92d617ULL,
+    };
+    for (u32 i = 0; i < 7; ++i) {
+        u64 hash = hash_bytes(inputs[i], string_length(inputs[i]), i);
+        expect_should_be(expected[i], hash);
+    }
+
+    expect_should_be(hash_bytes("texture", 7, 0), hash_string("texture"));
+    expect_should_not_be(hash_string("texture"), hash_string("textures"));
+    return true;
+}
+
+u8 hash_should_spread_names_better_than_legacy() {
+    char* names = create_names();
+
+    // Three quarters full, the same load the texture table runs at.
+    u32 key_count = BUCKET_COUNT * 3 / 4;
+    u32 legacy = count_collisions(names, key_count, legacy_hash);
+    u32 current = count_collisions(names, key_count, hash_string);
+
+    // Expected collisions for an ideal random hash.
+    f64 empty = 1.0;
+    for (u32 i = 0; i < key_count; ++i) {
+        empty *= 1.0 - 1.0 / BUCKET_COUNT;
+    }
+    f64 ideal = key_count - BUCKET_COUNT * (1.0 - empty);
+
+    f64 legacy_speed = measure_throughput(names, legacy_hash);
+    f64 current_speed = measure_throughput(names, hash_string);
+
+    OKO_INFO(
+        "Hash collisions at %u keys: legacy %u, wyhash %u, ideal %.0f.",
+        key_count,
+        legacy,
+        current,
+        ideal
+    );
+    OKO_INFO(
+        "Hash throughput: legacy %.0f MB/s, wyhash %.0f MB/s.",
+        legacy_speed,
+        current_speed
+    );
+
+    expect_to_be_true(current <= legacy);
+    expect_to_be_true(current < ideal * 1.2);
+
+    memory_free(names, NAME_COUNT * NAME_STRIDE, MEMORY_TAG_GAME);
+    return true;
+}
+
+u8 hash_should_reuse_precomputed_hash_in_hashtable() {
+    hashtable table;
+    u64 element_size = sizeof(u64);
+    u32 element_count = 100;
+    u64 memory_size =
+        hashtable_get_memory_requirement(element_size, element_count);
+    void* memory = memory_allocate(memory_size, MEMORY_TAG_DICT);
+
+    hashtable_create(element_size, element_count, memory, false, &table);
+    expect_should_be(128, table.capacity);
+
+    u64 hash = hashtable_hash_name("texture");
+    u64 value = 42;
+    expect_to_be_true(hashtable_set_hashed(&table, "texture", hash, &value));
+
+    // Both paths agree on where the key lives.
+    u64 out_value = 0;
+    expect_to_be_true(hashtable_get(&table, "texture", &out_value));
+    expect_should_be(42, out_value);
+
+    value = 7;
+    expect_to_be_true(hashtable_set(&table, "texture", &value));
+    expect_to_be_true(
+        hashtable_get_hashed(&table, "texture", hash, &out_value)
+    );
+    expect_should_be(7, out_value);
+    expect_should_be(1, table.count);
+
+    hashtable_destroy(&table);
+    memory_free(memory, memory_size, MEMORY_TAG_DICT);
+    return true;
+}
+
+void hash_register_tests() {
+    test_manager_register_test(
+        hash_should_match_reference_vectors,
+        "Hash should match the reference vectors"
+    );
+    test_manager_register_test(
+        hash_should_spread_names_better_than_legacy,
+        "Hash should spread names close to ideal"
+    );
+    test_manager_register_test(
+        hash_should_reuse_precomputed_hash_in_hashtable,
+        "Hashtable should accept a precomputed hash"
+    );
+}
@@ -0,0 +1,117 @@
+#include "log_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <core/log.h>
+#include <core/memory.h>
+#include <containers/string.h>
+#include <platform/filesystem.h>
+#include <platform/thread.h>
+
+#define LOGGING_THREADS    4
+#define ENTRIES_PER_THREAD 25
+#define LONG_ENTRY_LENGTH  3000
+
+static b8 start_log(void** out_state, u64* out_requirement) {
+    log_system_initialize(out_requirement, 0);
+    *out_state = memory_allocate_aligned(
+        *out_requirement, OKO_CACHE_LINE_SIZE, MEMORY_TAG_APPLICATION
+    );
+    return log_system_initialize(out_requirement, *out_state);
+}
+
+static void stop_log(void* state, u64 requirement) {
+    log_system_shutdown(state);
+    memory_free_aligned(
+        state, requirement, OKO_CACHE_LINE_SIZE, MEMORY_TAG_APPLICATION
+    );
+}
+
+// Occurrences of text in console.log.
+static u32 count_in_log_file(const char* text) {
+    file_handle file;
+    if (!filesystem_open("console.log", FILE_MODE_READ, true, &file)) {
+        return 0;
+    }
+    u8* bytes;
+    u64 size;
+    filesystem_read_all_bytes(&file, &bytes, &size);
+    filesystem_close(&file);
+
+    u64 length = string_length(text);
+    u32 count = 0;
+    for (u64 i = 0; i + length <= size; ++i) {
+        u64 j = 0;
+        while (j < length && bytes[i + j] == (u8)text[j]) {
+            j++;
+        }
+        count += j == length;
+    }
+    memory_free(bytes, size, MEMORY_TAG_STRING);
+    return count;
+}
+
+static u32 log_entries(void* params) {
+    u32 id = (u32)(u64)params;
+    for (u32 i = 0; i < ENTRIES_PER_THREAD; ++i) {
+        OKO_INFO("queued entry %u from thread %u", i, id);
+    }
+    return 0;
+}
+
+u8 log_should_write_entries_from_every_thread() {
+    void* state;
+    u64 requirement;
+    expect_to_be_true(start_log(&state, &requirement));
+
+    thread threads[LOGGING_THREADS];
+    for (u32 i = 0; i < LOGGING_THREADS; ++i) {
+        expect_to_be_true(
+            thread_create(log_entries, (void*)(u64)i, &threads[i])
+        );
+    }
+    for (u32 i = 0; i < LOGGING_THREADS; ++i) {
+        thread_wait(&threads[i]);
+    }
+    log_flush();
+    expect_should_be(
+        LOGGING_THREADS * ENTRIES_PER_THREAD, count_in_log_file("queued entry")
+    );
+
+    stop_log(state, requirement);
+    return true;
+}
+
+u8 log_should_keep_long_entries_in_order() {
+    void* state;
+    u64 requirement;
+    expect_to_be_true(start_log(&state, &requirement));
+
+    // Longer than a queued entry, so written on this thread.
+    static char long_text[LONG_ENTRY_LENGTH + 1];
+    for (u32 i = 0; i < LONG_ENTRY_LENGTH; ++i) {
+        long_text[i] = 'a' + i % 26;
+    }
+    OKO_INFO("short entry before");
+    OKO_INFO("long entry %s", long_text);
+    OKO_INFO("short entry after");
+    stop_log(state, requirement);
+
+    // Whole, and between the two short ones.
+    expect_should_be(1, count_in_log_file("before\n[INFO]long entry abcdef"));
+    expect_should_be(1, count_in_log_file("hij\n[INFO]short entry after"));
+    return true;
+}
+
+void log_register_tests() {
+    test_manager_register_test(
+        log_should_write_entries_from_every_thread,
+        "Log should write entries from every thread"
+    );
+    test_manager_register_test(
+        log_should_keep_long_entries_in_order,
+        "Log should keep long entries in order"
+    );
+}
\ No newline at end of file
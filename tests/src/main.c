@@ -1,7 +1,22 @@
 #include "test_manager.h"
 
 #include "memory/linear_allocator_tests.h"
+#include "memory/dynamic_allocator_tests.h"
+#include "memory/pool_allocator_tests.h"
+#include "memory/frame_allocator_tests.h"
+#include "memory/memory_system_tests.h"
+#include "containers/darray_tests.h"
 #include "containers/hashtable_tests.h"
+#include "containers/ring_queue_tests.h"
+#include "containers/btree_tests.h"
+#include "containers/slot_map_tests.h"
+#include "containers/bitset_tests.h"
+#include "containers/swiss_table_tests.h"
+#include "core/hash_tests.h"
+#include "core/log_tests.h"
+#include "platform/thread_tests.h"
+#include "systems/job_system_tests.h"
+#include "systems/parallel_for_tests.h"
 
 #include <core/log.h>
 
@@ -10,7 +25,22 @@ int main() {
 
     // add test registrations here.
     linear_allocator_register_tests();
+    dynamic_allocator_register_tests();
+    pool_allocator_register_tests();
+    frame_allocator_register_tests();
+    memory_system_register_tests();
+    darray_register_tests();
     hashtable_register_tests();
+    swiss_table_register_tests();
+    ring_queue_register_tests();
+    btree_register_tests();
+    slot_map_register_tests();
+    bitset_register_tests();
+    hash_register_tests();
+    log_register_tests();
+    thread_register_tests();
+    job_system_register_tests();
+    parallel_for_register_tests();
 
     OKO_DEBUG("Starting tests...");
 
@@ -0,0 +1,232 @@
+#include "dynamic_allocator_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <memory/dynamic_allocator.h>
+
+u8 dynamic_allocator_should_create_and_destroy() {
+    dynamic_allocator alloc;
+    b8 result = dynamic_allocator_create(1024, 0, &alloc);
+
+    expect_to_be_true(result);
+    expect_should_not_be(0, alloc.memory);
+    expect_should_be(1024, alloc.total_size);
+    expect_should_be(0, alloc.allocated);
+    expect_should_be(1, alloc.free_block_count);
+
+    dynamic_allocator_destroy(&alloc);
+
+    expect_should_be(0, alloc.memory);
+    expect_should_be(0, alloc.total_size);
+
+    return true;
+}
+
+u8 dynamic_allocator_single_allocation_and_free() {
+    dynamic_allocator alloc;
+    dynamic_allocator_create(1024, 0, &alloc);
+    u64 free_space = dynamic_allocator_free_space(&alloc);
+
+    void* block = dynamic_allocator_allocate(&alloc, 64);
+    expect_should_not_be(0, block);
+    expect_should_be(0, ((u64)block) % 16);
+    expect_should_be(1, alloc.allocation_count);
+    expect_to_be_true(dynamic_allocator_owns(&alloc, block));
+
+    expect_to_be_true(dynamic_allocator_free(&alloc, block));
+    expect_should_be(0, alloc.allocation_count);
+    expect_should_be(0, alloc.allocated);
+    expect_should_be(free_space, dynamic_allocator_free_space(&alloc));
+
+    dynamic_allocator_destroy(&alloc);
+
+    return true;
+}
+
+u8 dynamic_allocator_should_coalesce_freed_blocks() {
+    dynamic_allocator alloc;
+    dynamic_allocator_create(4096, 0, &alloc);
+    u64 free_space = dynamic_allocator_free_space(&alloc);
+
+    void* blocks[4];
+    for (u32 i = 0; i < 4; ++i) {
+        blocks[i] = dynamic_allocator_allocate(&alloc, 100);
+        expect_should_not_be(0, blocks[i]);
+    }
+
+    // Free out of order, leaving holes first, then filling them.
+    dynamic_allocator_free(&alloc, blocks[0]);
+    dynamic_allocator_free(&alloc, blocks[2]);
+    expect_should_be(3, alloc.free_block_count);
+
+    dynamic_allocator_free(&alloc, blocks[1]);
+    expect_should_be(2, alloc.free_block_count);
+
+    dynamic_allocator_free(&alloc, blocks[3]);
+    expect_should_be(1, alloc.free_block_count);
+    expect_should_be(free_space, dynamic_allocator_free_space(&alloc));
+    expect_should_be(
+        free_space, dynamic_allocator_largest_free_block(&alloc)
+    );
+
+    dynamic_allocator_destroy(&alloc);
+
+    return true;
+}
+
+u8 dynamic_allocator_should_reuse_lowest_hole() {
+    dynamic_allocator alloc;
+    dynamic_allocator_create(4096, 0, &alloc);
+
+    void* a = dynamic_allocator_allocate(&alloc, 64);
+    void* b = dynamic_allocator_allocate(&alloc, 64);
+    void* c = dynamic_allocator_allocate(&alloc, 64);
+    expect_should_not_be(0, c);
+
+    dynamic_allocator_free(&alloc, a);
+
+    // First fit on an address-ordered list hands back the lowest hole.
+    void* d = dynamic_allocator_allocate(&alloc, 32);
+    expect_should_be(a, d);
+
+    dynamic_allocator_free(&alloc, b);
+    dynamic_allocator_free(&alloc, c);
+    dynamic_allocator_free(&alloc, d);
+    expect_should_be(1, alloc.free_block_count);
+
+    dynamic_allocator_destroy(&alloc);
+
+    return true;
+}
+
+u8 dynamic_allocator_aligned_allocations() {
+    dynamic_allocator alloc;
+    dynamic_allocator_create(8192, 0, &alloc);
+
+    u16 alignments[4] = {16, 32, 64, 256};
+    void* blocks[4];
+    for (u32 i = 0; i < 4; ++i) {
+        // Offset the next allocation so alignment actually has to be fixed up.
+        void* spacer = dynamic_allocator_allocate(&alloc, 8);
+        blocks[i] =
+            dynamic_allocator_allocate_aligned(&alloc, 40, alignments[i]);
+        expect_should_not_be(0, blocks[i]);
+        expect_should_be(0, ((u64)blocks[i]) % alignments[i]);
+        dynamic_allocator_free(&alloc, spacer);
+    }
+
+    for (u32 i = 0; i < 4; ++i) {
+        expect_to_be_true(dynamic_allocator_free(&alloc, blocks[i]));
+    }
+    expect_should_be(0, alloc.allocated);
+    expect_should_be(1, alloc.free_block_count);
+
+    dynamic_allocator_destroy(&alloc);
+
+    return true;
+}
+
+u8 dynamic_allocator_try_over_allocate() {
+    dynamic_allocator alloc;
+    dynamic_allocator_create(1024, 0, &alloc);
+
+    OKO_DEBUG("Note: The following error is intentionally caused by this test."
+    );
+
+    void* block = dynamic_allocator_allocate(&alloc, 2048);
+    expect_should_be(0, block);
+    expect_should_be(0, alloc.allocated);
+
+    dynamic_allocator_destroy(&alloc);
+
+    return true;
+}
+
+u8 dynamic_allocator_try_double_free() {
+    dynamic_allocator alloc;
+    dynamic_allocator_create(1024, 0, &alloc);
+
+    void* block = dynamic_allocator_allocate(&alloc, 64);
+    expect_to_be_true(dynamic_allocator_free(&alloc, block));
+
+    OKO_DEBUG("Note: The following error is intentionally caused by this test."
+    );
+
+    expect_to_be_false(dynamic_allocator_free(&alloc, block));
+    expect_should_be(0, alloc.allocated);
+
+    dynamic_allocator_destroy(&alloc);
+
+    return true;
+}
+
+u8 dynamic_allocator_resize_in_place() {
+    dynamic_allocator alloc;
+    dynamic_allocator_create(4096, 0, &alloc);
+    u64 free_space = dynamic_allocator_free_space(&alloc);
+
+    u8* block = dynamic_allocator_allocate(&alloc, 64);
+    block[63] = 7;
+
+    // Grows into the free space that follows.
+    expect_to_be_true(dynamic_allocator_resize(&alloc, block, 1024));
+    expect_should_be(7, block[63]);
+    expect_should_be(1, alloc.allocation_count);
+    expect_should_be(1, alloc.free_block_count);
+
+    // Shrinking hands the tail back and it merges with the free block.
+    expect_to_be_true(dynamic_allocator_resize(&alloc, block, 32));
+    expect_should_be(1, alloc.free_block_count);
+
+    u8* next = dynamic_allocator_allocate(&alloc, 64);
+    expect_should_be(block + 64, next);
+
+    // Blocked by next, the caller has to move the block.
+    expect_to_be_false(dynamic_allocator_resize(&alloc, block, 256));
+
+    dynamic_allocator_free(&alloc, next);
+    dynamic_allocator_free(&alloc, block);
+    expect_should_be(0, alloc.allocated);
+    expect_should_be(free_space, dynamic_allocator_free_space(&alloc));
+
+    dynamic_allocator_destroy(&alloc);
+
+    return true;
+}
+
+void dynamic_allocator_register_tests() {
+    test_manager_register_test(
+        dynamic_allocator_should_create_and_destroy,
+        "Dynamic allocator should create and destroy"
+    );
+    test_manager_register_test(
+        dynamic_allocator_single_allocation_and_free,
+        "Dynamic allocator single alloc and free"
+    );
+    test_manager_register_test(
+        dynamic_allocator_should_coalesce_freed_blocks,
+        "Dynamic allocator should coalesce freed neighbours"
+    );
+    test_manager_register_test(
+        dynamic_allocator_should_reuse_lowest_hole,
+        "Dynamic allocator should reuse the lowest free block"
+    );
+    test_manager_register_test(
+        dynamic_allocator_aligned_allocations,
+        "Dynamic allocator aligned allocations"
+    );
+    test_manager_register_test(
+        dynamic_allocator_try_over_allocate,
+        "Dynamic allocator try over allocate"
+    );
+    test_manager_register_test(
+        dynamic_allocator_try_double_free,
+        "Dynamic allocator try double free"
+    );
+    test_manager_register_test(
+        dynamic_allocator_resize_in_place,
+        "Dynamic allocator resizes blocks in place"
+    );
+}
\ No newline at end of file
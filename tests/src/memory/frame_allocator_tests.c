@@ -0,0 +1,155 @@
+#include "frame_allocator_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/memory.h>
+#include <memory/frame_allocator.h>
+
+#define ARENA_SIZE (1024 * 1024)
+
+static void* start_frame_allocator(u64* out_requirement) {
+    frame_allocator_config config = {.arena_size = ARENA_SIZE};
+    frame_allocator_system_initialize(out_requirement, 0, config);
+    void* state = memory_allocate(*out_requirement, MEMORY_TAG_APPLICATION);
+    if (!frame_allocator_system_initialize(out_requirement, state, config)) {
+        memory_free(state, *out_requirement, MEMORY_TAG_APPLICATION);
+        return 0;
+    }
+    return state;
+}
+
+static void stop_frame_allocator(void* state, u64 requirement) {
+    frame_allocator_system_shutdown(state);
+    memory_free(state, requirement, MEMORY_TAG_APPLICATION);
+}
+
+u8 frame_allocator_begin_frame_flips_arenas() {
+    u64 requirement;
+    void* state = start_frame_allocator(&requirement);
+    expect_should_not_be(0, state);
+
+    u8* first = frame_allocator_allocate(64);
+    expect_should_not_be(0, first);
+    expect_should_be(64, frame_allocator_get_frame_usage());
+
+    // A new frame starts empty in the other arena.
+    frame_allocator_begin_frame();
+    expect_should_be(0, frame_allocator_get_frame_usage());
+    u8* second = frame_allocator_allocate(64);
+    expect_should_not_be(0, second);
+    b8 other_arena = second < first || second >= first + ARENA_SIZE;
+    expect_to_be_true(other_arena);
+
+    // Two frames later the first arena is handed out from the start again.
+    frame_allocator_begin_frame();
+    expect_should_be(first, frame_allocator_allocate(64));
+    frame_allocator_begin_frame();
+    expect_should_be(second, frame_allocator_allocate(64));
+
+    stop_frame_allocator(state, requirement);
+    return true;
+}
+
+u8 frame_allocator_keeps_blocks_aligned() {
+    u64 requirement;
+    void* state = start_frame_allocator(&requirement);
+    expect_should_not_be(0, state);
+
+    // An odd size first, the next block still starts aligned.
+    u8* odd = frame_allocator_allocate(3);
+    expect_should_not_be(0, odd);
+    u8* next = frame_allocator_allocate(sizeof(f32) * 16);
+    expect_should_be(0, (u64)next % FRAME_ALLOCATOR_DEFAULT_ALIGNMENT);
+    expect_to_be_true(next >= odd + 3);
+
+    frame_allocator_allocate(3);
+    u8* line = frame_allocator_allocate_aligned(64, OKO_CACHE_LINE_SIZE);
+    expect_should_be(0, (u64)line % OKO_CACHE_LINE_SIZE);
+
+    stop_frame_allocator(state, requirement);
+    return true;
+}
+
+u8 frame_allocator_previous_frame_stays_valid() {
+    u64 requirement;
+    void* state = start_frame_allocator(&requirement);
+    expect_should_not_be(0, state);
+
+    u32* previous = frame_allocator_allocate(sizeof(u32) * 16);
+    for (u32 i = 0; i < 16; ++i) {
+        previous[i] = i * 3;
+    }
+
+    // Writing a whole frame's worth leaves last frame's data alone.
+    frame_allocator_begin_frame();
+    u32* current = frame_allocator_allocate(sizeof(u32) * 16);
+    for (u32 i = 0; i < 16; ++i) {
+        current[i] = 0xFFFFFFFF;
+    }
+    for (u32 i = 0; i < 16; ++i) {
+        expect_should_be(i * 3, previous[i]);
+    }
+
+    // One frame later its memory is reused.
+    frame_allocator_begin_frame();
+    u32* reused = frame_allocator_allocate(sizeof(u32) * 16);
+    expect_should_be(previous, reused);
+    for (u32 i = 0; i < 16; ++i) {
+        expect_should_be(0xFFFFFFFF, current[i]);
+    }
+
+    stop_frame_allocator(state, requirement);
+    return true;
+}
+
+u8 frame_allocator_tracks_usage_peak() {
+    u64 requirement;
+    void* state = start_frame_allocator(&requirement);
+    expect_should_not_be(0, state);
+
+    frame_allocator_allocate(100);
+    frame_allocator_begin_frame();
+    expect_should_be(100, frame_allocator_get_last_frame_usage());
+    expect_should_be(100, frame_allocator_get_high_water_mark());
+
+    frame_allocator_allocate(300);
+    frame_allocator_begin_frame();
+    expect_should_be(300, frame_allocator_get_last_frame_usage());
+    expect_should_be(300, frame_allocator_get_high_water_mark());
+
+    // A smaller frame keeps the peak.
+    frame_allocator_allocate(50);
+    frame_allocator_begin_frame();
+    expect_should_be(50, frame_allocator_get_last_frame_usage());
+    expect_should_be(300, frame_allocator_get_high_water_mark());
+
+    // The frame in progress counts as soon as it passes the peak.
+    frame_allocator_allocate(500);
+    expect_should_be(500, frame_allocator_get_frame_usage());
+    expect_should_be(500, frame_allocator_get_high_water_mark());
+
+    stop_frame_allocator(state, requirement);
+    return true;
+}
+
+void frame_allocator_register_tests() {
+    test_manager_register_test(
+        frame_allocator_begin_frame_flips_arenas,
+        "Frame allocator begin_frame flips arenas"
+    );
+    test_manager_register_test(
+        frame_allocator_keeps_blocks_aligned,
+        "Frame allocator keeps blocks aligned after odd sizes"
+    );
+    test_manager_register_test(
+        frame_allocator_previous_frame_stays_valid,
+        "Frame allocator keeps the previous frame valid for one frame"
+    );
+    test_manager_register_test(
+        frame_allocator_tracks_usage_peak,
+        "Frame allocator tracks the peak frame usage"
+    );
+}
\ No newline at end of file
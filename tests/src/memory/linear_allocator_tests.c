@@ -4,6 +4,7 @@
 
 #include <defines.h>
 
+#include <core/memory.h>
 #include <memory/linear_allocator.h>
 
 u8 linear_allocator_should_create_and_destroy() {
@@ -109,6 +110,173 @@ u8 linear_allocator_multi_allocation_all_space_then_free() {
     return true;
 }
 
+u8 linear_allocator_aligned_allocations() {
+    linear_allocator alloc;
+    linear_allocator_create(1024, 0, &alloc);
+
+    // Knock the offset off any natural alignment first.
+    void* block = linear_allocator_allocate(&alloc, 3);
+    expect_should_not_be(0, block);
+    expect_should_be(3, alloc.allocated);
+
+    u16 alignments[4] = {8, 16, 32, 64};
+    for (u32 i = 0; i < 4; ++i) {
+        block = linear_allocator_allocate_aligned(&alloc, 5, alignments[i]);
+        expect_should_not_be(0, block);
+        expect_should_be(0, ((u64)block) % alignments[i]);
+    }
+
+    OKO_DEBUG("Note: The following error is intentionally caused by this test."
+    );
+
+    // Not a power of 2.
+    u64 allocated = alloc.allocated;
+    block = linear_allocator_allocate_aligned(&alloc, 8, 24);
+    expect_should_be(0, block);
+    expect_should_be(allocated, alloc.allocated);
+
+    linear_allocator_destroy(&alloc);
+
+    return true;
+}
+
+u8 linear_allocator_markers_rewind_nested_scopes() {
+    linear_allocator alloc;
+    linear_allocator_create(sizeof(u64) * 16, 0, &alloc);
+
+    linear_allocator_allocate(&alloc, sizeof(u64));
+    linear_allocator_marker outer = linear_allocator_get_marker(&alloc);
+    expect_should_be(sizeof(u64), outer);
+
+    linear_allocator_allocate(&alloc, sizeof(u64) * 2);
+    linear_allocator_marker inner = linear_allocator_get_marker(&alloc);
+    void* inner_block = linear_allocator_allocate(&alloc, sizeof(u64) * 4);
+    expect_should_be(sizeof(u64) * 7, alloc.allocated);
+
+    // Rewinding the inner scope hands the same memory out again.
+    linear_allocator_free_to_marker(&alloc, inner);
+    expect_should_be(sizeof(u64) * 3, alloc.allocated);
+    void* block = linear_allocator_allocate(&alloc, sizeof(u64));
+    expect_should_be(inner_block, block);
+
+    linear_allocator_free_to_marker(&alloc, outer);
+    expect_should_be(sizeof(u64), alloc.allocated);
+
+    OKO_DEBUG("Note: The following error is intentionally caused by this test."
+    );
+
+    // Restoring a marker that is already released is refused.
+    linear_allocator_free_to_marker(&alloc, inner);
+    expect_should_be(sizeof(u64), alloc.allocated);
+
+    linear_allocator_destroy(&alloc);
+
+    return true;
+}
+
+u8 linear_allocator_reset_keeps_data() {
+    linear_allocator alloc;
+    linear_allocator_create(sizeof(u64) * 4, 0, &alloc);
+
+    u64* block = linear_allocator_allocate(&alloc, sizeof(u64));
+    *block = 42;
+
+    linear_allocator_reset(&alloc);
+    expect_should_be(0, alloc.allocated);
+
+    // Same memory, stale data still present.
+    u64* reused = linear_allocator_allocate(&alloc, sizeof(u64));
+    expect_should_be(block, reused);
+    expect_should_be(42, *reused);
+
+    linear_allocator_free_all(&alloc);
+    expect_should_be(0, alloc.dirty);
+    reused = linear_allocator_allocate(&alloc, sizeof(u64));
+    expect_should_be(0, *reused);
+
+    linear_allocator_destroy(&alloc);
+
+    return true;
+}
+
+u8 linear_allocator_free_all_clears_provided_memory() {
+    u64 memory[4] = {1, 2, 3, 4};
+    linear_allocator alloc;
+    linear_allocator_create(sizeof(memory), memory, &alloc);
+
+    // Memory handed in is not known to be clean.
+    expect_should_be(sizeof(memory), alloc.dirty);
+
+    linear_allocator_free_all(&alloc);
+    for (u32 i = 0; i < 4; ++i) {
+        expect_should_be(0, memory[i]);
+    }
+
+    linear_allocator_destroy(&alloc);
+
+    return true;
+}
+
+u8 linear_allocator_reserved_commits_on_demand() {
+    u64 reserve_size = 256 * 1024 * 1024;
+    linear_allocator alloc;
+    b8 result = linear_allocator_create_reserved(reserve_size, &alloc);
+
+    expect_to_be_true(result);
+    expect_should_not_be(0, alloc.memory);
+    expect_should_be(reserve_size, alloc.total_size);
+    expect_should_be(0, alloc.committed);
+
+    u8* first = linear_allocator_allocate(&alloc, 16);
+    expect_should_not_be(0, first);
+    expect_should_be(LINEAR_ALLOCATOR_COMMIT_SIZE, alloc.committed);
+    expect_should_be(0, first[0]);
+
+    // Crossing the committed range grows in place.
+    u64 big = LINEAR_ALLOCATOR_COMMIT_SIZE * 3;
+    u8* second = linear_allocator_allocate(&alloc, big);
+    expect_should_be(first + 16, second);
+    expect_should_be(LINEAR_ALLOCATOR_COMMIT_SIZE * 4, alloc.committed);
+    second[big - 1] = 1;
+    expect_should_be(1, second[big - 1]);
+
+    // Committed pages are kept across resets.
+    linear_allocator_free_all(&alloc);
+    expect_should_be(0, second[big - 1]);
+    expect_should_be(LINEAR_ALLOCATOR_COMMIT_SIZE * 4, alloc.committed);
+
+    linear_allocator_destroy(&alloc);
+
+    expect_should_be(0, alloc.memory);
+    expect_should_be(0, alloc.committed);
+
+    return true;
+}
+
+u8 linear_allocator_reserved_huge_commits_whole_pages() {
+    u64 huge_page_size = memory_get_huge_page_size();
+    linear_allocator alloc;
+    // Rounded up to a whole huge page.
+    b8 result = linear_allocator_create_reserved_huge(
+        huge_page_size * 2 + 1, "test arena", &alloc
+    );
+
+    expect_to_be_true(result);
+    expect_should_be(huge_page_size * 3, alloc.total_size);
+
+    u8* block = linear_allocator_allocate(&alloc, 16);
+    expect_should_not_be(0, block);
+    expect_should_be(huge_page_size, alloc.committed);
+
+    linear_allocator_allocate(&alloc, huge_page_size);
+    expect_should_be(huge_page_size * 2, alloc.committed);
+
+    linear_allocator_destroy(&alloc);
+    expect_should_be(0, alloc.memory);
+
+    return true;
+}
+
 void linear_allocator_register_tests() {
     test_manager_register_test(
         linear_allocator_should_create_and_destroy,
@@ -130,4 +298,28 @@ void linear_allocator_register_tests() {
         linear_allocator_multi_allocation_all_space_then_free,
         "Linear allocator allocated should be 0 after free_all"
     );
+    test_manager_register_test(
+        linear_allocator_aligned_allocations,
+        "Linear allocator aligned allocations"
+    );
+    test_manager_register_test(
+        linear_allocator_markers_rewind_nested_scopes,
+        "Linear allocator markers rewind nested scopes"
+    );
+    test_manager_register_test(
+        linear_allocator_reset_keeps_data,
+        "Linear allocator reset keeps stale data"
+    );
+    test_manager_register_test(
+        linear_allocator_free_all_clears_provided_memory,
+        "Linear allocator free_all zeroes provided memory"
+    );
+    test_manager_register_test(
+        linear_allocator_reserved_commits_on_demand,
+        "Linear allocator reserved commits pages on demand"
+    );
+    test_manager_register_test(
+        linear_allocator_reserved_huge_commits_whole_pages,
+        "Linear allocator huge page arena commits whole huge pages"
+    );
 }
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "memory_system_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <core/clock.h>
+#include <core/log.h>
+#include <core/memory.h>
+#include <platform/thread.h>
+
+#define STRESS_THREAD_COUNT 4
+#define STRESS_OPERATIONS   200000
+#define STRESS_LIVE_BLOCKS  256
+
+static void* memory_state;
+static u64 memory_state_size;
+
+static b8 start_memory_system(u64 total_alloc_size) {
+    memory_system_config config = {0};
+    config.total_alloc_size = total_alloc_size;
+    memory_system_initialize(&memory_state_size, 0, config);
+    // Before initialize the memory system falls through to the platform.
+    memory_state = memory_allocate(memory_state_size, MEMORY_TAG_APPLICATION);
+    return memory_system_initialize(&memory_state_size, memory_state, config);
+}
+
+static void stop_memory_system() {
+    memory_system_shutdown(memory_state);
+    memory_free(memory_state, memory_state_size, MEMORY_TAG_APPLICATION);
+    memory_state = 0;
+}
+
+u8 memory_system_small_blocks_are_reused() {
+    expect_to_be_true(start_memory_system(16 * 1024 * 1024));
+
+    u8* first = memory_allocate(24, MEMORY_TAG_GAME);
+    expect_should_not_be(0, first);
+    expect_should_be(0, (u64)first % 16);
+    memory_free(first, 24, MEMORY_TAG_GAME);
+
+    // Same size class, served from the thread cache.
+    u8* second = memory_allocate(32, MEMORY_TAG_GAME);
+    expect_should_be(first, second);
+    memory_free(second, 32, MEMORY_TAG_GAME);
+
+    expect_should_be(2, memory_get_alloc_count());
+
+    stop_memory_system();
+    return true;
+}
+
+u8 memory_system_small_free_ignores_a_wrong_size() {
+    expect_to_be_true(start_memory_system(16 * 1024 * 1024));
+
+    u8* block = memory_allocate(16, MEMORY_TAG_GAME);
+    expect_should_not_be(0, block);
+#if OKO_MEMORY_PROFILING
+    OKO_DEBUG("Note: The following warning is intentionally caused by this test.");
+#endif
+    // Freed as the largest class, it must still go back to its own.
+    memory_free(block, 1024, MEMORY_TAG_GAME);
+
+    u8* large = memory_allocate(1024, MEMORY_TAG_GAME);
+    expect_should_not_be(block, large);
+    u8* small = memory_allocate(16, MEMORY_TAG_GAME);
+    expect_should_be(block, small);
+
+    memory_free(large, 1024, MEMORY_TAG_GAME);
+    memory_free(small, 16, MEMORY_TAG_GAME);
+
+    stop_memory_system();
+    return true;
+}
+
+u8 memory_system_aligned_allocations() {
+    expect_to_be_true(start_memory_system(16 * 1024 * 1024));
+
+    u16 alignments[4] = {16, 64, 256, 4096};
+    u8* blocks[4];
+    for (u32 i = 0; i < 4; ++i) {
+        blocks[i] =
+            memory_allocate_aligned(100, alignments[i], MEMORY_TAG_GAME);
+        expect_should_not_be(0, blocks[i]);
+        expect_should_be(0, (u64)blocks[i] % alignments[i]);
+        for (u32 j = 0; j < 100; ++j) {
+            expect_should_be(0, blocks[i][j]);
+        }
+        memory_set(blocks[i], 0xFF, 100);
+    }
+    expect_should_be(400, memory_get_allocated(MEMORY_TAG_GAME));
+
+    for (u32 i = 0; i < 4; ++i) {
+        memory_free_aligned(blocks[i], 100, alignments[i], MEMORY_TAG_GAME);
+    }
+    expect_should_be(0, memory_get_allocated(MEMORY_TAG_GAME));
+
+    // Reused memory comes back zeroed.
+    u8* block = memory_allocate_aligned(100, 64, MEMORY_TAG_GAME);
+    for (u32 j = 0; j < 100; ++j) {
+        expect_should_be(0, block[j]);
+    }
+    memory_free_aligned(block, 100, 64, MEMORY_TAG_GAME);
+
+    stop_memory_system();
+    return true;
+}
+
+u8 memory_system_reallocate_keeps_contents() {
+    expect_to_be_true(start_memory_system(16 * 1024 * 1024));
+
+    u8* block = memory_allocate(40, MEMORY_TAG_GAME);
+    for (u32 i = 0; i < 40; ++i) {
+        block[i] = (u8)i;
+    }
+
+    // Same size class, nothing moves.
+    u8* same = memory_reallocate(block, 40, 48, MEMORY_TAG_GAME);
+    expect_should_be(block, same);
+
+    // Out of the small blocks, into the dynamic allocator.
+    u8* moved = memory_reallocate(same, 48, 4096, MEMORY_TAG_GAME);
+    expect_should_not_be(0, moved);
+    for (u32 i = 0; i < 40; ++i) {
+        expect_should_be((u8)i, moved[i]);
+    }
+
+    // Nothing follows it, so it grows in place.
+    u8* grown = memory_reallocate(moved, 4096, 65536, MEMORY_TAG_GAME);
+    expect_should_be(moved, grown);
+    expect_should_be(39, grown[39]);
+
+    memory_free(grown, 65536, MEMORY_TAG_GAME);
+
+    stop_memory_system();
+    return true;
+}
+
+typedef struct stress_params {
+    u32 seed;
+    u32 thread_index;
+    u32 corrupted;
+    u32 allocations;
+} stress_params;
+
+// Random mix of small and large blocks. Each block is stamped with its owner
+// and slot, and checked before it is freed.
+static u32 stress_thread(void* data) {
+    stress_params* params = data;
+    u8* blocks[STRESS_LIVE_BLOCKS] = {0};
+    u64 sizes[STRESS_LIVE_BLOCKS] = {0};
+    u32 state = params->seed;
+
+    for (u32 i = 0; i < STRESS_OPERATIONS; ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        u32 slot = state % STRESS_LIVE_BLOCKS;
+        u8 stamp = (u8)(params->thread_index * 31 + slot);
+
+        if (blocks[slot]) {
+            u64 size = sizes[slot];
+            if (blocks[slot][0] != stamp || blocks[slot][size - 1] != stamp) {
+                params->corrupted++;
+            }
+            memory_free(blocks[slot], size, MEMORY_TAG_GAME);
+            blocks[slot] = 0;
+        } else {
+            // Mostly small blocks, one in eight up to 4KB.
+            u64 size = (state >> 8) % ((state & 7) ? 1024 : 4096) + 1;
+            blocks[slot] = memory_allocate_uninitialized(size, MEMORY_TAG_GAME);
+            sizes[slot] = size;
+            blocks[slot][0] = stamp;
+            blocks[slot][size - 1] = stamp;
+            params->allocations++;
+        }
+    }
+
+    for (u32 i = 0; i < STRESS_LIVE_BLOCKS; ++i) {
+        if (blocks[i]) {
+            memory_free(blocks[i], sizes[i], MEMORY_TAG_GAME);
+        }
+    }
+    return 0;
+}
+
+static f64 run_stress(u32 thread_count, u32* out_corrupted, u32* out_count) {
+    stress_params params[STRESS_THREAD_COUNT] = {0};
+    thread threads[STRESS_THREAD_COUNT];
+
+    clock timer;
+    clock_start(&timer);
+    for (u32 i = 0; i < thread_count; ++i) {
+        params[i].seed = 2463534242U + i * 7919;
+        params[i].thread_index = i;
+        thread_create(stress_thread, &params[i], &threads[i]);
+    }
+    for (u32 i = 0; i < thread_count; ++i) {
+        thread_wait(&threads[i]);
+        *out_corrupted += params[i].corrupted;
+        *out_count += params[i].allocations;
+    }
+    clock_update(&timer);
+    return timer.elapsed;
+}
+
+u8 memory_system_multithreaded_stress() {
+    expect_to_be_true(start_memory_system(256 * 1024 * 1024));
+
+    u32 corrupted = 0;
+    u32 allocations = 0;
+    f64 single = run_stress(1, &corrupted, &allocations);
+    f64 multi = run_stress(STRESS_THREAD_COUNT, &corrupted, &allocations);
+
+    expect_should_be(0, corrupted);
+    expect_should_be(allocations, memory_get_alloc_count());
+
+    OKO_INFO(
+        "Memory stress: 1 thread %.2f Mops/s, %u threads %.2f Mops/s.",
+        STRESS_OPERATIONS / single / 1000000.0,
+        STRESS_THREAD_COUNT,
+        STRESS_OPERATIONS * STRESS_THREAD_COUNT / multi / 1000000.0
+    );
+
+    stop_memory_system();
+    return true;
+}
+
+void memory_system_register_tests() {
+    test_manager_register_test(
+        memory_system_small_blocks_are_reused,
+        "Memory system reuses freed small blocks"
+    );
+    test_manager_register_test(
+        memory_system_small_free_ignores_a_wrong_size,
+        "Memory system returns small blocks to their own size class"
+    );
+    test_manager_register_test(
+        memory_system_aligned_allocations,
+        "Memory system aligned allocations are aligned, zeroed and tracked"
+    );
+    test_manager_register_test(
+        memory_system_reallocate_keeps_contents,
+        "Memory system reallocate keeps contents"
+    );
+    test_manager_register_test(
+        memory_system_multithreaded_stress,
+        "Memory system multi-threaded allocation stress"
+    );
+}
\ No newline at end of file
@@ -0,0 +1,291 @@
+#include "pool_allocator_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+
+#include <memory/pool_allocator.h>
+
+typedef struct pool_test_struct {
+    u64 id;
+    f32 value;
+} pool_test_struct;
+
+u8 pool_allocator_should_create_and_destroy() {
+    pool_allocator pool;
+    b8 result = pool_allocator_create(
+        "test", sizeof(pool_test_struct), 8, false, MEMORY_TAG_GAME, &pool
+    );
+
+    expect_to_be_true(result);
+    expect_should_not_be(0, pool.blocks);
+    expect_should_be(sizeof(pool_test_struct), pool.stride);
+    expect_should_be(8, pool_allocator_capacity(&pool));
+    expect_should_be(0, pool.allocated_count);
+
+    pool_allocator_destroy(&pool);
+
+    expect_should_be(0, pool.blocks);
+    expect_should_be(0, pool.free_list);
+    expect_should_be(0, pool_allocator_capacity(&pool));
+
+    return true;
+}
+
+u8 pool_allocator_small_elements_hold_free_link() {
+    pool_allocator pool;
+    pool_allocator_create("test", sizeof(u8), 4, false, MEMORY_TAG_GAME, &pool);
+
+    expect_should_be(sizeof(void*), pool.stride);
+
+    pool_allocator_destroy(&pool);
+
+    return true;
+}
+
+u8 pool_allocator_allocate_all_then_over_allocate() {
+    pool_allocator pool;
+    pool_allocator_create(
+        "test", sizeof(pool_test_struct), 4, false, MEMORY_TAG_GAME, &pool
+    );
+
+    pool_test_struct* elements[4];
+    for (u32 i = 0; i < 4; ++i) {
+        elements[i] = pool_allocator_allocate(&pool);
+        expect_should_not_be(0, elements[i]);
+        expect_should_be(0, elements[i]->id);
+        elements[i]->id = i;
+    }
+    expect_should_be(4, pool.allocated_count);
+
+    // Slots are packed next to each other.
+    expect_should_be(
+        sizeof(pool_test_struct), (u64)elements[1] - (u64)elements[0]
+    );
+
+    OKO_DEBUG("Note: The following error is intentionally caused by this test."
+    );
+
+    void* element = pool_allocator_allocate(&pool);
+    expect_should_be(0, element);
+    expect_should_be(4, pool.allocated_count);
+
+    for (u32 i = 0; i < 4; ++i) {
+        expect_should_be(i, elements[i]->id);
+        pool_allocator_free(&pool, elements[i]);
+    }
+    expect_should_be(0, pool.allocated_count);
+    expect_should_be(4, pool.peak_count);
+
+    pool_allocator_destroy(&pool);
+
+    return true;
+}
+
+u8 pool_allocator_reuses_freed_slot() {
+    pool_allocator pool;
+    pool_allocator_create(
+        "test", sizeof(pool_test_struct), 4, false, MEMORY_TAG_GAME, &pool
+    );
+
+    pool_test_struct* a = pool_allocator_allocate(&pool);
+    pool_test_struct* b = pool_allocator_allocate(&pool);
+    a->id = 99;
+
+    pool_allocator_free(&pool, a);
+    pool_test_struct* c = pool_allocator_allocate(&pool);
+
+    // Last freed is first reused, and comes back zeroed.
+    expect_should_be(a, c);
+    expect_should_be(0, c->id);
+
+    pool_allocator_free(&pool, b);
+    pool_allocator_free(&pool, c);
+    pool_allocator_destroy(&pool);
+
+    return true;
+}
+
+u8 pool_allocator_rejects_foreign_elements() {
+    pool_allocator pool;
+    pool_allocator_create(
+        "test", sizeof(pool_test_struct), 4, false, MEMORY_TAG_GAME, &pool
+    );
+
+    pool_test_struct* element = pool_allocator_allocate(&pool);
+    pool_test_struct outside;
+    expect_to_be_true(pool_allocator_owns(&pool, element));
+    expect_to_be_false(pool_allocator_owns(&pool, &outside));
+    expect_to_be_false(pool_allocator_owns(&pool, (u8*)element + 4));
+
+#if OKO_POOL_VALIDATION
+    OKO_DEBUG(
+        "Note: The following 2 errors are intentionally caused by this test."
+    );
+
+    pool_allocator_free(&pool, &outside);
+    pool_allocator_free(&pool, (u8*)element + 4);
+    expect_should_be(1, pool.allocated_count);
+#endif
+
+    pool_allocator_free(&pool, element);
+    expect_should_be(0, pool.allocated_count);
+
+    pool_allocator_destroy(&pool);
+
+    return true;
+}
+
+u8 pool_allocator_rejects_double_free() {
+    pool_allocator pool;
+    pool_allocator_create(
+        "test", sizeof(pool_test_struct), 4, false, MEMORY_TAG_GAME, &pool
+    );
+
+    pool_test_struct* first = pool_allocator_allocate(&pool);
+    pool_test_struct* second = pool_allocator_allocate(&pool);
+    pool_allocator_free(&pool, first);
+    expect_should_be(1, pool.allocated_count);
+
+    OKO_DEBUG("Note: The following error is intentionally caused by this test.");
+    // second is still allocated, so the count alone cannot tell.
+    void* free_list = pool.free_list;
+    pool_allocator_free(&pool, first);
+    expect_should_be(1, pool.allocated_count);
+    expect_should_be(free_list, pool.free_list);
+
+    // The slot comes back only once.
+    expect_should_be(first, pool_allocator_allocate(&pool));
+    pool_test_struct* third = pool_allocator_allocate(&pool);
+    expect_should_not_be(first, third);
+    expect_should_not_be(second, third);
+
+    pool_allocator_destroy(&pool);
+
+    return true;
+}
+
+u8 pool_allocator_frees_elements_holding_the_poison() {
+    pool_allocator pool;
+    pool_allocator_create(
+        "test", sizeof(pool_test_struct), 4, false, MEMORY_TAG_GAME, &pool
+    );
+
+    pool_test_struct* element = pool_allocator_allocate(&pool);
+    pool_test_struct* other = pool_allocator_allocate(&pool);
+    pool_allocator_free(&pool, element);
+    // The word after the link of a free slot is the poison.
+    u64 poison = ((u64*)element)[1];
+
+    expect_should_be(element, pool_allocator_allocate(&pool));
+    ((u64*)element)[1] = poison;
+    pool_allocator_free(&pool, element);
+    expect_should_be(1, pool.allocated_count);
+    expect_should_be(element, pool.free_list);
+
+    pool_allocator_free(&pool, other);
+    pool_allocator_destroy(&pool);
+
+    return true;
+}
+
+u8 pool_allocator_replace_moves_the_source() {
+    pool_allocator destination;
+    pool_allocator source;
+    pool_allocator_create(
+        "destination",
+        sizeof(pool_test_struct),
+        4,
+        false,
+        MEMORY_TAG_GAME,
+        &destination
+    );
+    pool_allocator_create(
+        "source", sizeof(pool_test_struct), 8, false, MEMORY_TAG_GAME, &source
+    );
+
+    pool_allocator_allocate(&destination);
+    pool_test_struct* element = pool_allocator_allocate(&source);
+    element->id = 42;
+    void* blocks = source.blocks;
+
+    // The destination's live element goes with its blocks.
+    pool_allocator_replace(&destination, &source);
+    expect_should_be(blocks, destination.blocks);
+    expect_should_be(1, destination.allocated_count);
+    expect_should_be(8, pool_allocator_capacity(&destination));
+    expect_to_be_true(pool_allocator_owns(&destination, element));
+    expect_should_be(42, element->id);
+    expect_should_be(0, source.blocks);
+
+    pool_allocator_free(&destination, element);
+    pool_allocator_destroy(&destination);
+
+    return true;
+}
+
+u8 pool_allocator_should_grow_by_chaining_blocks() {
+    pool_allocator pool;
+    pool_allocator_create(
+        "test", sizeof(pool_test_struct), 4, true, MEMORY_TAG_GAME, &pool
+    );
+
+    pool_test_struct* elements[10];
+    for (u32 i = 0; i < 10; ++i) {
+        elements[i] = pool_allocator_allocate(&pool);
+        expect_should_not_be(0, elements[i]);
+        elements[i]->id = i;
+    }
+    expect_should_be(3, pool.block_count);
+    expect_should_be(12, pool_allocator_capacity(&pool));
+
+    // Earlier blocks are untouched by growth.
+    for (u32 i = 0; i < 10; ++i) {
+        expect_should_be(i, elements[i]->id);
+        pool_allocator_free(&pool, elements[i]);
+    }
+    expect_should_be(0, pool.allocated_count);
+
+    pool_allocator_destroy(&pool);
+
+    return true;
+}
+
+void pool_allocator_register_tests() {
+    test_manager_register_test(
+        pool_allocator_should_create_and_destroy,
+        "Pool allocator should create and destroy"
+    );
+    test_manager_register_test(
+        pool_allocator_small_elements_hold_free_link,
+        "Pool allocator pads elements smaller than a pointer"
+    );
+    test_manager_register_test(
+        pool_allocator_allocate_all_then_over_allocate,
+        "Pool allocator alloc all slots then try over allocate"
+    );
+    test_manager_register_test(
+        pool_allocator_reuses_freed_slot,
+        "Pool allocator reuses freed slots"
+    );
+    test_manager_register_test(
+        pool_allocator_rejects_foreign_elements,
+        "Pool allocator rejects elements it does not own"
+    );
+    test_manager_register_test(
+        pool_allocator_rejects_double_free,
+        "Pool allocator rejects a double free while other elements are live"
+    );
+    test_manager_register_test(
+        pool_allocator_frees_elements_holding_the_poison,
+        "Pool allocator frees live elements that happen to hold the poison"
+    );
+    test_manager_register_test(
+        pool_allocator_replace_moves_the_source,
+        "Pool allocator replace moves the source into the destination"
+    );
+    test_manager_register_test(
+        pool_allocator_should_grow_by_chaining_blocks,
+        "Pool allocator grows by chaining blocks"
+    );
+}
\ No newline at end of file
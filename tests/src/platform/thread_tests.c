@@ -0,0 +1,248 @@
+#include "thread_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <platform/atomic.h>
+#include <platform/thread.h>
+
+#define THREAD_COUNT       4
+#define INCREMENTS         10000
+#define PRODUCED_ITEMS     1000
+
+typedef struct counter_test {
+    mutex lock;
+    u64 value;
+    atomic_u64 lock_free_value;
+} counter_test;
+
+static u32 count_up(void* params) {
+    counter_test* test = params;
+    for (u32 i = 0; i < INCREMENTS; ++i) {
+        mutex_lock(&test->lock);
+        test->value++;
+        mutex_unlock(&test->lock);
+
+        // A CAS loop rather than fetch_add, to exercise compare_exchange.
+        u64 expected =
+            atomic_u64_load(&test->lock_free_value, ATOMIC_ORDER_RELAXED);
+        while (!atomic_u64_compare_exchange(
+            &test->lock_free_value, &expected, expected + 1, ATOMIC_ORDER_RELAXED
+        )) {
+        }
+    }
+    return 0;
+}
+
+u8 mutex_should_serialize_threads() {
+    counter_test test = {0};
+    expect_to_be_true(mutex_create(&test.lock));
+
+    thread threads[THREAD_COUNT];
+    for (u32 i = 0; i < THREAD_COUNT; ++i) {
+        expect_to_be_true(thread_create(count_up, &test, &threads[i]));
+    }
+    for (u32 i = 0; i < THREAD_COUNT; ++i) {
+        thread_wait(&threads[i]);
+    }
+    expect_should_be(THREAD_COUNT * INCREMENTS, test.value);
+    expect_should_be(
+        THREAD_COUNT * INCREMENTS,
+        atomic_u64_load(&test.lock_free_value, ATOMIC_ORDER_SEQ_CST)
+    );
+
+    expect_to_be_true(mutex_try_lock(&test.lock));
+    mutex_unlock(&test.lock);
+    mutex_destroy(&test.lock);
+    expect_should_be(0, test.lock.internal_data);
+    return true;
+}
+
+typedef struct queue_test {
+    mutex lock;
+    condition_variable not_empty;
+    condition_variable not_full;
+    u32 items[8];
+    u32 count;
+    u32 read;
+    u64 consumed_sum;
+} queue_test;
+
+static u32 produce(void* params) {
+    queue_test* test = params;
+    for (u32 i = 1; i <= PRODUCED_ITEMS; ++i) {
+        mutex_lock(&test->lock);
+        while (test->count == 8) {
+            condition_variable_wait(&test->not_full, &test->lock);
+        }
+        test->items[(test->read + test->count) % 8] = i;
+        test->count++;
+        condition_variable_signal(&test->not_empty);
+        mutex_unlock(&test->lock);
+    }
+    return 0;
+}
+
+u8 condition_variable_should_hand_over_items() {
+    queue_test test = {0};
+    expect_to_be_true(mutex_create(&test.lock));
+    expect_to_be_true(condition_variable_create(&test.not_empty));
+    expect_to_be_true(condition_variable_create(&test.not_full));
+
+    thread producer;
+    expect_to_be_true(thread_create(produce, &test, &producer));
+    for (u32 i = 0; i < PRODUCED_ITEMS; ++i) {
+        mutex_lock(&test.lock);
+        while (test.count == 0) {
+            condition_variable_wait(&test.not_empty, &test.lock);
+        }
+        test.consumed_sum += test.items[test.read];
+        test.read = (test.read + 1) % 8;
+        test.count--;
+        condition_variable_broadcast(&test.not_full);
+        mutex_unlock(&test.lock);
+    }
+    thread_wait(&producer);
+    expect_should_be(PRODUCED_ITEMS * (PRODUCED_ITEMS + 1) / 2, test.consumed_sum);
+
+    condition_variable_destroy(&test.not_full);
+    condition_variable_destroy(&test.not_empty);
+    mutex_destroy(&test.lock);
+    return true;
+}
+
+typedef struct semaphore_test {
+    semaphore ready;
+    semaphore go;
+    atomic_u32 finished;
+} semaphore_test;
+
+static u32 wait_for_go(void* params) {
+    semaphore_test* test = params;
+    semaphore_signal(&test->ready, 1);
+    semaphore_wait(&test->go);
+    atomic_u32_fetch_add(&test->finished, 1, ATOMIC_ORDER_RELEASE);
+    return 0;
+}
+
+u8 semaphore_should_release_waiters() {
+    semaphore_test test = {0};
+    expect_to_be_true(semaphore_create(0, &test.ready));
+    expect_to_be_true(semaphore_create(0, &test.go));
+
+    thread threads[THREAD_COUNT];
+    for (u32 i = 0; i < THREAD_COUNT; ++i) {
+        expect_to_be_true(thread_create(wait_for_go, &test, &threads[i]));
+    }
+    for (u32 i = 0; i < THREAD_COUNT; ++i) {
+        semaphore_wait(&test.ready);
+    }
+    expect_should_be(0, atomic_u32_load(&test.finished, ATOMIC_ORDER_ACQUIRE));
+
+    semaphore_signal(&test.go, THREAD_COUNT);
+    for (u32 i = 0; i < THREAD_COUNT; ++i) {
+        thread_wait(&threads[i]);
+    }
+    expect_should_be(
+        THREAD_COUNT, atomic_u32_load(&test.finished, ATOMIC_ORDER_ACQUIRE)
+    );
+
+    semaphore_destroy(&test.go);
+    semaphore_destroy(&test.ready);
+    return true;
+}
+
+typedef struct local_test {
+    thread_local_key key;
+    u64 values[THREAD_COUNT];
+    atomic_u32 mismatches;
+} local_test;
+
+typedef struct local_params {
+    local_test* test;
+    u32 index;
+} local_params;
+
+static u32 use_local(void* params) {
+    local_params* local = params;
+    local_test* test = local->test;
+    if (thread_local_get(&test->key) != 0) {
+        atomic_u32_fetch_add(&test->mismatches, 1, ATOMIC_ORDER_RELAXED);
+    }
+    thread_local_set(&test->key, &test->values[local->index]);
+    for (u32 i = 0; i < 1000; ++i) {
+        if (thread_local_get(&test->key) != &test->values[local->index]) {
+            atomic_u32_fetch_add(&test->mismatches, 1, ATOMIC_ORDER_RELAXED);
+        }
+        thread_yield();
+    }
+    return 0;
+}
+
+u8 thread_local_should_be_per_thread() {
+    local_test test = {0};
+    expect_to_be_true(thread_local_create(&test.key));
+    expect_should_be(0, thread_local_get(&test.key));
+    expect_to_be_true(thread_local_set(&test.key, &test));
+
+    thread threads[THREAD_COUNT];
+    local_params params[THREAD_COUNT];
+    for (u32 i = 0; i < THREAD_COUNT; ++i) {
+        params[i].test = &test;
+        params[i].index = i;
+        expect_to_be_true(thread_create(use_local, &params[i], &threads[i]));
+    }
+    for (u32 i = 0; i < THREAD_COUNT; ++i) {
+        thread_wait(&threads[i]);
+    }
+    expect_should_be(0, atomic_u32_load(&test.mismatches, ATOMIC_ORDER_RELAXED));
+    expect_should_be(&test, thread_local_get(&test.key));
+
+    thread_local_destroy(&test.key);
+    return true;
+}
+
+static u32 spin_until_set(void* params) {
+    atomic_b8* stop = params;
+    while (!atomic_b8_load(stop, ATOMIC_ORDER_ACQUIRE)) {
+        thread_yield();
+    }
+    return 0;
+}
+
+u8 thread_should_accept_name_and_affinity() {
+    atomic_b8 stop = {false};
+    thread worker;
+    expect_to_be_true(thread_create(spin_until_set, &stop, &worker));
+    expect_to_be_true(thread_set_name(&worker, "a rather long test thread name"));
+    expect_to_be_true(thread_set_name(0, "test main"));
+
+    // Processor 0 always exists, and the mask is wider than the machine.
+    expect_to_be_true(thread_set_affinity(&worker, 1));
+    expect_to_be_true(thread_set_affinity(&worker, ~0ULL));
+
+    atomic_b8_store(&stop, true, ATOMIC_ORDER_RELEASE);
+    thread_wait(&worker);
+    return true;
+}
+
+void thread_register_tests() {
+    test_manager_register_test(
+        mutex_should_serialize_threads, "Mutex should serialize threads"
+    );
+    test_manager_register_test(
+        condition_variable_should_hand_over_items,
+        "Condition variable should hand over items"
+    );
+    test_manager_register_test(
+        semaphore_should_release_waiters, "Semaphore should release waiters"
+    );
+    test_manager_register_test(
+        thread_local_should_be_per_thread, "Thread local should be per thread"
+    );
+    test_manager_register_test(
+        thread_should_accept_name_and_affinity,
+        "Thread should accept name and affinity"
+    );
+}
\ No newline at end of file
@@ -0,0 +1,459 @@
+#include "job_system_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <systems/job_system.h>
+#include <core/clock.h>
+#include <core/log.h>
+#include <core/memory.h>
+#include <platform/atomic.h>
+#include <platform/thread.h>
+
+#define BENCH_JOB_COUNT    100000
+#define BENCH_BATCH_SIZE   1000
+#define BENCH_ROUND_TRIPS  1000
+#define PRIORITY_JOB_COUNT 50
+#define TREE_DEPTH         10
+#define CHAIN_DEPTH        500
+#define PIPELINE_ITEMS     64
+#define PIPELINE_STAGES    4
+
+static b8 start_fiber_system(
+    u32 worker_count,
+    u32 max_jobs,
+    u32 fiber_count,
+    u64 fiber_stack_size,
+    void** out_state
+) {
+    job_system_config config;
+    config.worker_count = worker_count;
+    config.max_jobs = max_jobs;
+    config.fiber_count = fiber_count;
+    config.fiber_stack_size = fiber_stack_size;
+    u64 requirement = 0;
+    job_system_initialize(&requirement, 0, config);
+    *out_state = memory_allocate_aligned(
+        requirement, OKO_CACHE_LINE_SIZE, MEMORY_TAG_JOB
+    );
+    return job_system_initialize(&requirement, *out_state, config);
+}
+
+static b8 start_system(u32 worker_count, u32 max_jobs, void** out_state) {
+    return start_fiber_system(worker_count, max_jobs, 0, 0, out_state);
+}
+
+static void stop_system(void* state) {
+    u64 requirement = 0;
+    job_system_config config = {0};
+    job_system_initialize(&requirement, 0, config);
+    job_system_shutdown(state);
+    memory_free_aligned(
+        state, requirement, OKO_CACHE_LINE_SIZE, MEMORY_TAG_JOB
+    );
+}
+
+static void add_one(void* params) {
+    atomic_u64_fetch_add(params, 1, ATOMIC_ORDER_RELAXED);
+}
+
+u8 job_system_should_run_all_jobs() {
+    void* state;
+    expect_to_be_true(start_system(3, 256, &state));
+    expect_should_be(3, job_system_worker_count());
+
+    // Far more jobs than fit at once: the submitter helps along.
+    atomic_u64 sum = {0};
+    job_counter counter = {0};
+    job_desc desc = {add_one, &sum, JOB_PRIORITY_NORMAL};
+    for (u32 i = 0; i < 10000; ++i) {
+        expect_to_be_true(job_system_submit(&desc, 1, &counter));
+    }
+    job_system_wait(&counter);
+    expect_should_be(0, job_counter_pending(&counter));
+    expect_should_be(10000, atomic_u64_load(&sum, ATOMIC_ORDER_RELAXED));
+
+    // Without a counter, shutdown still lets them run.
+    for (u32 i = 0; i < 100; ++i) {
+        job_system_submit(&desc, 1, 0);
+    }
+    stop_system(state);
+    expect_should_be(10100, atomic_u64_load(&sum, ATOMIC_ORDER_RELAXED));
+    return true;
+}
+
+typedef struct priority_test {
+    atomic_b8 gate_entered;
+    atomic_b8 gate_open;
+    atomic_u32 next_order;
+    u32 order[PRIORITY_JOB_COUNT * 2];
+} priority_test;
+
+typedef struct priority_job {
+    priority_test* test;
+    u32 id;
+} priority_job;
+
+static void gate_job(void* params) {
+    priority_test* test = params;
+    atomic_b8_store(&test->gate_entered, true, ATOMIC_ORDER_RELEASE);
+    while (!atomic_b8_load(&test->gate_open, ATOMIC_ORDER_ACQUIRE)) {
+        thread_yield();
+    }
+}
+
+static void record_order(void* params) {
+    priority_job* job = params;
+    u32 order =
+        atomic_u32_fetch_add(&job->test->next_order, 1, ATOMIC_ORDER_RELAXED);
+    job->test->order[order] = job->id;
+}
+
+u8 job_system_should_prefer_higher_priorities() {
+    void* state;
+    expect_to_be_true(start_system(1, 256, &state));
+
+    // Keep the only worker busy while both priorities get queued.
+    priority_test test = {0};
+    job_counter counter = {0};
+    job_desc gate = {gate_job, &test, JOB_PRIORITY_NORMAL};
+    job_system_submit(&gate, 1, &counter);
+    while (!atomic_b8_load(&test.gate_entered, ATOMIC_ORDER_ACQUIRE)) {
+        thread_yield();
+    }
+
+    priority_job jobs[PRIORITY_JOB_COUNT * 2];
+    for (u32 i = 0; i < PRIORITY_JOB_COUNT * 2; ++i) {
+        // Low ones first, ids below PRIORITY_JOB_COUNT.
+        jobs[i].test = &test;
+        jobs[i].id = i;
+        job_desc desc = {
+            record_order,
+            &jobs[i],
+            i < PRIORITY_JOB_COUNT ? JOB_PRIORITY_LOW : JOB_PRIORITY_HIGH};
+        job_system_submit(&desc, 1, &counter);
+    }
+    atomic_b8_store(&test.gate_open, true, ATOMIC_ORDER_RELEASE);
+
+    // Poll rather than wait, so only the worker runs jobs.
+    while (job_counter_pending(&counter)) {
+        thread_yield();
+    }
+    for (u32 i = 0; i < PRIORITY_JOB_COUNT * 2; ++i) {
+        expect_should_be(i < PRIORITY_JOB_COUNT, test.order[i] >= PRIORITY_JOB_COUNT);
+    }
+
+    stop_system(state);
+    return true;
+}
+
+typedef struct stage_test {
+    u32 values[64];
+    atomic_u32 checked;
+    u64 sum;
+} stage_test;
+
+typedef struct stage_job {
+    stage_test* test;
+    u32 index;
+} stage_job;
+
+static void write_value(void* params) {
+    stage_job* job = params;
+    job->test->values[job->index] = job->index;
+}
+
+static void double_value(void* params) {
+    stage_job* job = params;
+    if (job->test->values[job->index] == job->index) {
+        atomic_u32_fetch_add(&job->test->checked, 1, ATOMIC_ORDER_RELAXED);
+    }
+    job->test->values[job->index] *= 2;
+}
+
+static void sum_values(void* params) {
+    stage_test* test = params;
+    for (u32 i = 0; i < 64; ++i) {
+        test->sum += test->values[i];
+    }
+}
+
+u8 job_system_should_run_dependent_jobs() {
+    void* state;
+    expect_to_be_true(start_system(2, 256, &state));
+
+    stage_test test = {0};
+    stage_job params[64];
+    job_desc writes[64];
+    job_desc doubles[64];
+    for (u32 i = 0; i < 64; ++i) {
+        params[i].test = &test;
+        params[i].index = i;
+        writes[i] = (job_desc){write_value, &params[i], JOB_PRIORITY_NORMAL};
+        doubles[i] = (job_desc){double_value, &params[i], JOB_PRIORITY_HIGH};
+    }
+    job_desc sum = {sum_values, &test, JOB_PRIORITY_LOW};
+
+    // A closed gate keeps the first stage unfinished while the later stages
+    // are submitted, so they have to be held back.
+    priority_test gate_state = {0};
+    job_desc gate = {gate_job, &gate_state, JOB_PRIORITY_NORMAL};
+    job_counter written = {0};
+    job_counter doubled = {0};
+    job_counter summed = {0};
+    expect_to_be_true(job_system_submit(&gate, 1, &written));
+    expect_to_be_true(job_system_submit(writes, 64, &written));
+    expect_to_be_true(job_system_submit_after(&written, doubles, 64, &doubled));
+    expect_to_be_true(job_system_submit_after(&doubled, &sum, 1, &summed));
+    expect_should_be(64, job_counter_pending(&doubled));
+    expect_should_be(1, job_counter_pending(&summed));
+    expect_should_be(0, test.sum);
+
+    atomic_b8_store(&gate_state.gate_open, true, ATOMIC_ORDER_RELEASE);
+    job_system_wait(&summed);
+    expect_should_be(
+        64, atomic_u32_load(&test.checked, ATOMIC_ORDER_RELAXED)
+    );
+    expect_should_be(2 * 2016, test.sum);
+
+    // A finished dependency queues right away.
+    atomic_u64 count = {0};
+    job_counter done = {0};
+    job_desc add = {add_one, &count, JOB_PRIORITY_NORMAL};
+    expect_to_be_true(job_system_submit_after(&written, &add, 1, &done));
+    job_system_wait(&done);
+    expect_should_be(1, atomic_u64_load(&count, ATOMIC_ORDER_RELAXED));
+
+    stop_system(state);
+    return true;
+}
+
+typedef struct tree_node {
+    u32 depth;
+    atomic_u64* leaves;
+} tree_node;
+
+// Splits until depth runs out and waits for both halves, from inside a job.
+static void split_job(void* params) {
+    tree_node* node = params;
+    if (node->depth == 0) {
+        atomic_u64_fetch_add(node->leaves, 1, ATOMIC_ORDER_RELAXED);
+        return;
+    }
+    tree_node children[2] = {
+        {node->depth - 1, node->leaves}, {node->depth - 1, node->leaves}};
+    job_desc jobs[2] = {
+        {split_job, &children[0], JOB_PRIORITY_NORMAL},
+        {split_job, &children[1], JOB_PRIORITY_NORMAL}};
+    job_counter counter = {0};
+    job_system_submit(jobs, 2, &counter);
+    job_system_wait(&counter);
+}
+
+u8 job_system_should_wait_inside_jobs() {
+    void* state;
+    // Fewer workers than waiting jobs: waits must keep running other jobs.
+    expect_to_be_true(start_system(2, 64, &state));
+
+    atomic_u64 leaves = {0};
+    tree_node root = {TREE_DEPTH, &leaves};
+    job_desc desc = {split_job, &root, JOB_PRIORITY_NORMAL};
+    job_counter counter = {0};
+    job_system_submit(&desc, 1, &counter);
+    job_system_wait(&counter);
+    expect_should_be(
+        1 << TREE_DEPTH, atomic_u64_load(&leaves, ATOMIC_ORDER_RELAXED)
+    );
+
+    stop_system(state);
+    return true;
+}
+
+typedef struct chain_link {
+    u32 depth;
+    atomic_u64* finished;
+} chain_link;
+
+// Every link waits on the next one, so nested waits would need the stack to
+// hold the whole chain at once.
+static void chain_job(void* params) {
+    chain_link* link = params;
+    if (link->depth) {
+        chain_link next = {link->depth - 1, link->finished};
+        job_desc desc = {chain_job, &next, JOB_PRIORITY_NORMAL};
+        job_counter counter = {0};
+        job_system_submit(&desc, 1, &counter);
+        job_system_wait(&counter);
+    }
+    atomic_u64_fetch_add(link->finished, 1, ATOMIC_ORDER_RELAXED);
+}
+
+u8 job_system_should_park_waiting_jobs_on_fibers() {
+    void* state;
+    // A fiber per link, each with a stack far too small for the chain.
+    expect_to_be_true(
+        start_fiber_system(2, 256, CHAIN_DEPTH + 8, 16 * 1024, &state)
+    );
+
+    atomic_u64 finished = {0};
+    chain_link root = {CHAIN_DEPTH, &finished};
+    job_desc desc = {chain_job, &root, JOB_PRIORITY_NORMAL};
+    job_counter counter = {0};
+    job_system_submit(&desc, 1, &counter);
+    // Poll, waiting would run links on this thread's stack.
+    while (job_counter_pending(&counter)) {
+        thread_yield();
+    }
+    expect_should_be(
+        CHAIN_DEPTH + 1, atomic_u64_load(&finished, ATOMIC_ORDER_RELAXED)
+    );
+
+    stop_system(state);
+    return true;
+}
+
+typedef struct pipeline_item {
+    u32 stage;
+    b8 in_order;
+} pipeline_item;
+
+static void advance_stage(void* params) {
+    pipeline_item* item = params;
+    item->stage++;
+}
+
+// Load, decode, upload and bind, each started once the one before is done.
+static void pipeline_job(void* params) {
+    pipeline_item* item = params;
+    for (u32 stage = 0; stage < PIPELINE_STAGES; ++stage) {
+        if (item->stage != stage) {
+            return;
+        }
+        job_desc desc = {advance_stage, item, JOB_PRIORITY_HIGH};
+        job_counter counter = {0};
+        job_system_submit(&desc, 1, &counter);
+        job_system_wait(&counter);
+    }
+    item->in_order = true;
+}
+
+u8 job_system_should_run_pipelines_on_few_fibers() {
+    void* state;
+    // Most waits find no free fiber and run other jobs instead.
+    expect_to_be_true(start_fiber_system(3, 256, 6, 0, &state));
+
+    pipeline_item items[PIPELINE_ITEMS] = {0};
+    job_desc jobs[PIPELINE_ITEMS];
+    for (u32 i = 0; i < PIPELINE_ITEMS; ++i) {
+        jobs[i] = (job_desc){pipeline_job, &items[i], JOB_PRIORITY_NORMAL};
+    }
+    job_counter counter = {0};
+    job_system_submit(jobs, PIPELINE_ITEMS, &counter);
+    job_system_wait(&counter);
+    for (u32 i = 0; i < PIPELINE_ITEMS; ++i) {
+        expect_should_be(PIPELINE_STAGES, items[i].stage);
+        expect_to_be_true(items[i].in_order);
+    }
+
+    // The tree again, parking where a fiber is free.
+    atomic_u64 leaves = {0};
+    tree_node root = {TREE_DEPTH, &leaves};
+    job_desc desc = {split_job, &root, JOB_PRIORITY_NORMAL};
+    job_system_submit(&desc, 1, &counter);
+    job_system_wait(&counter);
+    expect_should_be(
+        1 << TREE_DEPTH, atomic_u64_load(&leaves, ATOMIC_ORDER_RELAXED)
+    );
+
+    stop_system(state);
+    return true;
+}
+
+// A few hundred nanoseconds of work, the result goes to params.
+static void busy_job(void* params) {
+    u64* result = params;
+    u64 value = (u64)result;
+    for (u32 i = 0; i < 200; ++i) {
+        value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+    *result = value;
+}
+
+static void empty_job(void* params) {
+}
+
+u8 job_system_benchmark() {
+    static job_desc batch[BENCH_BATCH_SIZE];
+    static u64 results[BENCH_JOB_COUNT];
+
+    for (u32 workers = 1; workers <= 8; workers *= 2) {
+        void* state;
+        expect_to_be_true(start_system(workers, 4096, &state));
+
+        // Throughput: batches from the main thread, which helps while waiting.
+        job_counter counter = {0};
+        clock timer;
+        clock_start(&timer);
+        for (u32 i = 0; i < BENCH_JOB_COUNT; i += BENCH_BATCH_SIZE) {
+            // Submitting copies the descriptions, so the batch can be reused.
+            for (u32 j = 0; j < BENCH_BATCH_SIZE; ++j) {
+                batch[j] = (job_desc){
+                    busy_job, &results[i + j], JOB_PRIORITY_NORMAL};
+            }
+            job_system_submit(batch, BENCH_BATCH_SIZE, &counter);
+        }
+        job_system_wait(&counter);
+        clock_update(&timer);
+        f64 jobs_per_second = BENCH_JOB_COUNT / timer.elapsed;
+
+        // Latency: one job at a time, polled so a worker has to pick it up.
+        job_desc empty = {empty_job, 0, JOB_PRIORITY_HIGH};
+        clock_start(&timer);
+        for (u32 i = 0; i < BENCH_ROUND_TRIPS; ++i) {
+            job_system_submit(&empty, 1, &counter);
+            while (job_counter_pending(&counter)) {
+                thread_yield();
+            }
+        }
+        clock_update(&timer);
+
+        OKO_INFO(
+            "%u workers: %.0f jobs/s, round trip %.1f us.",
+            workers,
+            jobs_per_second,
+            timer.elapsed * 1e6 / BENCH_ROUND_TRIPS
+        );
+        stop_system(state);
+    }
+    return true;
+}
+
+void job_system_register_tests() {
+    test_manager_register_test(
+        job_system_should_run_all_jobs, "Job system should run all jobs"
+    );
+    test_manager_register_test(
+        job_system_should_prefer_higher_priorities,
+        "Job system should prefer higher priorities"
+    );
+    test_manager_register_test(
+        job_system_should_run_dependent_jobs,
+        "Job system should run dependent jobs"
+    );
+    test_manager_register_test(
+        job_system_should_wait_inside_jobs,
+        "Job system should wait inside jobs"
+    );
+    test_manager_register_test(
+        job_system_should_park_waiting_jobs_on_fibers,
+        "Job system should park waiting jobs on fibers"
+    );
+    test_manager_register_test(
+        job_system_should_run_pipelines_on_few_fibers,
+        "Job system should run pipelines on few fibers"
+    );
+    test_manager_register_test(
+        job_system_benchmark, "Job system throughput and latency benchmark"
+    );
+}
\ No newline at end of file
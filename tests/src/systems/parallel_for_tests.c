@@ -0,0 +1,249 @@
+#include "parallel_for_tests.h"
+
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/darray.h>
+#include <core/clock.h>
+#include <core/log.h>
+#include <core/memory.h>
+#include <math/math.h>
+#include <platform/atomic.h>
+#include <platform/thread.h>
+#include <systems/job_system.h>
+#include <systems/parallel_for.h>
+
+#define VISIT_COUNT       100000
+#define VISIT_MIN_BATCH   64
+#define BENCH_MATRICES    100000
+#define BENCH_REPEATS     10
+
+static b8 start_system(u32 worker_count, void** out_state) {
+    job_system_config config = {0};
+    config.worker_count = worker_count;
+    config.max_jobs = 256;
+    u64 requirement = 0;
+    job_system_initialize(&requirement, 0, config);
+    *out_state = memory_allocate_aligned(
+        requirement, OKO_CACHE_LINE_SIZE, MEMORY_TAG_JOB
+    );
+    return job_system_initialize(&requirement, *out_state, config);
+}
+
+static void stop_system(void* state) {
+    u64 requirement = 0;
+    job_system_config config = {0};
+    job_system_initialize(&requirement, 0, config);
+    job_system_shutdown(state);
+    memory_free_aligned(
+        state, requirement, OKO_CACHE_LINE_SIZE, MEMORY_TAG_JOB
+    );
+}
+
+typedef struct visit_test {
+    u8 visits[VISIT_COUNT];
+    atomic_u32 short_ranges;
+    u64 caller_id;
+    atomic_u32 other_threads;
+} visit_test;
+
+// Slow enough per item that the loop gets split.
+static void visit_range(u64 begin, u64 end, void* user_data) {
+    visit_test* test = user_data;
+    if (end - begin < VISIT_MIN_BATCH && end != VISIT_COUNT) {
+        atomic_u32_fetch_add(&test->short_ranges, 1, ATOMIC_ORDER_RELAXED);
+    }
+    if (thread_get_current_id() != test->caller_id) {
+        atomic_u32_fetch_add(&test->other_threads, 1, ATOMIC_ORDER_RELAXED);
+    }
+    for (u64 i = begin; i < end; ++i) {
+        u64 value = i;
+        for (u32 j = 0; j < 50; ++j) {
+            value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+        }
+        // Never 0, only there so the loop above is kept.
+        test->visits[i] += value ? 1 : 2;
+    }
+}
+
+u8 parallel_for_should_visit_every_item_once() {
+    void* state;
+    expect_to_be_true(start_system(3, &state));
+
+    visit_test* test = memory_allocate(sizeof(visit_test), MEMORY_TAG_JOB);
+    test->caller_id = thread_get_current_id();
+    parallel_for(VISIT_COUNT, VISIT_MIN_BATCH, visit_range, test);
+    for (u32 i = 0; i < VISIT_COUNT; ++i) {
+        expect_should_be(1, test->visits[i]);
+    }
+    expect_should_be(
+        0, atomic_u32_load(&test->short_ranges, ATOMIC_ORDER_RELAXED)
+    );
+    OKO_DEBUG(
+        "Ranges handled by workers: %u.",
+        atomic_u32_load(&test->other_threads, ATOMIC_ORDER_RELAXED)
+    );
+
+    memory_free(test, sizeof(visit_test), MEMORY_TAG_JOB);
+    stop_system(state);
+    return true;
+}
+
+typedef struct inline_test {
+    u64 caller_id;
+    u32 calls;
+    u32 other_threads;
+    u64 sum;
+} inline_test;
+
+static void sum_range(u64 begin, u64 end, void* user_data) {
+    inline_test* test = user_data;
+    test->calls++;
+    if (thread_get_current_id() != test->caller_id) {
+        test->other_threads++;
+    }
+    for (u64 i = begin; i < end; ++i) {
+        test->sum += i;
+    }
+}
+
+u8 parallel_for_should_run_small_loops_inline() {
+    // Without a job system everything runs inline.
+    inline_test test = {0};
+    test.caller_id = thread_get_current_id();
+    parallel_for(1000, 0, sum_range, &test);
+    expect_should_be(999 * 1000 / 2, test.sum);
+    expect_should_be(0, test.other_threads);
+
+    void* state;
+    expect_to_be_true(start_system(3, &state));
+    test.sum = 0;
+    parallel_for(100, 0, sum_range, &test);
+    expect_should_be(99 * 100 / 2, test.sum);
+    expect_should_be(0, test.other_threads);
+
+    test.calls = 0;
+    parallel_for(0, 0, sum_range, &test);
+    expect_should_be(0, test.calls);
+
+    stop_system(state);
+    return true;
+}
+
+static void double_elements(
+    void* elements, u64 first, u64 count, void* user_data
+) {
+    u32* values = elements;
+    u32* array = user_data;
+    for (u64 i = 0; i < count; ++i) {
+        // Elements lines up with the index it stands for.
+        values[i] = values[i] == array[first + i] ? values[i] * 2 : 0;
+    }
+}
+
+u8 parallel_for_darray_should_pass_elements() {
+    void* state;
+    expect_to_be_true(start_system(2, &state));
+
+    u32* array = darray_reserve(u32, 5000);
+    for (u32 i = 0; i < 5000; ++i) {
+        darray_push(array, i + 1);
+    }
+    parallel_for_darray(array, 16, double_elements, array);
+    for (u32 i = 0; i < 5000; ++i) {
+        expect_should_be(2 * (i + 1), array[i]);
+    }
+    darray_destroy(array);
+
+    stop_system(state);
+    return true;
+}
+
+typedef struct transform_bench {
+    mat4* locals;
+    mat4* worlds;
+    mat4 parent;
+} transform_bench;
+
+static void transform_range(u64 begin, u64 end, void* user_data) {
+    transform_bench* bench = user_data;
+    for (u64 i = begin; i < end; ++i) {
+        bench->worlds[i] = mat4_mul(bench->locals[i], bench->parent);
+    }
+}
+
+static f64 time_transforms(transform_bench* bench) {
+    clock timer;
+    clock_start(&timer);
+    for (u32 i = 0; i < BENCH_REPEATS; ++i) {
+        parallel_for(BENCH_MATRICES, 0, transform_range, bench);
+    }
+    clock_update(&timer);
+    return timer.elapsed / BENCH_REPEATS;
+}
+
+u8 parallel_for_benchmark() {
+    transform_bench bench;
+    bench.locals =
+        memory_allocate(sizeof(mat4) * BENCH_MATRICES, MEMORY_TAG_TRANSFORM);
+    bench.worlds =
+        memory_allocate(sizeof(mat4) * BENCH_MATRICES, MEMORY_TAG_TRANSFORM);
+    for (u32 i = 0; i < BENCH_MATRICES; ++i) {
+        bench.locals[i] = mat4_translation(vec3_create((f32)i, 1.0f, 2.0f));
+    }
+    bench.parent = mat4_euler_x(0.5f);
+
+    // Without a job system, for the baseline.
+    f64 single = time_transforms(&bench);
+    OKO_INFO(
+        "mat4 transforms, 1 thread: %.3f ms for %u.",
+        single * 1000.0,
+        BENCH_MATRICES
+    );
+    for (u32 workers = 1; workers <= 8; workers *= 2) {
+        void* state;
+        expect_to_be_true(start_system(workers, &state));
+        f64 elapsed = time_transforms(&bench);
+        OKO_INFO(
+            "mat4 transforms, %u threads: %.3f ms, %.2fx.",
+            workers + 1,
+            elapsed * 1000.0,
+            single / elapsed
+        );
+        stop_system(state);
+    }
+
+    mat4 expected = mat4_mul(bench.locals[BENCH_MATRICES - 1], bench.parent);
+    for (u32 i = 0; i < 16; ++i) {
+        expect_float_to_be(
+            expected.data[i], bench.worlds[BENCH_MATRICES - 1].data[i]
+        );
+    }
+
+    memory_free(
+        bench.locals, sizeof(mat4) * BENCH_MATRICES, MEMORY_TAG_TRANSFORM
+    );
+    memory_free(
+        bench.worlds, sizeof(mat4) * BENCH_MATRICES, MEMORY_TAG_TRANSFORM
+    );
+    return true;
+}
+
+void parallel_for_register_tests() {
+    test_manager_register_test(
+        parallel_for_should_visit_every_item_once,
+        "Parallel for should visit every item once"
+    );
+    test_manager_register_test(
+        parallel_for_should_run_small_loops_inline,
+        "Parallel for should run small loops inline"
+    );
+    test_manager_register_test(
+        parallel_for_darray_should_pass_elements,
+        "Parallel for darray should pass elements"
+    );
+    test_manager_register_test(
+        parallel_for_benchmark, "Parallel for mat4 transform benchmark"
+    );
+}
\ No newline at end of file